@@ -24,5 +24,17 @@ double NonNegL2(size_t m, size_t n);
 template <typename T>
 double Svm(size_t m, size_t n);
 
+template <typename T>
+double RhoSweep(size_t m, size_t n);
+
+template <typename T>
+double ProxThroughput(size_t size);
+
+template <typename T>
+double ProxWarmStart(size_t m, size_t n);
+
+template <typename T>
+double StaticObjective(size_t m, size_t n);
+
 #endif  // EXAMPLES_H_
 
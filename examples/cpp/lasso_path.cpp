@@ -75,24 +75,19 @@ double LassoPath(size_t m, size_t n) {
   // Set up pogs datastructure.
   pogs::MatrixDense<T> A_('r', m, n, A.data());
   pogs::PogsDirect<T, pogs::MatrixDense<T> > pogs_data(A_);
-  std::vector<FunctionObj<T> > f;
-  std::vector<FunctionObj<T> > g;
-  f.reserve(m);
-  g.reserve(n);
 
-  for (unsigned int i = 0; i < m; ++i)
-    f.emplace_back(kSquare, static_cast<T>(1), b[i]);
+  // Only b varies over f and only c = lambda changes along the path, so the
+  // other parameters are stored once.
+  FunctionVector<T> f(m, FunctionObj<T>(kSquare));
+  FunctionVector<T> g(n, FunctionObj<T>(kAbs));
+  f.b = b;
 
-  for (unsigned int i = 0; i < n; ++i)
-    g.emplace_back(kAbs);
-  
   double t = timer<double>();
   for (unsigned int i = 0; i < nlambda; ++i) {
     T lambda = std::exp((std::log(lambda_max) * (nlambda - 1 - i) +
         static_cast<T>(1e-2) * std::log(lambda_max) * i) / (nlambda - 1));
 
-    for (unsigned int i = 0; i < n; ++i)
-      g[i].c = lambda;
+    g.c.assign(1, lambda);
 
     pogs_data.Solve(f, g);
 
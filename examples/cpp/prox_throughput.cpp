@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "prox_lib.h"
+#include "timer.h"
+
+namespace {
+
+const int kReps = 20;
+
+// Elements per second of kReps evaluations of the prox of f_obj, with the
+// per-element switch (runs == 0) or with dispatch by runs.
+template <typename T>
+double Throughput(const std::vector<FunctionObj<T> > &f_obj,
+                  const std::vector<FunctionRun> *runs, const T *x_in,
+                  T *x_out) {
+  const T kRho = static_cast<T>(1.3);
+  double t = timer<double>();
+  for (int i = 0; i < kReps; ++i) {
+    if (runs)
+      ProxEval(f_obj, *runs, kRho, x_in, x_out);
+    else
+      ProxEval(f_obj, kRho, x_in, x_out);
+  }
+  t = timer<double>() - t;
+  return static_cast<double>(kReps) * static_cast<double>(f_obj.size()) / t;
+}
+
+// Same with dispatch by runs, for f_obj stored as a FunctionVector.
+template <typename T>
+double Throughput(const FunctionVector<T> &f_obj,
+                  const std::vector<FunctionRun> &runs, const T *x_in,
+                  T *x_out, ProxAccuracy accuracy = kProxAccurate) {
+  const T kRho = static_cast<T>(1.3);
+  double t = timer<double>();
+  for (int i = 0; i < kReps; ++i)
+    ProxEval(f_obj, runs, kRho, x_in, x_out, accuracy);
+  t = timer<double>() - t;
+  return static_cast<double>(kReps) * static_cast<double>(f_obj.size()) / t;
+}
+
+}  // namespace
+
+// Throughput of the elementwise prox step for size elements of one function
+// each, and for a mix of closed-form functions in runs of random length,
+// with random parameters. Compares the per-element switch of ProxEval to
+// dispatching runs of the same function to specialized loops, which
+// vectorize for the closed-form functions when built with
+// -fno-trapping-math (as in the Makefile), and to the same with f stored
+// as a FunctionVector, which reads a parameter that is equal for all
+// elements once. The last case is f of the lasso, kSquare with only b
+// varying. The results of all three are identical. Returns the time of one
+// pass with run dispatch over the mixed vector.
+//
+// A second table compares kProxAccurate and kProxFast for the functions
+// whose prox is evaluated by Newton's method, with the largest difference
+// relative to max(1, |x|). In double precision the kProxFast loops only
+// vectorize with AVX2 or AVX-512 (e.g. IFLAGS=-march=native), without
+// which they are slower than kProxAccurate.
+template <typename T>
+double ProxThroughput(size_t size) {
+  std::default_random_engine generator;
+  std::uniform_real_distribution<T> u_dist(static_cast<T>(0.5),
+                                           static_cast<T>(2));
+  std::normal_distribution<T> n_dist(static_cast<T>(0), static_cast<T>(1));
+  std::uniform_int_distribution<size_t> len_dist(1, 4 * kMinRunLength);
+
+  const Function kMixed[] = { kAbs, kSquare, kHuber, kIndGe0, kIndBox01,
+                              kMaxPos0, kIdentity };
+  const size_t kNumMixed = sizeof(kMixed) / sizeof(kMixed[0]);
+  const Function kCases[] = { kAbs, kSquare, kHuber, kIndGe0, kIndLe0,
+                              kIndBox01, kMaxPos0, kMaxNeg0, kIdentity, kZero,
+                              kLogistic };
+  const char *kNames[] = { "kAbs", "kSquare", "kHuber", "kIndGe0", "kIndLe0",
+                           "kIndBox01", "kMaxPos0", "kMaxNeg0", "kIdentity",
+                           "kZero", "kLogistic", "mixed", "lasso f" };
+  const size_t kNumCases = sizeof(kCases) / sizeof(kCases[0]);
+
+  std::vector<T> x_in(size), x_switch(size), x_runs(size), x_vec(size);
+  for (size_t i = 0; i < size; ++i)
+    x_in[i] = static_cast<T>(3) * n_dist(generator);
+
+  printf("%-10s %8s %12s %12s %12s %8s\n", "function", "runs",
+      "switch (/s)", "runs (/s)", "vector (/s)", "same");
+  double t = 0.;
+  for (size_t k = 0; k <= kNumCases + 1; ++k) {
+    std::vector<FunctionObj<T> > f_obj;
+    f_obj.reserve(size);
+    while (k > kNumCases && f_obj.size() < size)
+      f_obj.emplace_back(kSquare, static_cast<T>(1), n_dist(generator));
+    while (f_obj.size() < size) {
+      size_t len = k < kNumCases ? size : len_dist(generator);
+      Function h = k < kNumCases ? kCases[k] :
+          kMixed[len_dist(generator) % kNumMixed];
+      for (size_t l = 0; l < len && f_obj.size() < size; ++l)
+        f_obj.emplace_back(h, u_dist(generator), n_dist(generator),
+            u_dist(generator), n_dist(generator),
+            u_dist(generator) - static_cast<T>(0.5));
+    }
+    std::vector<FunctionRun> runs, vec_runs;
+    FunctionRuns(f_obj, &runs);
+    FunctionVector<T> f_vec(f_obj);
+    FunctionRuns(f_vec, &vec_runs);
+
+    double r_switch = Throughput(f_obj, 0, x_in.data(), x_switch.data());
+    double r_runs = Throughput(f_obj, &runs, x_in.data(), x_runs.data());
+    double r_vec = Throughput(f_vec, vec_runs, x_in.data(), x_vec.data());
+    bool same = std::equal(x_switch.begin(), x_switch.end(), x_runs.begin()) &&
+        std::equal(x_switch.begin(), x_switch.end(), x_vec.begin());
+    printf("%-10s %8u %12.3e %12.3e %12.3e %8s\n", kNames[k],
+        static_cast<unsigned int>(runs.size()), r_switch, r_runs, r_vec,
+        same ? "yes" : "no");
+    if (k == kNumCases)
+      t = static_cast<double>(size) / r_runs;
+  }
+
+  const Function kNewton[] = { kExp, kLogistic, kNegEntr };
+  const char *kNewtonNames[] = { "kExp", "kLogistic", "kNegEntr" };
+  const size_t kNumNewton = sizeof(kNewton) / sizeof(kNewton[0]);
+  printf("\n%-10s %13s %12s %12s\n", "function", "accurate (/s)",
+      "fast (/s)", "max diff");
+  for (size_t k = 0; k < kNumNewton; ++k) {
+    std::vector<FunctionObj<T> > f_obj;
+    f_obj.reserve(size);
+    for (size_t i = 0; i < size; ++i)
+      f_obj.emplace_back(kNewton[k], u_dist(generator), n_dist(generator),
+          u_dist(generator), n_dist(generator),
+          u_dist(generator) - static_cast<T>(0.5));
+    FunctionVector<T> f_vec(f_obj);
+    std::vector<FunctionRun> runs;
+    FunctionRuns(f_vec, &runs);
+
+    double r_acc = Throughput(f_vec, runs, x_in.data(), x_runs.data());
+    double r_fast = Throughput(f_vec, runs, x_in.data(), x_vec.data(),
+        kProxFast);
+    double diff = 0.;
+    for (size_t i = 0; i < size; ++i) {
+      double x = static_cast<double>(x_runs[i]);
+      diff = std::max(diff, std::fabs(x - static_cast<double>(x_vec[i])) /
+          std::max(1., std::fabs(x)));
+    }
+    printf("%-10s %13.3e %12.3e %12.3e\n", kNewtonNames[k], r_acc, r_fast,
+        diff);
+  }
+  return t;
+}
+
+template double ProxThroughput<double>(size_t size);
+template double ProxThroughput<float>(size_t size);
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "matrix/matrix_dense.h"
+#include "projector/projector_direct.h"
+#include "projector/projector_eig.h"
+#include "timer.h"
+
+using namespace pogs;
+
+// Projects onto {(x, y) | y = Ax} for a varying number of distinct values of
+// s, as an adaptive rho schedule would. ProjectorDirect refactors whenever s
+// changes, ProjectorEig decomposes A^T A once. Prints the time taken by both
+// (including Init) for each number of changes and returns the total time
+// spent in ProjectorEig.
+template <typename T>
+double RhoSweep(size_t m, size_t n) {
+  const unsigned int kProjPerChange = 10;
+  std::vector<T> A(m * n);
+  std::vector<T> x0(n), y0(m), x_dir(n), y_dir(m), x_eig(n), y_eig(m);
+
+  std::default_random_engine generator;
+  std::normal_distribution<T> n_dist(static_cast<T>(0),
+                                     static_cast<T>(1));
+  for (unsigned int i = 0; i < m * n; ++i)
+    A[i] = n_dist(generator);
+  for (unsigned int i = 0; i < n; ++i)
+    x0[i] = n_dist(generator);
+  for (unsigned int i = 0; i < m; ++i)
+    y0[i] = n_dist(generator);
+
+  MatrixDense<T> A_('r', m, n, A.data());
+  A_.Init();
+
+  printf("%8s %12s %12s %10s\n", "changes", "direct (s)", "eig (s)",
+      "max diff");
+  double t_eig_total = 0.;
+  unsigned int changes[] = {1, 10, 100};
+  for (unsigned int c : changes) {
+    double t = timer<double>();
+    ProjectorDirect<T, MatrixDense<T> > P_dir(A_);
+    P_dir.Init();
+    for (unsigned int k = 0; k < c; ++k) {
+      T s = static_cast<T>(std::pow(10., -2. + 4. * k / c));
+      for (unsigned int i = 0; i < kProjPerChange; ++i)
+        P_dir.Project(x0.data(), y0.data(), s, x_dir.data(), y_dir.data(),
+            static_cast<T>(0));
+    }
+    double t_dir = timer<double>() - t;
+
+    t = timer<double>();
+    ProjectorEig<T, MatrixDense<T> > P_eig(A_);
+    P_eig.Init();
+    for (unsigned int k = 0; k < c; ++k) {
+      T s = static_cast<T>(std::pow(10., -2. + 4. * k / c));
+      for (unsigned int i = 0; i < kProjPerChange; ++i)
+        P_eig.Project(x0.data(), y0.data(), s, x_eig.data(), y_eig.data(),
+            static_cast<T>(0));
+    }
+    double t_eig = timer<double>() - t;
+    t_eig_total += t_eig;
+
+    T max_diff = 0;
+    for (unsigned int i = 0; i < n; ++i)
+      max_diff = std::max(max_diff, std::abs(x_dir[i] - x_eig[i]));
+    for (unsigned int i = 0; i < m; ++i)
+      max_diff = std::max(max_diff, std::abs(y_dir[i] - y_eig[i]));
+    printf("%8u %12.3e %12.3e %10.3e\n", c, t_dir, t_eig,
+        static_cast<double>(max_diff));
+  }
+
+  return t_eig_total;
+}
+
+template double RhoSweep<double>(size_t m, size_t n);
+template double RhoSweep<float>(size_t m, size_t n);
+
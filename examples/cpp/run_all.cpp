@@ -34,6 +34,26 @@ int main() {
   t = Svm<real_t>(1000, 200);
   printf("Solver Time: %e sec\n", t);
 
+#ifndef __CUDA
+  printf("\nProjection Across Rho Changes.\n");
+  t = RhoSweep<real_t>(1000, 200);
+  printf("Projector Time: %e sec\n", t);
+#endif
+
+  printf("\nProx Throughput, Per-Element Switch vs. Run Dispatch.\n");
+  t = ProxThroughput<real_t>(1000000);
+  printf("Mixed Prox Time: %e sec\n", t);
+
+#ifndef __CUDA
+  printf("\nLogistic Regression With Warm-Started Prox.\n");
+  t = ProxWarmStart<real_t>(1000, 100);
+  printf("Solver Time: %e sec\n", t);
+
+  printf("\nLasso With Compile-Time Specialized Objectives.\n");
+  t = StaticObjective<real_t>(1000, 200);
+  printf("Solver Time: %e sec\n", t);
+#endif
+
   return 0;
 }
 
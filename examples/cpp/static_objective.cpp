@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "matrix/matrix_dense.h"
+#include "pogs.h"
+#include "timer.h"
+
+namespace {
+
+const int kReps = 20;
+const size_t kProxSize = 1000000;
+
+// (1/2) (y_i - b_i)^2, with a, c, d and e fixed.
+template <typename T>
+using SquareLoss = FunctionStatic<T, kSquare,
+                                  kParamA | kParamC | kParamD | kParamE>;
+
+// lambda |x_j|, with a, b, d and e fixed.
+template <typename T>
+using AbsReg = FunctionStatic<T, kAbs,
+                              kParamA | kParamB | kParamD | kParamE>;
+
+// Times kReps prox evaluations of f, dispatched by runs as a FunctionVector
+// and specialized as a FunctionStatic, and prints one row per function.
+template <typename T, typename F>
+void ProxReport(const char *name, const F &f, const std::vector<T> &v) {
+  std::vector<FunctionRun> runs;
+  FunctionRuns(static_cast<const FunctionVector<T>&>(f), &runs);
+  std::vector<T> x(v.size()), x_static(v.size());
+  T rho = static_cast<T>(1.5);
+
+  double t_runs = timer<double>();
+  for (int i = 0; i < kReps; ++i)
+    ProxEval(static_cast<const FunctionVector<T>&>(f), runs, rho, v.data(),
+        x.data());
+  t_runs = (timer<double>() - t_runs) / kReps;
+
+  double t_static = timer<double>();
+  for (int i = 0; i < kReps; ++i)
+    ProxEval(f, rho, v.data(), x_static.data());
+  t_static = (timer<double>() - t_static) / kReps;
+
+  double diff = 0.;
+  for (size_t i = 0; i < v.size(); ++i)
+    diff = std::max(diff, static_cast<double>(std::fabs(x[i] - x_static[i])));
+  printf("%-9s %12.3e %12.3e %10.2f %12.3e\n", name, t_runs, t_static,
+      t_runs / t_static, diff);
+}
+
+// Solves the lasso with f and g as FunctionVector or FunctionStatic,
+// prints one row and returns the solution x.
+template <typename T>
+std::vector<T> SolveReport(const char *name, bool specialized,
+                           const pogs::MatrixDense<T> &A,
+                           const SquareLoss<T> &f, const AbsReg<T> &g,
+                           double *t) {
+  pogs::PogsDirect<T, pogs::MatrixDense<T> > pogs_data(A);
+  pogs_data.SetVerbose(0);
+  *t = timer<double>();
+  pogs::PogsStatus status = specialized ? pogs_data.Solve(f, g) :
+      pogs_data.Solve(static_cast<const FunctionVector<T>&>(f),
+          static_cast<const FunctionVector<T>&>(g));
+  *t = timer<double>() - *t;
+
+  printf("%-9s %-16s %6u %10.3e %12.5e\n", name,
+      pogs::PogsStatusString(status).c_str(), pogs_data.GetFinalIter(), *t,
+      pogs_data.GetOptval());
+  return std::vector<T>(pogs_data.GetX(), pogs_data.GetX() + A.Cols());
+}
+
+}  // namespace
+
+// Lasso
+//   minimize    (1/2) ||Ax - b||_2^2 + \lambda ||x||_1,
+// with f and g given as FunctionStatic, whose function and fixed
+// parameters are known at compile time, and as FunctionVector, whose prox
+// is dispatched by runs at run time. Prints the time of the prox of each
+// on kProxSize elements and of the solve, and the largest difference
+// between the results, which is at rounding level since the specialized
+// loops drop the terms of fixed parameters. Returns the solve time with
+// FunctionStatic.
+template <typename T>
+double StaticObjective(size_t m, size_t n) {
+  std::vector<T> A(m * n);
+  std::vector<T> b(m);
+
+  std::default_random_engine generator;
+  std::uniform_real_distribution<T> u_dist(static_cast<T>(0),
+                                           static_cast<T>(1));
+  std::normal_distribution<T> n_dist(static_cast<T>(0),
+                                     static_cast<T>(1));
+
+  for (size_t i = 0; i < m * n; ++i)
+    A[i] = n_dist(generator);
+
+  std::vector<T> x_true(n);
+  for (size_t j = 0; j < n; ++j)
+    x_true[j] = u_dist(generator) < static_cast<T>(0.8)
+        ? static_cast<T>(0) : n_dist(generator) / static_cast<T>(std::sqrt(n));
+
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < n; ++j)
+      b[i] += A[i * n + j] * x_true[j];
+    b[i] += static_cast<T>(0.5) * n_dist(generator);
+  }
+
+  T lambda_max = static_cast<T>(0);
+  for (size_t j = 0; j < n; ++j) {
+    T u = 0;
+    for (size_t i = 0; i < m; ++i)
+      u += A[i * n + j] * b[i];
+    lambda_max = std::max(lambda_max, std::abs(u));
+  }
+
+  SquareLoss<T> f(m);
+  f.b = b;
+  AbsReg<T> g(n, FunctionObj<T>(kAbs, static_cast<T>(1), static_cast<T>(0),
+      static_cast<T>(0.2) * lambda_max));
+
+  // Prox throughput, with b drawn for kProxSize elements.
+  SquareLoss<T> f_prox(kProxSize);
+  AbsReg<T> g_prox(kProxSize, g[0]);
+  std::vector<T> v(kProxSize);
+  f_prox.b.resize(kProxSize);
+  for (size_t i = 0; i < kProxSize; ++i) {
+    v[i] = n_dist(generator);
+    f_prox.b[i] = n_dist(generator);
+  }
+  printf("%-9s %12s %12s %10s %12s\n", "function", "runs (s)", "static (s)",
+      "speedup", "max diff");
+  ProxReport("kSquare", f_prox, v);
+  ProxReport("kAbs", g_prox, v);
+
+  pogs::MatrixDense<T> A_('r', m, n, A.data());
+  printf("\n%-9s %-16s %6s %10s %12s\n", "objective", "status", "iter",
+      "solve (s)", "optval");
+  double t_vector, t_static;
+  std::vector<T> x = SolveReport("vector", false, A_, f, g, &t_vector);
+  std::vector<T> x_static = SolveReport("static", true, A_, f, g, &t_static);
+
+  double diff = 0., nrm = 0.;
+  for (size_t j = 0; j < n; ++j) {
+    diff = std::max(diff, static_cast<double>(std::fabs(x[j] - x_static[j])));
+    nrm = std::max(nrm, static_cast<double>(std::fabs(x[j])));
+  }
+  printf("max |x - x_static| / max |x| = %.3e\n", nrm > 0. ? diff / nrm : diff);
+
+  return t_static;
+}
+
+template double StaticObjective<double>(size_t m, size_t n);
+template double StaticObjective<float>(size_t m, size_t n);
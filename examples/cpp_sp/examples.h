@@ -15,6 +15,21 @@ double LassoPath(int m, int n, int nnz);
 template <typename T>
 double LpEq(int m, int n, int nnz);
 
+template <typename T>
+double KrylovCompare(int m, int n, int nnz);
+
+template <typename T>
+double SparseStorage(int m, int n, int nnz);
+
+template <typename T>
+double SellSpmv(int m, int n, int nnz);
+
+template <typename T>
+double SkewedSpmv(int m, int n, int nnz);
+
+template <typename T>
+double SparseReorder(int m, int n, int nnz);
+
 // template <typename T>
 // double LpIneq(int m, int n, int nnz);
 // 
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "matrix/matrix_sparse.h"
+#include "mat_gen.h"
+#include "pogs.h"
+#include "timer.h"
+
+namespace {
+
+// Solves the problem with projector P and prints one row of statistics.
+// Returns the solver time.
+template <typename T, typename P>
+double SolveAndReport(const char *problem, const char *name,
+                      const pogs::MatrixSparse<T> &A,
+                      const std::vector<FunctionObj<T> > &f,
+                      const std::vector<FunctionObj<T> > &g) {
+  pogs::Pogs<T, pogs::MatrixSparse<T>, P> pogs_data(A);
+  pogs_data.SetVerbose(0);
+
+  double t = timer<double>();
+  pogs::PogsStatus status = pogs_data.Solve(f, g);
+  t = timer<double>() - t;
+
+  pogs::KrylovStats stats = pogs_data.GetKrylovStats();
+  unsigned int iter = pogs_data.GetFinalIter();
+  printf("%-8s %-6s %-16s %6u %8u %8u %9.1f %10.3e\n", problem, name,
+      pogs::PogsStatusString(status).c_str(), iter, stats.iters, stats.matvecs,
+      static_cast<double>(stats.matvecs) / std::max(iter, 1u), t);
+  return t;
+}
+
+}  // namespace
+
+// Total number of matvecs spent in the projection by ProjectorCgls and
+// ProjectorLsmr over one Pogs solve of a sparse lasso problem
+//   minimize    (1/2) ||Ax - b||_2^2 + \lambda ||x||_1,
+// first with A as in the Lasso example and then with column j replaced by
+// a_j + 0.99 a_{j+1}. The correlated columns make A'A ill-conditioned in a
+// way that equilibration cannot undo. Returns the total time spent in the
+// LSMR solves.
+template <typename T>
+double KrylovCompare(int m, int n, int nnz) {
+  const T kCorr = static_cast<T>(0.99);
+  std::vector<T> val(nnz);
+  std::vector<int> col_ind(nnz);
+  std::vector<int> row_ptr(m + 1);
+  std::vector<T> b(m);
+
+  std::default_random_engine generator;
+  std::normal_distribution<T> n_dist(static_cast<T>(0),
+                                     static_cast<T>(1));
+
+  std::vector<std::tuple<int, int, T>> entries;
+  nnz = MatGenApprox(m, n, nnz, val.data(), row_ptr.data(), col_ind.data(),
+      static_cast<T>(-1), static_cast<T>(1), entries);
+
+  for (int i = 0; i < m; ++i)
+    b[i] = static_cast<T>(4) * n_dist(generator);
+
+  std::vector<FunctionObj<T> > f;
+  std::vector<FunctionObj<T> > g;
+  f.reserve(m);
+  for (int i = 0; i < m; ++i)
+    f.emplace_back(kSquare, static_cast<T>(1), b[i]);
+  g.reserve(n);
+  for (int i = 0; i < n; ++i)
+    g.emplace_back(kAbs, static_cast<T>(0.5));
+
+  // Entry (i, j) of A also contributes kCorr * a_ij to column j - 1. The
+  // columns of a row are sorted, so duplicates are adjacent.
+  std::vector<T> val_c;
+  std::vector<int> col_ind_c, row_ptr_c(1, 0);
+  auto add = [&](int j, T a_ij) {
+    if (static_cast<int>(col_ind_c.size()) > row_ptr_c.back() &&
+        col_ind_c.back() == j) {
+      val_c.back() += a_ij;
+    } else {
+      col_ind_c.push_back(j);
+      val_c.push_back(a_ij);
+    }
+  };
+  for (int i = 0; i < m; ++i) {
+    for (int l = row_ptr[i]; l < row_ptr[i + 1]; ++l) {
+      if (col_ind[l] > 0)
+        add(col_ind[l] - 1, kCorr * val[l]);
+      add(col_ind[l], val[l]);
+    }
+    row_ptr_c.push_back(static_cast<int>(col_ind_c.size()));
+  }
+  int nnz_c = row_ptr_c[m];
+
+  typedef pogs::MatrixSparse<T> M;
+  M A(  'r', m, n, nnz, val.data(), row_ptr.data(), col_ind.data());
+  M A_c('r', m, n, nnz_c, val_c.data(), row_ptr_c.data(), col_ind_c.data());
+
+  printf("%-8s %-6s %-16s %6s %8s %8s %9s %10s\n", "problem", "proj",
+      "status", "iter", "krylov", "matvecs", "mv/iter", "time (s)");
+  double t_lsmr = 0.;
+  SolveAndReport<T, pogs::ProjectorCgls<T, M> >("lasso", "cgls", A, f, g);
+  t_lsmr += SolveAndReport<T, pogs::ProjectorLsmr<T, M> >("lasso", "lsmr", A,
+      f, g);
+  SolveAndReport<T, pogs::ProjectorCgls<T, M> >("corr", "cgls", A_c, f, g);
+  t_lsmr += SolveAndReport<T, pogs::ProjectorLsmr<T, M> >("corr", "lsmr", A_c,
+      f, g);
+
+  return t_lsmr;
+}
+
+template double KrylovCompare<double>(int m, int n, int nnz);
+template double KrylovCompare<float>(int m, int n, int nnz);
+
@@ -77,5 +77,43 @@ int MatGenApprox(int m, int n, int nnz, T *val, int *rptr, int *cind, T lb,
   return index;
 }
 
+// Generates an m x n matrix with at most nnz entries, whose row lengths
+// follow a power law: row i has about c (i + 1)^-alpha entries, with c such
+// that the lengths sum to nnz, and at least one. The long rows come first,
+// as in data sorted by frequency, which is the worst case for splitting
+// rows evenly among threads. Returns the number of entries.
+template <typename T>
+int MatGenPowerLaw(int m, int n, int nnz, double alpha, T *val, int *rptr,
+                   int *cind, T lb, T ub) {
+  std::vector<double> weight(m);
+  double sum = 0.;
+  for (int i = 0; i < m; ++i) {
+    weight[i] = std::pow(static_cast<double>(i + 1), -alpha);
+    sum += weight[i];
+  }
+
+  // Distinct columns of a row are the first entries of a partial shuffle.
+  std::vector<int> cols(n);
+  for (int j = 0; j < n; ++j)
+    cols[j] = j;
+
+  int num = 0;
+  for (int i = 0; i < m; ++i) {
+    rptr[i] = num;
+    int len = static_cast<int>(std::round(nnz * weight[i] / sum));
+    len = std::min(std::max(len, 1), std::min(n, nnz - num));
+    for (int k = 0; k < len; ++k)
+      std::swap(cols[k], cols[k + rand(0, n - k)]);
+    std::sort(cols.begin(), cols.begin() + len);
+    for (int k = 0; k < len; ++k) {
+      cind[num] = cols[k];
+      val[num] = rand(lb, ub);
+      ++num;
+    }
+  }
+  rptr[m] = num;
+  return num;
+}
+
 #endif  // MAT_GEN_H_
 
@@ -34,6 +34,28 @@ int main() {
 //   t = Svm<real_t>(1000000, 2000);
 //   printf("Solver Time: %e sec\n", t);
 
+#ifndef __CUDA
+  printf("\nProjection Matvecs, CGLS vs. LSMR.\n");
+  t = KrylovCompare<real_t>(2000, 500, 20000);
+  printf("LSMR Time: %e sec\n", t);
+
+  printf("\nSparse Storage, Dual vs. Single Copy.\n");
+  t = SparseStorage<real_t>(10000, 2000, 200000);
+  printf("Single Copy Solver Time: %e sec\n", t);
+
+  printf("\nSparse Matrix-Vector Product, CSR vs. SELL-C-sigma.\n");
+  t = SellSpmv<real_t>(20000, 5000, 400000);
+  printf("SELL Ax Time: %e sec\n", t);
+
+  printf("\nSparse Matrix-Vector Product, Power-Law Row Lengths.\n");
+  t = SkewedSpmv<real_t>(100000, 20000, 1000000);
+  printf("Ax Time: %e sec\n", t);
+
+  printf("\nSparse Matrix-Vector Product, Reverse Cuthill-McKee Ordering.\n");
+  t = SparseReorder<real_t>(1000000, 500000, 4000000);
+  printf("Reordered Ax Time: %e sec\n", t);
+#endif
+
   return 0;
 }
 
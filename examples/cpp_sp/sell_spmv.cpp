@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "matrix/matrix_sparse.h"
+#include "mat_gen.h"
+#include "timer.h"
+
+namespace {
+
+const int kReps = 50;
+
+// Average time of kReps products y := op(A) x.
+template <typename T>
+double TimeMul(const pogs::MatrixSparse<T> &A, char trans, const T *x,
+               T *y) {
+  double t = timer<double>();
+  for (int i = 0; i < kReps; ++i)
+    A.Mul(trans, static_cast<T>(1), x, static_cast<T>(0), y);
+  return (timer<double>() - t) / kReps;
+}
+
+template <typename T>
+double MaxRelDiff(const std::vector<T> &a, const std::vector<T> &b) {
+  double diff = 0., nrm = 0.;
+  for (size_t i = 0; i < a.size(); ++i) {
+    diff = std::max(diff, static_cast<double>(std::fabs(a[i] - b[i])));
+    nrm = std::max(nrm, static_cast<double>(std::fabs(a[i])));
+  }
+  return nrm > 0. ? diff / nrm : diff;
+}
+
+}  // namespace
+
+// Products with A and A^T for a random sparse A stored in CSR format and
+// in SELL-C-sigma format, after equilibration as in a Pogs solve. Prints
+// the time of each and the largest difference between the results relative
+// to the largest entry. The SELL kernels use SIMD gathers if the library is
+// built with AVX2, e.g. IFLAGS=-march=native, and otherwise accumulate in
+// the same order as the CSR loop. Returns the time of one SELL product
+// with A.
+template <typename T>
+double SellSpmv(int m, int n, int nnz) {
+  std::vector<T> val(nnz);
+  std::vector<int> col_ind(nnz);
+  std::vector<int> row_ptr(m + 1);
+
+  std::default_random_engine generator;
+  std::normal_distribution<T> n_dist(static_cast<T>(0),
+                                     static_cast<T>(1));
+
+  std::vector<std::tuple<int, int, T>> entries;
+  nnz = MatGenApprox(m, n, nnz, val.data(), row_ptr.data(), col_ind.data(),
+      static_cast<T>(-1), static_cast<T>(1), entries);
+
+  pogs::MatrixSparse<T> A_csr('r', m, n, nnz, val.data(), row_ptr.data(),
+      col_ind.data());
+  pogs::MatrixSparse<T> A_sell('r', m, n, nnz, val.data(), row_ptr.data(),
+      col_ind.data(), true, true);
+  std::vector<T> d(m), e(n);
+  A_csr.Init();
+  A_csr.Equil(d.data(), e.data());
+  A_sell.Init();
+  A_sell.Equil(d.data(), e.data());
+
+  std::vector<T> x(n), y(m);
+  for (int j = 0; j < n; ++j)
+    x[j] = n_dist(generator);
+  for (int i = 0; i < m; ++i)
+    y[i] = n_dist(generator);
+
+  std::vector<T> ax_csr(m), ax_sell(m), aty_csr(n), aty_sell(n);
+  double t_n_csr = TimeMul(A_csr, 'n', x.data(), ax_csr.data());
+  double t_n_sell = TimeMul(A_sell, 'n', x.data(), ax_sell.data());
+  double t_t_csr = TimeMul(A_csr, 't', y.data(), aty_csr.data());
+  double t_t_sell = TimeMul(A_sell, 't', y.data(), aty_sell.data());
+
+  printf("%-4s %10s %10s %10s\n", "op", "csr (s)", "sell (s)", "rel diff");
+  printf("%-4s %10.3e %10.3e %10.3e\n", "Ax", t_n_csr, t_n_sell,
+      MaxRelDiff(ax_csr, ax_sell));
+  printf("%-4s %10.3e %10.3e %10.3e\n", "A'y", t_t_csr, t_t_sell,
+      MaxRelDiff(aty_csr, aty_sell));
+
+  return t_n_sell;
+}
+
+template double SellSpmv<double>(int m, int n, int nnz);
+template double SellSpmv<float>(int m, int n, int nnz);
+
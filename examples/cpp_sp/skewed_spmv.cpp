@@ -0,0 +1,104 @@
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "matrix/matrix_sparse.h"
+#include "mat_gen.h"
+#include "timer.h"
+
+namespace {
+
+const int kReps = 50;
+
+// Largest number of entries given to one of p threads, relative to nnz / p,
+// if the rows are split evenly by count (as by omp parallel for) or into
+// ranges of equal nnz (as by MatrixSparse).
+double Imbalance(int m, const int *rptr, int p, bool balanced) {
+  double nnz = rptr[m];
+  int max_nnz = 0, begin = 0;
+  for (int t = 0; t < p; ++t) {
+    int end = t + 1 == p ? m : balanced ?
+        static_cast<int>(std::lower_bound(rptr, rptr + m + 1,
+            static_cast<int>(nnz * (t + 1) / p)) - rptr) :
+        std::min(m, (t + 1) * ((m + p - 1) / p));
+    max_nnz = std::max(max_nnz, rptr[end] - rptr[begin]);
+    begin = end;
+  }
+  return max_nnz / (nnz / p);
+}
+
+}  // namespace
+
+// Thread scaling of products with A and A^T for an A whose row lengths
+// follow a power law (Zipf, alpha = 1), see MatGenPowerLaw. MatrixSparse
+// splits the rows among threads into ranges of equal nnz. The columns
+// "even" and "bal" give the load of the busiest thread relative to the
+// average for an even split by row count and for the balanced split. The
+// library must be built with IFLAGS=-fopenmp for the times to scale.
+// Returns the time of one product with A using all threads.
+template <typename T>
+double SkewedSpmv(int m, int n, int nnz) {
+  std::vector<T> val(nnz);
+  std::vector<int> col_ind(nnz);
+  std::vector<int> row_ptr(m + 1);
+  nnz = MatGenPowerLaw(m, n, nnz, 1., val.data(), row_ptr.data(),
+      col_ind.data(), static_cast<T>(-1), static_cast<T>(1));
+
+  std::default_random_engine generator;
+  std::normal_distribution<T> n_dist(static_cast<T>(0),
+                                     static_cast<T>(1));
+  std::vector<T> x(n), y(m);
+  for (int j = 0; j < n; ++j)
+    x[j] = n_dist(generator);
+  for (int i = 0; i < m; ++i)
+    y[i] = n_dist(generator);
+
+  int max_threads = 1;
+#ifdef _OPENMP
+  max_threads = omp_get_max_threads();
+#endif
+
+  printf("nnz %d, longest row %d\n", nnz, row_ptr[1] - row_ptr[0]);
+  printf("%-7s %6s %6s %10s %10s\n", "threads", "even", "bal", "Ax (s)",
+      "A'y (s)");
+  double t_n = 0.;
+  for (int p = 1; ; p = std::min(2 * p, max_threads)) {
+#ifdef _OPENMP
+    omp_set_num_threads(p);
+#endif
+    // The partition is computed in Init for the current number of threads.
+    pogs::MatrixSparse<T> A('r', m, n, nnz, val.data(), row_ptr.data(),
+        col_ind.data());
+    A.Init();
+
+    t_n = timer<double>();
+    for (int i = 0; i < kReps; ++i)
+      A.Mul('n', static_cast<T>(1), x.data(), static_cast<T>(0), y.data());
+    t_n = (timer<double>() - t_n) / kReps;
+
+    double t_t = timer<double>();
+    for (int i = 0; i < kReps; ++i)
+      A.Mul('t', static_cast<T>(1), y.data(), static_cast<T>(0), x.data());
+    t_t = (timer<double>() - t_t) / kReps;
+
+    printf("%-7d %6.2f %6.2f %10.3e %10.3e\n", p,
+        Imbalance(m, row_ptr.data(), p, false),
+        Imbalance(m, row_ptr.data(), p, true), t_n, t_t);
+    if (p == max_threads)
+      break;
+  }
+#ifdef _OPENMP
+  omp_set_num_threads(max_threads);
+#endif
+
+  return t_n;
+}
+
+template double SkewedSpmv<double>(int m, int n, int nnz);
+template double SkewedSpmv<float>(int m, int n, int nnz);
+
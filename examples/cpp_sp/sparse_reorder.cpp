@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "matrix/matrix_sparse.h"
+#include "pogs.h"
+#include "timer.h"
+
+namespace {
+
+const int kReps = 50;
+const unsigned int kMaxIter = 20u;
+
+// Random m x n matrix whose row i has about nnz / m entries within a band
+// around column i * n / m, with its rows and columns shuffled. Returns the
+// number of nonzeros.
+template <typename T>
+int MatGenScrambledBand(int m, int n, int nnz, std::vector<T> *val,
+                        std::vector<int> *row_ptr, std::vector<int> *col_ind) {
+  std::default_random_engine generator;
+  std::uniform_real_distribution<T> u_dist(static_cast<T>(-1),
+                                           static_cast<T>(1));
+  int row_len = std::max(1, std::min(n, nnz / m));
+  int band = std::min(n, 4 * row_len);
+
+  std::vector<int> row_p(m), col_p(n);
+  for (int i = 0; i < m; ++i)
+    row_p[i] = i;
+  for (int j = 0; j < n; ++j)
+    col_p[j] = j;
+  std::shuffle(row_p.begin(), row_p.end(), generator);
+  std::shuffle(col_p.begin(), col_p.end(), generator);
+
+  // Row row_p[i] of the result is row i of the banded matrix.
+  std::vector<std::vector<int> > cols(m);
+  for (int i = 0; i < m; ++i) {
+    int first = static_cast<int>(static_cast<double>(i) * n / m) - band / 2;
+    first = std::max(0, std::min(first, n - band));
+    std::vector<int> &c = cols[row_p[i]];
+    for (int k = 0; k < band; ++k)
+      if (static_cast<int>(generator() % band) < row_len)
+        c.push_back(col_p[first + k]);
+    std::sort(c.begin(), c.end());
+  }
+
+  row_ptr->assign(m + 1, 0);
+  val->clear();
+  col_ind->clear();
+  for (int i = 0; i < m; ++i) {
+    for (size_t k = 0; k < cols[i].size(); ++k) {
+      col_ind->push_back(cols[i][k]);
+      val->push_back(u_dist(generator));
+    }
+    (*row_ptr)[i + 1] = static_cast<int>(col_ind->size());
+  }
+  return (*row_ptr)[m];
+}
+
+// Times kReps products with A and A^T after equilibration, and kMaxIter
+// iterations of a lasso solve, for A as given or reordered in Init. Prints
+// one row, sets t_mul to the time of one product with A and returns the
+// solution x.
+template <typename T>
+std::vector<T> ReorderReport(const char *name, bool reorder, int m, int n,
+                             int nnz, const std::vector<T> &val,
+                             const std::vector<int> &row_ptr,
+                             const std::vector<int> &col_ind,
+                             const std::vector<FunctionObj<T> > &f,
+                             const std::vector<FunctionObj<T> > &g,
+                             double *t_mul) {
+  typedef pogs::MatrixSparse<T> M;
+
+  M A('r', m, n, nnz, val.data(), row_ptr.data(), col_ind.data(), true,
+      false, reorder);
+  double t_init = timer<double>();
+  A.Init();
+  t_init = timer<double>() - t_init;
+  std::vector<T> d(m), e(n);
+  A.Equil(d.data(), e.data());
+
+  std::vector<T> x(n, static_cast<T>(1)), y(m, static_cast<T>(1));
+  double t_n = timer<double>();
+  for (int i = 0; i < kReps; ++i)
+    A.Mul('n', static_cast<T>(1), x.data(), static_cast<T>(0), y.data());
+  t_n = (timer<double>() - t_n) / kReps;
+
+  double t_t = timer<double>();
+  for (int i = 0; i < kReps; ++i)
+    A.Mul('t', static_cast<T>(1), y.data(), static_cast<T>(0), x.data());
+  t_t = (timer<double>() - t_t) / kReps;
+  *t_mul = t_n;
+
+  M A_solve('r', m, n, nnz, val.data(), row_ptr.data(), col_ind.data(), true,
+      false, reorder);
+  pogs::PogsIndirect<T, M> pogs_data(A_solve);
+  pogs_data.SetVerbose(0);
+  pogs_data.SetMaxIter(kMaxIter);
+  double t_solve = timer<double>();
+  pogs::PogsStatus status = pogs_data.Solve(f, g);
+  t_solve = timer<double>() - t_solve;
+
+  printf("%-9s %10.3e %10.3e %10.3e %-16s %6u %10.3e %12.5e\n", name, t_init,
+      t_n, t_t, pogs::PogsStatusString(status).c_str(),
+      pogs_data.GetFinalIter(), t_solve, pogs_data.GetOptval());
+  return std::vector<T>(pogs_data.GetX(), pogs_data.GetX() + n);
+}
+
+}  // namespace
+
+// Products with A and A^T and a lasso solve
+//   minimize    (1/2) ||Ax - b||_2^2 + \lambda ||x||_1,
+// for a banded A whose rows and columns have been shuffled, so that the
+// entries of x gathered by consecutive rows are scattered in memory, with
+// and without reverse Cuthill-McKee reordering in MatrixSparse::Init.
+// Prints the largest difference between the two iterates x after kMaxIter
+// iterations relative to the largest entry, which is at rounding level.
+// Returns the time of one product with the reordered A.
+template <typename T>
+double SparseReorder(int m, int n, int nnz) {
+  std::vector<T> val;
+  std::vector<int> row_ptr, col_ind;
+  nnz = MatGenScrambledBand(m, n, nnz, &val, &row_ptr, &col_ind);
+
+  std::default_random_engine generator;
+  std::normal_distribution<T> n_dist(static_cast<T>(0),
+                                     static_cast<T>(1));
+  std::vector<FunctionObj<T> > f;
+  std::vector<FunctionObj<T> > g;
+  f.reserve(m);
+  for (int i = 0; i < m; ++i)
+    f.emplace_back(kSquare, static_cast<T>(1),
+        static_cast<T>(4) * n_dist(generator));
+  g.reserve(n);
+  for (int i = 0; i < n; ++i)
+    g.emplace_back(kAbs, static_cast<T>(0.5));
+
+  printf("%-9s %10s %10s %10s %-16s %6s %10s %12s\n", "order", "init (s)",
+      "Ax (s)", "A'x (s)", "status", "iter", "solve (s)", "optval");
+  double t_given, t_rcm;
+  std::vector<T> x = ReorderReport("given", false, m, n, nnz, val, row_ptr,
+      col_ind, f, g, &t_given);
+  std::vector<T> x_rcm = ReorderReport("rcm", true, m, n, nnz, val, row_ptr,
+      col_ind, f, g, &t_rcm);
+
+  double diff = 0., nrm = 0.;
+  for (int j = 0; j < n; ++j) {
+    diff = std::max(diff, static_cast<double>(std::fabs(x[j] - x_rcm[j])));
+    nrm = std::max(nrm, static_cast<double>(std::fabs(x[j])));
+  }
+  printf("max |x - x_rcm| / max |x| = %.3e\n", nrm > 0. ? diff / nrm : diff);
+
+  return t_rcm;
+}
+
+template double SparseReorder<double>(int m, int n, int nnz);
+template double SparseReorder<float>(int m, int n, int nnz);
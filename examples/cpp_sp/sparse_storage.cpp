@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "matrix/matrix_sparse.h"
+#include "mat_gen.h"
+#include "pogs.h"
+#include "timer.h"
+
+namespace {
+
+const int kReps = 50;
+
+// Times Init, kReps products with A and with A^T and one lasso solve for A
+// stored with or without its transpose, and prints one row per layout.
+// Returns the solver time.
+template <typename T>
+double StorageReport(const char *name, bool store_transpose, int m, int n,
+                     int nnz, const T *val, const int *row_ptr,
+                     const int *col_ind, const std::vector<FunctionObj<T> > &f,
+                     const std::vector<FunctionObj<T> > &g) {
+  typedef pogs::MatrixSparse<T> M;
+
+  // Bytes of the values, indices and pointers held by MatrixSparse.
+  size_t copies = store_transpose ? 2 : 1;
+  size_t ptr_len = store_transpose ? m + n + 2 : m + 1;
+  size_t bytes = copies * nnz * (sizeof(T) + sizeof(int)) +
+      ptr_len * sizeof(int);
+
+  M A('r', m, n, nnz, val, row_ptr, col_ind, store_transpose);
+  double t_init = timer<double>();
+  A.Init();
+  t_init = timer<double>() - t_init;
+
+  std::vector<T> x(n, static_cast<T>(1)), y(m, static_cast<T>(1));
+  double t_n = timer<double>();
+  for (int i = 0; i < kReps; ++i)
+    A.Mul('n', static_cast<T>(1), x.data(), static_cast<T>(0), y.data());
+  t_n = (timer<double>() - t_n) / kReps;
+
+  double t_t = timer<double>();
+  for (int i = 0; i < kReps; ++i)
+    A.Mul('t', static_cast<T>(1), y.data(), static_cast<T>(0), x.data());
+  t_t = (timer<double>() - t_t) / kReps;
+
+  M A_solve('r', m, n, nnz, val, row_ptr, col_ind, store_transpose);
+  pogs::PogsIndirect<T, M> pogs_data(A_solve);
+  pogs_data.SetVerbose(0);
+  double t_solve = timer<double>();
+  pogs::PogsStatus status = pogs_data.Solve(f, g);
+  t_solve = timer<double>() - t_solve;
+
+  printf("%-7s %10.2f %10.3e %10.3e %10.3e %-16s %6u %10.3e\n", name,
+      static_cast<double>(bytes) / (1 << 20), t_init, t_n, t_t,
+      pogs::PogsStatusString(status).c_str(), pogs_data.GetFinalIter(),
+      t_solve);
+  return t_solve;
+}
+
+}  // namespace
+
+// Memory and speed of MatrixSparse with (dual) and without (single) an
+// explicit transpose. A is a random sparse matrix and the solve is the
+// lasso problem of the Lasso example
+//   minimize    (1/2) ||Ax - b||_2^2 + \lambda ||x||_1.
+// Returns the solver time with the single copy layout.
+template <typename T>
+double SparseStorage(int m, int n, int nnz) {
+  std::vector<T> val(nnz);
+  std::vector<int> col_ind(nnz);
+  std::vector<int> row_ptr(m + 1);
+
+  std::default_random_engine generator;
+  std::normal_distribution<T> n_dist(static_cast<T>(0),
+                                     static_cast<T>(1));
+
+  std::vector<std::tuple<int, int, T>> entries;
+  nnz = MatGenApprox(m, n, nnz, val.data(), row_ptr.data(), col_ind.data(),
+      static_cast<T>(-1), static_cast<T>(1), entries);
+
+  std::vector<FunctionObj<T> > f;
+  std::vector<FunctionObj<T> > g;
+  f.reserve(m);
+  for (int i = 0; i < m; ++i)
+    f.emplace_back(kSquare, static_cast<T>(1),
+        static_cast<T>(4) * n_dist(generator));
+  g.reserve(n);
+  for (int i = 0; i < n; ++i)
+    g.emplace_back(kAbs, static_cast<T>(0.5));
+
+  printf("%-7s %10s %10s %10s %10s %-16s %6s %10s\n", "layout", "MB",
+      "init (s)", "Ax (s)", "A'x (s)", "status", "iter", "solve (s)");
+  StorageReport("dual", true, m, n, nnz, val.data(), row_ptr.data(),
+      col_ind.data(), f, g);
+  return StorageReport("single", false, m, n, nnz, val.data(),
+      row_ptr.data(), col_ind.data(), f, g);
+}
+
+template double SparseStorage<double>(int m, int n, int nnz);
+template double SparseStorage<float>(int m, int n, int nnz);
+
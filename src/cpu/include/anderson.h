@@ -0,0 +1,226 @@
+#ifndef ANDERSON_H_
+#define ANDERSON_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "gsl/gsl_blas.h"
+#include "gsl/gsl_vector.h"
+#include "util.h"
+
+namespace pogs {
+namespace {
+
+// Tikhonov regularization (relative to the largest diagonal entry of the
+// Gram matrix) and the factor by which the fixed-point residual may grow
+// before an accelerated step is rejected.
+const double kAndersonReg       = 1e-10;
+const double kAndersonSafeguard = 1.0;
+
+// Safeguarded type-II Anderson acceleration of the fixed-point iteration
+// x := G(x), where x = (x1, x2) consists of two blocks of length size. With
+// F(x) = G(x) - x and the last mem differences dF and dG, the next iterate is
+//
+//   x^{k+1} = G(x^k) - dG * gamma,  gamma = argmin ||F(x^k) - dF * gamma||.
+//
+// If the residual at an extrapolated point exceeds the residual it was
+// extrapolated from, the plain step G(x^{k-1}) is taken instead and the
+// memory is cleared.
+template <typename T>
+class Anderson {
+ public:
+  Anderson(size_t size, unsigned int mem);
+  ~Anderson();
+
+  // Clears the memory. Must be called whenever the map G changes.
+  void Reset();
+
+  // Stores the current iterate x.
+  void SetIterate(const T *x1, const T *x2);
+
+  // On entry (g1, g2) = G(x), on exit it holds the next iterate. Returns 1
+  // if the previous step was accelerated and accepted, -1 if it was
+  // rejected and 0 otherwise.
+  int Step(T *g1, T *g2);
+
+  unsigned int Mem() const { return _mem; }
+
+ private:
+  size_t _size;
+  unsigned int _mem, _len, _head;
+  bool _has_prev, _accelerated;
+  double _nrm_f_prev;
+
+  // Buffers of length 2 * size, except _dF and _dG with mem columns each.
+  T *_x, *_g, *_f_prev, *_g_prev, *_dF, *_dG;
+  std::vector<double> _gram, _chol, _gamma;
+
+  bool SolveGram();
+};
+
+template <typename T>
+Anderson<T>::Anderson(size_t size, unsigned int mem)
+    : _size(size), _mem(mem), _len(0), _head(0), _has_prev(false),
+      _accelerated(false), _nrm_f_prev(0.),
+      _gram(mem * mem), _chol(mem * mem), _gamma(mem) {
+  ASSERT(mem > 0);
+  _x = new T[2 * size * (2 * mem + 4)]();
+  ASSERT(_x != 0);
+  _g = _x + 2 * size;
+  _f_prev = _g + 2 * size;
+  _g_prev = _f_prev + 2 * size;
+  _dF = _g_prev + 2 * size;
+  _dG = _dF + 2 * size * mem;
+}
+
+template <typename T>
+Anderson<T>::~Anderson() {
+  delete [] _x;
+  _x = _g = _f_prev = _g_prev = _dF = _dG = 0;
+}
+
+template <typename T>
+void Anderson<T>::Reset() {
+  _len = _head = 0;
+  _has_prev = _accelerated = false;
+}
+
+template <typename T>
+void Anderson<T>::SetIterate(const T *x1, const T *x2) {
+  memcpy(_x, x1, _size * sizeof(T));
+  memcpy(_x + _size, x2, _size * sizeof(T));
+}
+
+// Solves (dF' * dF + reg * I) gamma = dF' * f by Cholesky, where the Gram
+// matrix and right hand side have been stored in _gram and _gamma.
+template <typename T>
+bool Anderson<T>::SolveGram() {
+  unsigned int len = _len;
+  double reg = 0.;
+  for (unsigned int i = 0; i < len; ++i)
+    reg = std::max(reg, _gram[i * _mem + i]);
+  reg *= kAndersonReg;
+  for (unsigned int j = 0; j < len; ++j) {
+    for (unsigned int i = j; i < len; ++i) {
+      double l_ij = _gram[i * _mem + j] + (i == j ? reg : 0.);
+      for (unsigned int k = 0; k < j; ++k)
+        l_ij -= _chol[i * _mem + k] * _chol[j * _mem + k];
+      if (i == j) {
+        if (!(l_ij > 0.))
+          return false;
+        l_ij = std::sqrt(l_ij);
+      } else {
+        l_ij /= _chol[j * _mem + j];
+      }
+      _chol[i * _mem + j] = l_ij;
+    }
+  }
+  for (unsigned int i = 0; i < len; ++i) {
+    for (unsigned int k = 0; k < i; ++k)
+      _gamma[i] -= _chol[i * _mem + k] * _gamma[k];
+    _gamma[i] /= _chol[i * _mem + i];
+  }
+  for (unsigned int i = len; i-- > 0; ) {
+    for (unsigned int k = i + 1; k < len; ++k)
+      _gamma[i] -= _chol[k * _mem + i] * _gamma[k];
+    _gamma[i] /= _chol[i * _mem + i];
+  }
+  return true;
+}
+
+template <typename T>
+int Anderson<T>::Step(T *g1, T *g2) {
+  size_t n = 2 * _size;
+  T *f = _x;
+
+  // g := G(x), f := G(x) - x.
+  memcpy(_g, g1, _size * sizeof(T));
+  memcpy(_g + _size, g2, _size * sizeof(T));
+  double nrm2_f = 0.;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nrm2_f)
+#endif
+  for (size_t i = 0; i < n; ++i) {
+    f[i] = _g[i] - f[i];
+    nrm2_f += static_cast<double>(f[i]) * f[i];
+  }
+  double nrm_f = std::sqrt(nrm2_f);
+
+  // Safeguard: fall back to the plain step if the residual grew.
+  int status = 0;
+  if (_accelerated) {
+    if (!(nrm_f <= kAndersonSafeguard * _nrm_f_prev)) {
+      memcpy(g1, _g_prev, _size * sizeof(T));
+      memcpy(g2, _g_prev + _size, _size * sizeof(T));
+      Reset();
+      return -1;
+    }
+    status = 1;
+  }
+  _accelerated = false;
+  _nrm_f_prev = nrm_f;
+
+  if (!_has_prev) {
+    memcpy(_f_prev, f, n * sizeof(T));
+    memcpy(_g_prev, _g, n * sizeof(T));
+    _has_prev = true;
+    return status;
+  }
+
+  // Append dF = f - f_prev and dG = g - g_prev to the memory.
+  unsigned int slot = _head;
+  T *dF = _dF + slot * n;
+  T *dG = _dG + slot * n;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < n; ++i) {
+    dF[i] = f[i] - _f_prev[i];
+    dG[i] = _g[i] - _g_prev[i];
+    _f_prev[i] = f[i];
+    _g_prev[i] = _g[i];
+  }
+  _head = (_head + 1) % _mem;
+  _len = std::min(_len + 1, _mem);
+
+  // Update the Gram matrix and form the right hand side.
+  gsl::vector<T> f_vec = gsl::vector_view_array(f, n);
+  gsl::vector<T> dF_slot = gsl::vector_view_array(dF, n);
+  for (unsigned int j = 0; j < _len; ++j) {
+    gsl::vector<T> dF_j = gsl::vector_view_array(_dF + j * n, n);
+    T dot;
+    gsl::blas_dot(&dF_slot, &dF_j, &dot);
+    _gram[slot * _mem + j] = _gram[j * _mem + slot] = dot;
+    gsl::blas_dot(&dF_j, &f_vec, &dot);
+    _gamma[j] = dot;
+  }
+
+  if (!SolveGram())
+    return status;
+
+  // x := g - dG * gamma.
+  unsigned int len = _len;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < n; ++i) {
+    double x_i = _g[i];
+    for (unsigned int j = 0; j < len; ++j)
+      x_i -= _gamma[j] * _dG[j * n + i];
+    if (i < _size)
+      g1[i] = static_cast<T>(x_i);
+    else
+      g2[i - _size] = static_cast<T>(x_i);
+  }
+  _accelerated = true;
+
+  return status;
+}
+
+}  // namespace
+}  // namespace pogs
+
+#endif  // ANDERSON_H_
+
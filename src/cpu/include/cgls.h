@@ -64,6 +64,20 @@
 //
 //  quiet      - Disable printing to console.
 //
+//  norms_ref  - (Optional) If positive, convergence is measured relative to
+//               norms_ref instead of the initial residual ||A'(b - Ax)||.
+//               Pass ||A'b|| when x is a warm start, so that the tolerance
+//               is the same as for a cold start.
+//
+//  iter       - (Optional) Number of iterations taken.
+//
+//  M          - (Optional) Preconditioner, applies an approximation of
+//               (A'*A + shift*I)^{-1}. Convergence is still measured on the
+//               unpreconditioned residual.
+//
+//  work       - (Optional) Caller owned workspace. It is grown as needed, so
+//               repeated solves of the same size do not allocate.
+//
 //  ------------------------------ SPARSE --------------------------------------
 //
 //  Template Arguments:
@@ -107,6 +121,7 @@
 //  4 : Likely instable, (A'*A + shift*I) indefinite and norm(x) decreased.
 //  5 : Error in applying operator A.
 //  6 : Error in applying operator A^T.
+//  7 : Error in applying preconditioner M.
 //
 //  Reference:
 //  http://web.stanford.edu/group/SOL/software/cgls/
@@ -119,8 +134,10 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <cmath>
 #include <complex>
 #include <limits>
+#include <vector>
 
 #include "gsl/gsl_blas.h"
 #include "gsl/gsl_vector.h"
@@ -143,6 +160,38 @@ struct Gemv {
                          T *y) const = 0;
 };
 
+// Abstract preconditioner for A'A + shift*I, computes y := M^{-1} x.
+template <typename T>
+struct Precond {
+  virtual ~Precond() { };
+  virtual int operator()(const T *x, T *y) const = 0;
+};
+
+// Workspace for Solve, with room for the vectors of an m x n problem.
+template <typename T>
+class Workspace {
+ public:
+  Workspace() : _m(0), _n(0) { }
+
+  void Reserve(INT m, INT n) {
+    if (m <= _m && n <= _n)
+      return;
+    _m = std::max(m, _m);
+    _n = std::max(n, _n);
+    _data.resize(3 * static_cast<size_t>(_n) + 2 * static_cast<size_t>(_m));
+  }
+
+  // Vectors p, s and z of length n, q and r of length m.
+  T* Vec(int i) {
+    return _data.data() + (i < 3 ? i * static_cast<size_t>(_n) :
+        3 * static_cast<size_t>(_n) + (i - 3) * static_cast<size_t>(_m));
+  }
+
+ private:
+  INT _m, _n;
+  std::vector<T> _data;
+};
+
 // File-level functions and classes.
 namespace {
 
@@ -194,15 +243,81 @@ inline double Epsilon<std::complex<float> >() {
   return std::numeric_limits<float>::epsilon();
 }
 
+// Returns <s, z>, which is ||s||^2 if z aliases s.
+template <typename T>
+double Dot(const gsl::vector<T> *s, const gsl::vector<T> *z, double norms) {
+  if (s->data == z->data)
+    return norms * norms;
+  T dot;
+  gsl::blas_dot(s, z, &dot);
+  return static_cast<double>(dot);
+}
+
+// x := x + alpha*p and s := s - shift*x, with the squared norms of the
+// updated x and s accumulated in the same sweep.
+template <typename T>
+void UpdateXS(INT n, T alpha, T shift, const T *p, T *x, T *s,
+              double *normx2, double *norms2) {
+  double nx = 0., ns = 0.;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nx,ns)
+#endif
+  for (INT i = 0; i < n; ++i) {
+    T x_i = x[i] + alpha * p[i];
+    T s_i = s[i] - shift * x_i;
+    x[i] = x_i;
+    s[i] = s_i;
+    nx += static_cast<double>(x_i) * x_i;
+    ns += static_cast<double>(s_i) * s_i;
+  }
+  *normx2 = nx;
+  *norms2 = ns;
+}
+
+// s := s - shift*x, returns the squared norms of x and s.
+template <typename T>
+void SubShiftX(INT n, T shift, const T *x, T *s, double *normx2,
+               double *norms2) {
+  double nx = 0., ns = 0.;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nx,ns)
+#endif
+  for (INT i = 0; i < n; ++i) {
+    T s_i = s[i] - shift * x[i];
+    s[i] = s_i;
+    nx += static_cast<double>(x[i]) * x[i];
+    ns += static_cast<double>(s_i) * s_i;
+  }
+  *normx2 = nx;
+  *norms2 = ns;
+}
+
+// p := z + beta*p, returns ||p||^2.
+template <typename T>
+double UpdateP(INT n, T beta, const T *z, T *p) {
+  double np = 0.;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:np)
+#endif
+  for (INT i = 0; i < n; ++i) {
+    T p_i = z[i] + beta * p[i];
+    p[i] = p_i;
+    np += static_cast<double>(p_i) * p_i;
+  }
+  return np;
+}
+
 }  // namespace
 
 // Conjugate Gradient Least Squares.
 template <typename T, typename F>
 int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
-          const double shift, const double tol, const int maxit, bool quiet) {
+          const double shift, const double tol, const int maxit, bool quiet,
+          double norms_ref, int *iter, const Precond<T> *M,
+          Workspace<T> *work) {
   // Variable declarations.
-  gsl::vector<T> p, q, r, s, x_vec;
-  double gamma, normp, normq, norms, norms0, normx, xmax;
+  gsl::vector<T> p, q, r, s, z, x_vec;
+  double gamma, normp2, normq, norms, norms0, normx, normx2, norms2, xmax;
   char fmt[] = "%5d %9.2e %12.5g\n";
   int err = 0, k = 0, flag = 0, indefinite = 0;
 
@@ -210,17 +325,18 @@ int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
   const T kNegOne   = StaticCast<T>(-1.);
   const T kZero     = StaticCast<T>( 0.);
   const T kOne      = StaticCast<T>( 1.);
-  const T kNegShift = StaticCast<T>(-shift);
+  const T kShift    = StaticCast<T>(shift);
   const double kEps = Epsilon<T>();
 
   // Memory Allocation.
-  p = gsl::vector_alloc<T>(n);
-  q = gsl::vector_alloc<T>(m);
-  r = gsl::vector_alloc<T>(m);
-  s = gsl::vector_alloc<T>(n);
+  work->Reserve(m, n);
+  p = gsl::vector_view_array(work->Vec(0), n);
+  s = gsl::vector_view_array(work->Vec(1), n);
+  z = M ? gsl::vector_view_array(work->Vec(2), n) : s;
+  q = gsl::vector_view_array(work->Vec(3), m);
+  r = gsl::vector_view_array(work->Vec(4), m);
 
   gsl::vector_memcpy(&r, b);
-  gsl::vector_memcpy(&s, x);
 
   // Make x a gsl vector.
   x_vec = gsl::vector_view_array(x, n);
@@ -234,25 +350,33 @@ int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
   }
 
   // s = A'*r - shift*x.
-  err = A('t', kOne, r.data, kNegShift, s.data);
+  err = A('t', kOne, r.data, kZero, s.data);
   if (err)
     flag = 6;
-
-  // Initialize.
-  gsl::vector_memcpy(&p, &s);
-  norms = gsl::blas_nrm2(&s);
-  norms0 = norms;
-  gamma = norms0 * norms0;
-  normx = gsl::blas_nrm2(&x_vec);
+  SubShiftX(n, kShift, x_vec.data, s.data, &normx2, &norms2);
+
+  // Initialize, z = M^{-1}*s.
+  if (M && (*M)(s.data, z.data))
+    flag = 7;
+  gsl::vector_memcpy(&p, &z);
+  normp2 = gsl::blas_nrm2(&p);
+  normp2 *= normp2;
+  norms = std::sqrt(norms2);
+  norms0 = norms_ref > 0. ? norms_ref : norms;
+  gamma = Dot(&s, &z, norms);
+  normx = std::sqrt(normx2);
   xmax = normx;
 
   if (norms < kEps)
     flag = 1;
 
+  // A warm start may already be accurate enough.
+  bool done = norms <= norms0 * tol;
+
   if (!quiet)
     printf("    k     normx        resNE\n");
 
-  for (k = 0; k < maxit && !flag; ++k) {
+  for (k = 0; k < maxit && !flag && !done; ++k) {
     // q = A * p.
     err = A('n', kOne, p.data, kZero, q.data);
     if (err) {
@@ -260,10 +384,10 @@ int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
       break;
     }
 
-    // delta = norm(p)^2 + shift*norm(q)^2.
-    normp = gsl::blas_nrm2(&p);
+    // delta = norm(q)^2 + shift*norm(p)^2, where norm(p) is carried over
+    // from the update of p.
     normq = gsl::blas_nrm2(&q);
-    double delta = normq * normq + shift * normp * normp;
+    double delta = normq * normq + shift * normp2;
 
     if (delta <= 0.)
       indefinite = 1;
@@ -272,31 +396,36 @@ int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
     T alpha = StaticCast<T>(gamma / delta);
     T neg_alpha = StaticCast<T>(-gamma / delta);
 
-    // x = x + alpha*p.
     // r = r - alpha*q.
-    gsl::blas_axpy(alpha, &p, &x_vec);
     gsl::blas_axpy(neg_alpha, &q, &r);
 
-    // s = A'*r - shift*x.
-    gsl::vector_memcpy(&s, &x_vec);
-    err = A('t', kOne, r.data, kNegShift, s.data);
+    // s = A'*r.
+    err = A('t', kOne, r.data, kZero, s.data);
     if (err) {
       flag = 6;
       break;
     }
 
+    // x = x + alpha*p and s = s - shift*x in one sweep.
+    UpdateXS(n, alpha, kShift, p.data, x_vec.data, s.data, &normx2, &norms2);
+    norms = std::sqrt(norms2);
+    normx = std::sqrt(normx2);
+
+    // z = M^{-1}*s.
+    if (M && (*M)(s.data, z.data)) {
+      flag = 7;
+      break;
+    }
+
     // Compute beta.
-    norms = gsl::blas_nrm2(&s);
     double gamma1 = gamma;
-    gamma = norms * norms;
+    gamma = Dot(&s, &z, norms);
     T beta = StaticCast<T>(gamma / gamma1);
 
-    // p = s + beta*p.
-    gsl::blas_axpy(beta, &p, &s);
-    gsl::vector_memcpy(&p, &s);
+    // p = z + beta*p.
+    normp2 = UpdateP(n, beta, z.data, p.data);
 
     // Convergence check.
-    normx = gsl::blas_nrm2(&x_vec);
     xmax = std::max(xmax, normx);
     bool converged = (norms <= norms0 * tol) || (normx * tol >= 1.);
     if (!quiet && (converged || k % 10 == 0))
@@ -314,14 +443,28 @@ int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
   else if (shrink * shrink <= tol)
     flag = 4;
 
-  // Free variables and return;
-  gsl::vector_free(&p);
-  gsl::vector_free(&q);
-  gsl::vector_free(&r);
-  gsl::vector_free(&s);
+  if (iter)
+    *iter = k;
+
   return flag;
 }
 
+template <typename T, typename F>
+int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
+          const double shift, const double tol, const int maxit, bool quiet,
+          double norms_ref, int *iter, const Precond<T> *M) {
+  Workspace<T> work;
+  return Solve(A, m, n, b, x, shift, tol, maxit, quiet, norms_ref, iter, M,
+      &work);
+}
+
+template <typename T, typename F>
+int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
+          const double shift, const double tol, const int maxit, bool quiet) {
+  return Solve(A, m, n, b, x, shift, tol, maxit, quiet, 0.,
+      static_cast<int*>(0), static_cast<const Precond<T>*>(0));
+}
+
 }  // namespace cgls
 
 #endif  // CGLS_H_
@@ -0,0 +1,208 @@
+#ifndef CGLS_PRECOND_H_
+#define CGLS_PRECOND_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "cgls.h"
+
+namespace cgls {
+
+const unsigned int kIncCholMaxRetry = 10u;
+
+// Jacobi preconditioner diag(A'A) + shift*I, where nrm2 holds the squared
+// column norms of A. Changing shift does not require any setup. Entries
+// with a zero diagonal (an empty column and shift = 0) are left unscaled.
+template <typename T>
+struct JacobiPrecond : Precond<T> {
+  INT n;
+  const T *nrm2;
+  T shift;
+  JacobiPrecond(INT n, const T *nrm2, T shift)
+      : n(n), nrm2(nrm2), shift(shift) { }
+  int operator()(const T *x, T *y) const {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (INT i = 0; i < n; ++i) {
+      T d = nrm2[i] + shift;
+      y[i] = d > static_cast<T>(0) ? x[i] / d : x[i];
+    }
+    return 0;
+  }
+};
+
+// Zero fill incomplete Cholesky factorization L L' of A'A + shift*I. The
+// lower triangle of A'A is formed once in the constructor from A in both
+// CSC and CSR format, Factor computes L for a shift. Both A'A and L are
+// stored in CSC format with the diagonal first in each column, L as an
+// array of Nnz() values supplied by the caller, so that one IncChol can be
+// shared by threads factoring for different shifts. Note that A'A is dense
+// if A has a dense row.
+template <typename T>
+class IncChol {
+ public:
+  IncChol(INT n, const INT *col_ptr, const INT *row_ind, const T *val_c,
+          const INT *row_ptr, const INT *col_ind, const T *val_r);
+
+  size_t Nnz() const { return _gram.size(); }
+
+  // Computes L for shift. If a pivot breaks down, the diagonal is increased
+  // by alpha * max(diag, 1) for alpha = 1e-3, 1e-2, ... and the factorization
+  // retried, at most kIncCholMaxRetry times. Returns non-zero on failure.
+  int Factor(T shift, T *L) const;
+
+  // y := (L L')^{-1} x.
+  void Solve(const T *L, const T *x, T *y) const;
+
+ private:
+  INT _n;
+  std::vector<INT> _ptr, _ind;
+  std::vector<T> _gram;
+};
+
+// Preconditioner with the factor L of an IncChol, recomputed only when the
+// shift changes. Factor returns non-zero if the factorization failed, in
+// which case the preconditioner must not be used.
+template <typename T>
+class IncCholPrecond : public Precond<T> {
+ public:
+  IncCholPrecond() : _chol(0), _shift(0), _err(0) { }
+
+  int Factor(const IncChol<T> *chol, T shift) {
+    if (chol == _chol && shift == _shift)
+      return _err;
+    _L.resize(chol->Nnz());
+    _err = chol->Factor(shift, _L.data());
+    _chol = chol;
+    _shift = shift;
+    return _err;
+  }
+
+  int operator()(const T *x, T *y) const {
+    if (_chol == 0 || _err)
+      return 1;
+    _chol->Solve(_L.data(), x, y);
+    return 0;
+  }
+
+ private:
+  const IncChol<T> *_chol;
+  std::vector<T> _L;
+  T _shift;
+  int _err;
+};
+
+template <typename T>
+IncChol<T>::IncChol(INT n, const INT *col_ptr, const INT *row_ind,
+                    const T *val_c, const INT *row_ptr, const INT *col_ind,
+                    const T *val_r)
+    : _n(n), _ptr(n + 1) {
+  // Column j of A'A is sum_r a_rj * A(r, :)' over the rows r in column j.
+  std::vector<T> acc(n, static_cast<T>(0));
+  std::vector<INT> marker(n, -1), nz;
+  _ptr[0] = 0;
+  for (INT j = 0; j < n; ++j) {
+    nz.clear();
+    marker[j] = j;
+    nz.push_back(j);
+    for (INT l = col_ptr[j]; l < col_ptr[j + 1]; ++l) {
+      INT r = row_ind[l];
+      T a_rj = val_c[l];
+      for (INT t = row_ptr[r]; t < row_ptr[r + 1]; ++t) {
+        INT c = col_ind[t];
+        if (c < j)
+          continue;
+        if (marker[c] != j) {
+          marker[c] = j;
+          nz.push_back(c);
+        }
+        acc[c] += a_rj * val_r[t];
+      }
+    }
+    std::sort(nz.begin() + 1, nz.end());
+    for (size_t t = 0; t < nz.size(); ++t) {
+      _ind.push_back(nz[t]);
+      _gram.push_back(acc[nz[t]]);
+      acc[nz[t]] = static_cast<T>(0);
+    }
+    _ptr[j + 1] = static_cast<INT>(_ind.size());
+  }
+}
+
+template <typename T>
+int IncChol<T>::Factor(T shift, T *L) const {
+  double alpha = 0.;
+  for (unsigned int retry = 0; retry <= kIncCholMaxRetry; ++retry) {
+    // The increase is absolute for small diagonals, so that an empty column
+    // with shift = 0 gets a positive pivot.
+    for (INT j = 0; j < _n; ++j) {
+      for (INT l = _ptr[j]; l < _ptr[j + 1]; ++l)
+        L[l] = _gram[l];
+      L[_ptr[j]] += shift + static_cast<T>(alpha) *
+          std::max(_gram[_ptr[j]], static_cast<T>(1));
+    }
+
+    // Right looking, column k updates the columns j > k in its pattern.
+    bool ok = true;
+    for (INT k = 0; k < _n && ok; ++k) {
+      INT kb = _ptr[k], ke = _ptr[k + 1];
+      if (!(L[kb] > static_cast<T>(0))) {
+        ok = false;
+        break;
+      }
+      T l_kk = std::sqrt(L[kb]);
+      L[kb] = l_kk;
+      for (INT l = kb + 1; l < ke; ++l)
+        L[l] /= l_kk;
+      for (INT l = kb + 1; l < ke; ++l) {
+        INT j = _ind[l];
+        T l_jk = L[l];
+        // Merge rows i >= j of column k with the pattern of column j.
+        INT t = _ptr[j], te = _ptr[j + 1];
+        for (INT u = l; u < ke && t < te; ) {
+          if (_ind[u] < _ind[t]) {
+            ++u;
+          } else if (_ind[u] > _ind[t]) {
+            ++t;
+          } else {
+            L[t] -= L[u] * l_jk;
+            ++u;
+            ++t;
+          }
+        }
+      }
+    }
+    if (ok)
+      return 0;
+    alpha = alpha == 0. ? 1e-3 : 10. * alpha;
+  }
+  return 1;
+}
+
+template <typename T>
+void IncChol<T>::Solve(const T *L, const T *x, T *y) const {
+  std::copy(x, x + _n, y);
+
+  // y := L^{-1} y.
+  for (INT k = 0; k < _n; ++k) {
+    T y_k = y[k] / L[_ptr[k]];
+    y[k] = y_k;
+    for (INT l = _ptr[k] + 1; l < _ptr[k + 1]; ++l)
+      y[_ind[l]] -= L[l] * y_k;
+  }
+
+  // y := L^{-T} y.
+  for (INT k = _n; k-- > 0; ) {
+    T y_k = y[k];
+    for (INT l = _ptr[k] + 1; l < _ptr[k + 1]; ++l)
+      y_k -= L[l] * y[_ind[l]];
+    y[k] = y_k / L[_ptr[k]];
+  }
+}
+
+}  // namespace cgls
+
+#endif  // CGLS_PRECOND_H_
+
@@ -63,9 +63,9 @@ void SetSign(T* x, unsigned char *sign, size_t size, F f) {
 #ifdef _OPENMP
 #pragma omp parallel for
 #endif
-  for (unsigned int t = 0; t < size; ++t) {
+  for (size_t t = 0; t < size; ++t) {
     sign[t] = 0;
-    for (unsigned int i = 0; i < 8; ++i) {
+    for (size_t i = 0; i < 8; ++i) {
       sign[t] |= static_cast<unsigned char>((x[8 * t + i] < 0) << i);
       x[8 * t + i] = f(x[8 * t + i]);
     }
@@ -75,7 +75,7 @@ void SetSign(T* x, unsigned char *sign, size_t size, F f) {
 template <typename T, typename F>
 void SetSignSingle(T* x, unsigned char *sign, size_t bits, F f) {
   sign[0] = 0;
-  for (unsigned int i = 0; i < bits; ++i) {
+  for (size_t i = 0; i < bits; ++i) {
     sign[0] |= static_cast<unsigned char>((x[i] < 0) << i);
     x[i] = f(x[i]);
   }
@@ -86,8 +86,8 @@ void UnSetSign(T* x, unsigned char *sign, size_t size, F f) {
 #ifdef _OPENMP
 #pragma omp parallel for
 #endif
-  for (unsigned int t = 0; t < size; ++t) {
-    for (unsigned int i = 0; i < 8; ++i) {
+  for (size_t t = 0; t < size; ++t) {
+    for (size_t i = 0; i < 8; ++i) {
       x[8 * t + i] = (1 - 2 * static_cast<int>((sign[t] >> i) & 1)) *
           f(x[8 * t + i]);
     }
@@ -96,7 +96,7 @@ void UnSetSign(T* x, unsigned char *sign, size_t size, F f) {
 
 template <typename T, typename F>
 void UnSetSignSingle(T* x, unsigned char *sign, size_t bits, F f) {
-  for (unsigned int i = 0; i < bits; ++i)
+  for (size_t i = 0; i < bits; ++i)
     x[i] = (1 - 2 * static_cast<int>((sign[0] >> i) & 1)) * f(x[i]);
 }
 
@@ -1,7 +1,10 @@
 #ifndef GSL_LINALG_H_
 #define GSL_LINALG_H_
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <vector>
 
 #include "gsl_blas.h"
 #include "gsl_matrix.h"
@@ -60,6 +63,167 @@ void linalg_cholesky_svx(const matrix<T, O> *LLT, vector<T> *x) {
   blas_trsv(CblasLower, CblasTrans, CblasNonUnit, LLT, x);
 }
 
+// Eigendecomposition A = Q diag(eval) Q^T of a symmetric matrix, of which
+// only the lower triangle is read. Householder tridiagonalization followed
+// by implicit QL (EISPACK tred2/tql2), carried out in double precision on a
+// column major work array so that all inner loops are unit stride. The
+// eigenvalues are not sorted.
+template <typename T, CBLAS_ORDER O, CBLAS_ORDER OQ>
+void linalg_eigen_symmv(const matrix<T, O> *A, vector<T> *eval,
+                        matrix<T, OQ> *Q) {
+  size_t n = A->size1;
+  if (n == 0)
+    return;
+  std::vector<double> V_data(n * n), d(n), e(n);
+  auto V = [&](size_t i, size_t j) -> double& { return V_data[i + j * n]; };
+  for (size_t j = 0; j < n; ++j)
+    for (size_t i = j; i < n; ++i)
+      V(i, j) = V(j, i) = matrix_get(A, i, j);
+
+  // Reduce to tridiagonal form, d is the diagonal and e the subdiagonal.
+  for (size_t j = 0; j < n; ++j)
+    d[j] = V(n - 1, j);
+  for (size_t i = n - 1; i > 0; --i) {
+    double scale = 0., h = 0.;
+    for (size_t k = 0; k < i; ++k)
+      scale += std::abs(d[k]);
+    if (scale == 0.) {
+      e[i] = d[i - 1];
+      for (size_t j = 0; j < i; ++j) {
+        d[j] = V(i - 1, j);
+        V(i, j) = V(j, i) = 0.;
+      }
+    } else {
+      for (size_t k = 0; k < i; ++k) {
+        d[k] /= scale;
+        h += d[k] * d[k];
+      }
+      double f = d[i - 1];
+      double g = f > 0. ? -std::sqrt(h) : std::sqrt(h);
+      e[i] = scale * g;
+      h -= f * g;
+      d[i - 1] = f - g;
+      for (size_t j = 0; j < i; ++j)
+        e[j] = 0.;
+      for (size_t j = 0; j < i; ++j) {
+        f = d[j];
+        V(j, i) = f;
+        g = e[j] + V(j, j) * f;
+        for (size_t k = j + 1; k < i; ++k) {
+          g += V(k, j) * d[k];
+          e[k] += V(k, j) * f;
+        }
+        e[j] = g;
+      }
+      f = 0.;
+      for (size_t j = 0; j < i; ++j) {
+        e[j] /= h;
+        f += e[j] * d[j];
+      }
+      double hh = f / (h + h);
+      for (size_t j = 0; j < i; ++j)
+        e[j] -= hh * d[j];
+      for (size_t j = 0; j < i; ++j) {
+        f = d[j];
+        g = e[j];
+        for (size_t k = j; k < i; ++k)
+          V(k, j) -= f * e[k] + g * d[k];
+        d[j] = V(i - 1, j);
+        V(i, j) = 0.;
+      }
+    }
+    d[i] = h;
+  }
+
+  // Accumulate the Householder transformations.
+  for (size_t i = 0; i + 1 < n; ++i) {
+    V(n - 1, i) = V(i, i);
+    V(i, i) = 1.;
+    double h = d[i + 1];
+    if (h != 0.) {
+      for (size_t k = 0; k <= i; ++k)
+        d[k] = V(k, i + 1) / h;
+      for (size_t j = 0; j <= i; ++j) {
+        double g = 0.;
+        for (size_t k = 0; k <= i; ++k)
+          g += V(k, i + 1) * V(k, j);
+        for (size_t k = 0; k <= i; ++k)
+          V(k, j) -= g * d[k];
+      }
+    }
+    for (size_t k = 0; k <= i; ++k)
+      V(k, i + 1) = 0.;
+  }
+  for (size_t j = 0; j < n; ++j) {
+    d[j] = V(n - 1, j);
+    V(n - 1, j) = 0.;
+  }
+  V(n - 1, n - 1) = 1.;
+
+  // Diagonalize the tridiagonal matrix with implicit QL iterations.
+  for (size_t i = 1; i < n; ++i)
+    e[i - 1] = e[i];
+  e[n - 1] = 0.;
+  const double eps = std::numeric_limits<double>::epsilon();
+  double f = 0., tst1 = 0.;
+  for (size_t l = 0; l < n; ++l) {
+    tst1 = std::max(tst1, std::abs(d[l]) + std::abs(e[l]));
+    size_t m = l;
+    while (m + 1 < n && std::abs(e[m]) > eps * tst1)
+      ++m;
+    if (m > l) {
+      do {
+        double g = d[l];
+        double p = (d[l + 1] - g) / (2. * e[l]);
+        double r = std::hypot(p, 1.);
+        if (p < 0.)
+          r = -r;
+        d[l] = e[l] / (p + r);
+        d[l + 1] = e[l] * (p + r);
+        double dl1 = d[l + 1];
+        double h = g - d[l];
+        for (size_t i = l + 2; i < n; ++i)
+          d[i] -= h;
+        f += h;
+
+        p = d[m];
+        double c = 1., c2 = 1., c3 = 1., s = 0., s2 = 0.;
+        double el1 = e[l + 1];
+        for (size_t i = m; i-- > l; ) {
+          c3 = c2;
+          c2 = c;
+          s2 = s;
+          g = c * e[i];
+          h = c * p;
+          r = std::hypot(p, e[i]);
+          e[i + 1] = s * r;
+          s = e[i] / r;
+          c = p / r;
+          p = c * d[i] - s * g;
+          d[i + 1] = h + s * (c * g + s * d[i]);
+          double *v0 = &V(0, i), *v1 = &V(0, i + 1);
+          for (size_t k = 0; k < n; ++k) {
+            h = v1[k];
+            v1[k] = s * v0[k] + c * h;
+            v0[k] = c * v0[k] - s * h;
+          }
+        }
+        p = -s * s2 * c3 * el1 * e[l] / dl1;
+        e[l] = s * p;
+        d[l] = c * p;
+      } while (std::abs(e[l]) > eps * tst1);
+    }
+    d[l] += f;
+    e[l] = 0.;
+  }
+
+  for (size_t j = 0; j < n; ++j) {
+    vector_set(eval, j, static_cast<T>(d[j]));
+    for (size_t i = 0; i < n; ++i)
+      matrix_set(Q, i, j, static_cast<T>(V(i, j)));
+  }
+}
+
 }  // namespace gsl
 
 #endif  // GSL_LINALG_H_
@@ -111,6 +111,22 @@ matrix<T, O> matrix_view_array(T *base, size_t n1, size_t n2) {
   return mat;
 }
 
+// Views with a leading dimension tda, e.g. a block of k stacked vectors.
+template <typename T, CBLAS_ORDER O>
+matrix<T, O> matrix_view_array(const T *base, size_t n1, size_t n2,
+                               size_t tda) {
+  matrix<T, O> mat = matrix_view_array<T, O>(base, n1, n2);
+  mat.tda = tda;
+  return mat;
+}
+
+template <typename T, CBLAS_ORDER O>
+matrix<T, O> matrix_view_array(T *base, size_t n1, size_t n2, size_t tda) {
+  matrix<T, O> mat = matrix_view_array<T, O>(base, n1, n2);
+  mat.tda = tda;
+  return mat;
+}
+
 template <typename T, CBLAS_ORDER O>
 inline T matrix_get(const matrix<T, O> *A, size_t i, size_t j) {
   if (O == CblasRowMajor)
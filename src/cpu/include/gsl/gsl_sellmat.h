@@ -0,0 +1,127 @@
+#ifndef GSL_SELLMAT_H_
+#define GSL_SELLMAT_H_
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "gsl_spmat.h"
+
+namespace gsl {
+
+// Rows per slice and rows per sorting window of the SELL-C-sigma format.
+const size_t kSellC = 8;
+const size_t kSellSigma = 32 * kSellC;
+
+// Sliced ELLPACK (SELL-C-sigma) storage of a rows x cols matrix given in
+// CSR format. Rows are sorted by decreasing length within windows of
+// kSellSigma rows and grouped into slices of kSellC rows, each padded to
+// its longest row. Entry k of lane r of slice s is at
+// slice_ptr[s] + k * kSellC + r, so that a sweep over k processes kSellC
+// rows with contiguous loads. perm[s * kSellC + r] is the CSR row of lane r.
+// Padding has value zero and repeats a column of its row, so that no
+// out-of-range loads occur.
+// part holds num_parts + 1 boundaries of slice ranges with about equal
+// padded entries, see spmat_partition.
+template <typename T, typename I>
+struct sellmat {
+  T *val;
+  I *ind, *slice_ptr, *perm, *part;
+  I rows, cols, num_slices;
+  int num_parts;
+  sellmat()
+      : val(0), ind(0), slice_ptr(0), perm(0), part(0), rows(0), cols(0),
+        num_slices(0), num_parts(0) { }
+};
+
+// Copies new values of the CSR matrix the structure was built from, such
+// as after equilibration.
+template <typename T, typename I>
+void sellmat_copy_val(sellmat<T, I> *A, const T *val, const I *ptr) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (I s = 0; s < A->num_slices; ++s) {
+    I width = (A->slice_ptr[s + 1] - A->slice_ptr[s]) /
+        static_cast<I>(kSellC);
+    for (size_t r = 0; r < kSellC; ++r) {
+      I i = A->perm[s * kSellC + r];
+      I len_i = i < A->rows ? ptr[i + 1] - ptr[i] : 0;
+      for (I k = 0; k < width; ++k)
+        A->val[A->slice_ptr[s] + k * kSellC + r] =
+            k < len_i ? val[ptr[i] + k] : static_cast<T>(0);
+    }
+  }
+}
+
+// Builds the SELL-C-sigma structure from the CSR arrays ptr and ind, split
+// into num_parts slice ranges, and copies the values val.
+template <typename T, typename I>
+sellmat<T, I> sellmat_from_csr(I rows, I cols, const T *val, const I *ptr,
+                               const I *ind, int num_parts) {
+  sellmat<T, I> A;
+  A.rows = rows;
+  A.cols = cols;
+  A.num_slices = static_cast<I>((rows + kSellC - 1) / kSellC);
+
+  size_t num_lanes = A.num_slices * kSellC;
+  A.perm = new I[num_lanes];
+  std::iota(A.perm, A.perm + rows, static_cast<I>(0));
+  for (size_t r0 = 0; r0 < static_cast<size_t>(rows); r0 += kSellSigma) {
+    I *begin = A.perm + r0;
+    I *end = A.perm + std::min(r0 + kSellSigma, static_cast<size_t>(rows));
+    std::stable_sort(begin, end, [ptr](I i, I j) {
+      return ptr[i + 1] - ptr[i] > ptr[j + 1] - ptr[j];
+    });
+  }
+  // Lanes past the last row are empty.
+  std::fill(A.perm + rows, A.perm + num_lanes, rows);
+
+  A.slice_ptr = new I[A.num_slices + 1];
+  A.slice_ptr[0] = 0;
+  for (I s = 0; s < A.num_slices; ++s) {
+    I width = 0;
+    for (size_t r = 0; r < kSellC; ++r) {
+      I i = A.perm[s * kSellC + r];
+      if (i < rows)
+        width = std::max(width, ptr[i + 1] - ptr[i]);
+    }
+    A.slice_ptr[s + 1] = A.slice_ptr[s] + width * static_cast<I>(kSellC);
+  }
+
+  size_t len = A.slice_ptr[A.num_slices];
+  A.val = new T[len];
+  A.ind = new I[len];
+  for (I s = 0; s < A.num_slices; ++s) {
+    I width = (A.slice_ptr[s + 1] - A.slice_ptr[s]) / static_cast<I>(kSellC);
+    for (size_t r = 0; r < kSellC; ++r) {
+      I i = A.perm[s * kSellC + r];
+      I len_i = i < rows ? ptr[i + 1] - ptr[i] : 0;
+      I pad = len_i > 0 ? ind[ptr[i + 1] - 1] : 0;
+      for (I k = 0; k < width; ++k)
+        A.ind[A.slice_ptr[s] + k * kSellC + r] =
+            k < len_i ? ind[ptr[i] + k] : pad;
+    }
+  }
+  A.num_parts = num_parts;
+  A.part = new I[num_parts + 1];
+  spmat_partition(A.num_slices, A.slice_ptr, num_parts, A.part);
+
+  sellmat_copy_val(&A, val, ptr);
+  return A;
+}
+
+template <typename T, typename I>
+void sellmat_free(sellmat<T, I> *A) {
+  delete [] A->val;
+  delete [] A->ind;
+  delete [] A->slice_ptr;
+  delete [] A->perm;
+  delete [] A->part;
+  *A = sellmat<T, I>();
+}
+
+}  // namespace gsl
+
+#endif  // GSL_SELLMAT_H_
+
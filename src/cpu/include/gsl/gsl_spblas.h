@@ -1,45 +1,356 @@
 #ifndef GSL_SPBLAS_H_
 #define GSL_SPBLAS_H_
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "gsl_matrix.h"
+#include "gsl_sellmat.h"
 #include "gsl_spmat.h"
 #include "gsl_vector.h"
 
 namespace gsl {
 
+// Length of the scratch that spblas_scatter needs for nc columns of a
+// product with cols rows, split into num_parts parts.
+inline size_t spblas_scatter_len(size_t cols, size_t nc, int num_parts) {
+  return num_parts > 1 ? (num_parts - 1) * cols * nc : 0;
+}
+
+// Y := alpha * B' * X + beta * Y for B with rows rows and cols columns in
+// CSR format, X and Y column major with nc columns. Used when only B is
+// stored: row i of B is scattered into Y, scaled by X(i, c). The rows are
+// split into num_parts ranges by part (or evenly over the threads if part
+// is null). Each range scatters into its own copy of Y (the first into Y
+// itself) and the copies are summed at the end. The copies are taken from
+// work if work_len is at least spblas_scatter_len, and allocated otherwise.
+template <typename T, typename I>
+void spblas_scatter(I rows, I cols, size_t nc, T alpha, const T *data,
+                    const I *row_ptr, const I *col_ind, const T *x,
+                    size_t ldx, T beta, T *y, size_t ldy, const I *part,
+                    int num_parts, T *work, size_t work_len) {
+  for (size_t c = 0; c < nc; ++c) {
+    T *y_c = y + c * ldy;
+    if (beta == static_cast<T>(0))
+      std::fill(y_c, y_c + cols, static_cast<T>(0));
+    else if (beta != static_cast<T>(1))
+      for (I j = 0; j < cols; ++j)
+        y_c[j] *= beta;
+  }
+
+  std::vector<I> even;
+  if (part == 0) {
+#ifdef _OPENMP
+    num_parts = omp_get_max_threads();
+#else
+    num_parts = 1;
+#endif
+    even.resize(num_parts + 1);
+    spmat_partition(rows, row_ptr, num_parts, even.data());
+    part = even.data();
+  }
+
+  size_t part_len = static_cast<size_t>(cols) * nc;
+  std::vector<T> y_part;
+  if (work_len < spblas_scatter_len(cols, nc, num_parts)) {
+    y_part.resize(spblas_scatter_len(cols, nc, num_parts));
+    work = y_part.data();
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+  for (int t = 0; t < num_parts; ++t) {
+    T *y_t = t == 0 ? y : work + (t - 1) * part_len;
+    size_t ld_t = t == 0 ? ldy : static_cast<size_t>(cols);
+    if (t > 0)
+      std::fill(y_t, y_t + part_len, static_cast<T>(0));
+    for (I i = part[t]; i < part[t + 1]; ++i) {
+      for (I j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+        T a_ij = alpha * data[j];
+        T *y_j = y_t + col_ind[j];
+        for (size_t c = 0; c < nc; ++c)
+          y_j[c * ld_t] += a_ij * x[c * ldx + i];
+      }
+    }
+  }
+
+  if (num_parts > 1) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (I j = 0; j < cols; ++j) {
+      for (size_t c = 0; c < nc; ++c) {
+        T sum = static_cast<T>(0);
+        for (int t = 1; t < num_parts; ++t)
+          sum += work[(t - 1) * part_len + c * cols + j];
+        y[c * ldy + j] += sum;
+      }
+    }
+  }
+}
+
+// True if op(A) is stored explicitly (possibly as the transpose of A).
+template <typename T, typename I, CBLAS_ORDER O>
+bool spmat_has_op(CBLAS_TRANSPOSE_t transA, const spmat<T, I, O> *A) {
+  return A->transp || (O == CblasRowMajor) == (transA == CblasNoTrans);
+}
+
+// Row ranges of the second stored orientation.
+template <typename T, typename I, CBLAS_ORDER O>
+const I* spmat_transp_part(const spmat<T, I, O> *A) {
+  return A->part ? A->part + A->num_parts + 1 : 0;
+}
+
 template <typename T, typename I, CBLAS_ORDER O>
 void spblas_gemv(CBLAS_TRANSPOSE_t transA, T alpha, const spmat<T, I, O> *A,
                  const vector<T> *x, T beta, vector<T> *y) {
+  // op(A) is the transpose of the stored matrix.
+  if (!spmat_has_op(transA, A)) {
+    I rows = O == CblasRowMajor ? A->m : A->n;
+    I cols = O == CblasRowMajor ? A->n : A->m;
+    spblas_scatter(rows, cols, 1, alpha, A->val, A->ptr, A->ind, x->data,
+        rows, beta, y->data, cols, A->part, A->num_parts, A->work,
+        A->work_len);
+    return;
+  }
+
   T *data;
   I *col_ind;
   I *row_ptr;
+  const I *part;
 
   if ((O == CblasRowMajor && transA == CblasNoTrans) ||
       (O == CblasColMajor && transA == CblasTrans)) {
     data = A->val;
     col_ind = A->ind;
     row_ptr = A->ptr;
+    part = A->part;
   } else {
     data = A->val + A->nnz;
     col_ind = A->ind + A->nnz;
     row_ptr = A->ptr + ptr_len(*A);
+    part = spmat_transp_part(A);
   }
 
   I size = transA == CblasNoTrans ? A->m : A->n;
 
   // TODO: Allow for use of MKL or similar.
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-  for (I i = 0; i < size; ++i) {
-    T tmp = static_cast<T>(0);
-    for (I j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
-      tmp += data[j] * x->data[col_ind[j]];
+  spmat_for_rows(size, part, A->num_parts, [&](I begin, I end) {
+    for (I i = begin; i < end; ++i) {
+      T tmp = static_cast<T>(0);
+      for (I j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+        tmp += data[j] * x->data[col_ind[j]];
+      }
+      // Don't read y when beta is zero, it may be uninitialized (as in BLAS).
+      if (beta == static_cast<T>(0))
+        y->data[i] = alpha * tmp;
+      else
+        y->data[i] = alpha * tmp + beta * y->data[i];
+    }
+  });
+}
+
+// Y := alpha * op(A) * X + beta * Y, where X and Y are column major. Each
+// row of op(A) is applied to kSpblasBlk columns at a time so that the index
+// and value arrays of A are streamed once per block instead of per column.
+const size_t kSpblasBlk = 8;
+
+template <typename T, typename I, CBLAS_ORDER O>
+void spblas_gemm(CBLAS_TRANSPOSE_t transA, T alpha, const spmat<T, I, O> *A,
+                 const matrix<T, CblasColMajor> *X, T beta,
+                 matrix<T, CblasColMajor> *Y) {
+  if (!spmat_has_op(transA, A)) {
+    I rows = O == CblasRowMajor ? A->m : A->n;
+    I cols = O == CblasRowMajor ? A->n : A->m;
+    for (size_t c0 = 0; c0 < Y->size2; c0 += kSpblasBlk) {
+      size_t nc = std::min(kSpblasBlk, Y->size2 - c0);
+      spblas_scatter(rows, cols, nc, alpha, A->val, A->ptr, A->ind,
+          X->data + c0 * X->tda, X->tda, beta, Y->data + c0 * Y->tda, Y->tda,
+          A->part, A->num_parts, A->work, A->work_len);
     }
-    y->data[i] = alpha * tmp + beta * y->data[i];
+    return;
+  }
+
+  T *data;
+  I *col_ind;
+  I *row_ptr;
+  const I *part;
+
+  if ((O == CblasRowMajor && transA == CblasNoTrans) ||
+      (O == CblasColMajor && transA == CblasTrans)) {
+    data = A->val;
+    col_ind = A->ind;
+    row_ptr = A->ptr;
+    part = A->part;
+  } else {
+    data = A->val + A->nnz;
+    col_ind = A->ind + A->nnz;
+    row_ptr = A->ptr + ptr_len(*A);
+    part = spmat_transp_part(A);
+  }
+
+  I size = transA == CblasNoTrans ? A->m : A->n;
+  size_t k = Y->size2;
+  size_t ldx = X->tda, ldy = Y->tda;
+
+  for (size_t c0 = 0; c0 < k; c0 += kSpblasBlk) {
+    size_t nc = std::min(kSpblasBlk, k - c0);
+    const T *x = X->data + c0 * ldx;
+    T *y = Y->data + c0 * ldy;
+    spmat_for_rows(size, part, A->num_parts, [&](I begin, I end) {
+      for (I i = begin; i < end; ++i) {
+        T tmp[kSpblasBlk] = { };
+        for (I j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+          T a_ij = data[j];
+          const T *x_j = x + col_ind[j];
+          for (size_t c = 0; c < nc; ++c)
+            tmp[c] += a_ij * x_j[c * ldx];
+        }
+        for (size_t c = 0; c < nc; ++c) {
+          if (beta == static_cast<T>(0))
+            y[c * ldy + i] = alpha * tmp[c];
+          else
+            y[c * ldy + i] = alpha * tmp[c] + beta * y[c * ldy + i];
+        }
+      }
+    });
   }
 }
 
+// acc[r] := sum_k val[k * kSellC + r] * x[ind[k * kSellC + r]] for the
+// kSellC lanes of a SELL slice. The generic version accumulates each lane
+// in the same order as the CSR loop. With AVX2 (or AVX-512) enabled at
+// compile time, e.g. -march=native, the overloads below process a whole
+// slice column with one gather and one FMA per vector.
+template <typename T, typename I>
+inline void sell_slice(I width, const T *val, const I *ind, const T *x,
+                       T *acc) {
+  for (size_t r = 0; r < kSellC; ++r)
+    acc[r] = static_cast<T>(0);
+  for (I k = 0; k < width; ++k)
+    for (size_t r = 0; r < kSellC; ++r)
+      acc[r] += val[k * kSellC + r] * x[ind[k * kSellC + r]];
 }
 
-#endif  // GSL_SPBLAS_H_
+#if defined(__AVX2__) && defined(__FMA__)
+static_assert(kSellC == 8, "SIMD SELL kernels assume 8 lanes per slice");
 
+inline void sell_slice(int width, const float *val, const int *ind,
+                       const float *x, float *acc) {
+  __m256 sum = _mm256_setzero_ps();
+  for (int k = 0; k < width; ++k) {
+    __m256i j = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(ind + k * kSellC));
+    sum = _mm256_fmadd_ps(_mm256_loadu_ps(val + k * kSellC),
+        _mm256_i32gather_ps(x, j, 4), sum);
+  }
+  _mm256_storeu_ps(acc, sum);
+}
+
+inline void sell_slice(int64_t width, const float *val, const int64_t *ind,
+                       const float *x, float *acc) {
+  __m128 sum_lo = _mm_setzero_ps(), sum_hi = _mm_setzero_ps();
+  for (int64_t k = 0; k < width; ++k) {
+    const __m256i *j = reinterpret_cast<const __m256i*>(ind + k * kSellC);
+    sum_lo = _mm_fmadd_ps(_mm_loadu_ps(val + k * kSellC),
+        _mm256_i64gather_ps(x, _mm256_loadu_si256(j), 4), sum_lo);
+    sum_hi = _mm_fmadd_ps(_mm_loadu_ps(val + k * kSellC + 4),
+        _mm256_i64gather_ps(x, _mm256_loadu_si256(j + 1), 4), sum_hi);
+  }
+  _mm_storeu_ps(acc, sum_lo);
+  _mm_storeu_ps(acc + 4, sum_hi);
+}
+
+#ifdef __AVX512F__
+// The gathers are masked with all lanes set only so that their source is
+// zero: GCC's unmasked form reads an undefined register and warns with
+// -Wmaybe-uninitialized.
+inline void sell_slice(int width, const double *val, const int *ind,
+                       const double *x, double *acc) {
+  __m512d sum = _mm512_setzero_pd();
+  for (int k = 0; k < width; ++k) {
+    __m256i j = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(ind + k * kSellC));
+    sum = _mm512_fmadd_pd(_mm512_loadu_pd(val + k * kSellC),
+        _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xff, j, x, 8), sum);
+  }
+  _mm512_storeu_pd(acc, sum);
+}
+
+inline void sell_slice(int64_t width, const double *val, const int64_t *ind,
+                       const double *x, double *acc) {
+  __m512d sum = _mm512_setzero_pd();
+  for (int64_t k = 0; k < width; ++k) {
+    __m512i j = _mm512_loadu_si512(ind + k * kSellC);
+    sum = _mm512_fmadd_pd(_mm512_loadu_pd(val + k * kSellC),
+        _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xff, j, x, 8), sum);
+  }
+  _mm512_storeu_pd(acc, sum);
+}
+#else
+inline void sell_slice(int width, const double *val, const int *ind,
+                       const double *x, double *acc) {
+  __m256d sum_lo = _mm256_setzero_pd(), sum_hi = _mm256_setzero_pd();
+  for (int k = 0; k < width; ++k) {
+    const __m128i *j = reinterpret_cast<const __m128i*>(ind + k * kSellC);
+    sum_lo = _mm256_fmadd_pd(_mm256_loadu_pd(val + k * kSellC),
+        _mm256_i32gather_pd(x, _mm_loadu_si128(j), 8), sum_lo);
+    sum_hi = _mm256_fmadd_pd(_mm256_loadu_pd(val + k * kSellC + 4),
+        _mm256_i32gather_pd(x, _mm_loadu_si128(j + 1), 8), sum_hi);
+  }
+  _mm256_storeu_pd(acc, sum_lo);
+  _mm256_storeu_pd(acc + 4, sum_hi);
+}
+
+inline void sell_slice(int64_t width, const double *val, const int64_t *ind,
+                       const double *x, double *acc) {
+  __m256d sum_lo = _mm256_setzero_pd(), sum_hi = _mm256_setzero_pd();
+  for (int64_t k = 0; k < width; ++k) {
+    const __m256i *j = reinterpret_cast<const __m256i*>(ind + k * kSellC);
+    sum_lo = _mm256_fmadd_pd(_mm256_loadu_pd(val + k * kSellC),
+        _mm256_i64gather_pd(x, _mm256_loadu_si256(j), 8), sum_lo);
+    sum_hi = _mm256_fmadd_pd(_mm256_loadu_pd(val + k * kSellC + 4),
+        _mm256_i64gather_pd(x, _mm256_loadu_si256(j + 1), 8), sum_hi);
+  }
+  _mm256_storeu_pd(acc, sum_lo);
+  _mm256_storeu_pd(acc + 4, sum_hi);
+}
+#endif  // __AVX512F__
+#endif  // __AVX2__ && __FMA__
+
+// y := alpha * A * x + beta * y for A in SELL-C-sigma format.
+template <typename T, typename I>
+void spblas_gemv(T alpha, const sellmat<T, I> *A, const vector<T> *x, T beta,
+                 vector<T> *y) {
+  spmat_for_rows(A->num_slices, A->part, A->num_parts, [&](I begin, I end) {
+    for (I s = begin; s < end; ++s) {
+      T acc[kSellC];
+      I offset = A->slice_ptr[s];
+      I width = (A->slice_ptr[s + 1] - offset) / static_cast<I>(kSellC);
+      sell_slice(width, A->val + offset, A->ind + offset, x->data, acc);
+      for (size_t r = 0; r < kSellC; ++r) {
+        I i = A->perm[s * kSellC + r];
+        if (i >= A->rows)
+          break;
+        if (beta == static_cast<T>(0))
+          y->data[i] = alpha * acc[r];
+        else
+          y->data[i] = alpha * acc[r] + beta * y->data[i];
+      }
+    }
+  });
+}
+
+}
+
+#endif  // GSL_SPBLAS_H_
@@ -1,23 +1,79 @@
 #ifndef GSL_SPMAT_H_
 #define GSL_SPMAT_H_
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <vector>
 
 #include "gsl/cblas.h"
 
 namespace gsl {
 
+// Sparse matrix in CSR (row major) or CSC (col major) format. If transp is
+// set, the arrays hold the matrix followed by its transpose, otherwise only
+// the matrix itself. part optionally holds num_parts + 1 boundaries of
+// nnz-balanced row (column) ranges for each stored orientation, in the same
+// order, see spmat_partition. Without it the rows are split evenly. work
+// optionally holds work_len elements of scratch for products with the
+// transpose of a single copy, see spblas_scatter.
 template <typename T, typename I, CBLAS_ORDER O>
 struct spmat {
   T *val;
   I *ind, *ptr;
   I m, n, nnz;
-  spmat(T *val, I *ind, I *ptr, I m, I n, I nnz) 
-      : val(val), ind(ind), ptr(ptr), m(m), n(n), nnz(nnz) { }
-  spmat() : val(0), ind(0), m(0), n(0), nnz(0) { };
+  bool transp;
+  const I *part;
+  int num_parts;
+  T *work;
+  size_t work_len;
+  spmat(T *val, I *ind, I *ptr, I m, I n, I nnz, bool transp = true)
+      : val(val), ind(ind), ptr(ptr), m(m), n(n), nnz(nnz), transp(transp),
+        part(0), num_parts(0), work(0), work_len(0) { }
+  spmat()
+      : val(0), ind(0), m(0), n(0), nnz(0), transp(true), part(0),
+        num_parts(0), work(0), work_len(0) { };
 };
 
+// Splits the rows of a CSR matrix into num_parts contiguous ranges
+// [part[t], part[t + 1]) of about nnz / num_parts entries each, so that
+// threads get equal work when row lengths are skewed. A single row is
+// never split.
+template <typename I>
+void spmat_partition(I rows, const I *ptr, int num_parts, I *part) {
+  double nnz = static_cast<double>(ptr[rows] - ptr[0]);
+  part[0] = 0;
+  for (int t = 1; t < num_parts; ++t) {
+    I target = ptr[0] + static_cast<I>(nnz * t / num_parts);
+    part[t] = static_cast<I>(std::lower_bound(ptr, ptr + rows + 1, target) -
+        ptr);
+  }
+  part[num_parts] = rows;
+}
+
+// Calls f(begin, end) in parallel for the row ranges of part, or for each
+// row in [0, rows) if part is null.
+template <typename I, typename F>
+void spmat_for_rows(I rows, const I *part, int num_parts, const F& f) {
+  if (part) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+    for (int t = 0; t < num_parts; ++t)
+      f(part[t], part[t + 1]);
+  } else {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (I i = 0; i < rows; ++i)
+      f(i, i + 1);
+  }
+}
+
 template <typename T, typename I, CBLAS_ORDER O>
 I ptr_len(const spmat<T, I, O> &mat) {
   if (O == CblasColMajor)
@@ -28,30 +84,92 @@ I ptr_len(const spmat<T, I, O> &mat) {
 
 namespace {
 
+// Transposes the m x n CSR matrix (a, row_ptr, col_ind) into CSC format,
+// with the rows of each column in increasing order. The rows are split
+// into nnz-balanced ranges, one per thread. Each thread counts the columns
+// of its range, a scan over the counts gives every thread its offset
+// within each column and a scan over the columns gives col_ptr, then each
+// thread scatters its range. The output does not depend on the number of
+// threads. The counts take one index per column and thread, so at most
+// nnz / n threads are used.
 template <typename T, typename I>
 void csr2csc(I m, I n, I nnz, const T *a, const I *row_ptr, const I *col_ind,
              T *at, I *row_ind, I *col_ptr) {
-  memset(col_ptr, 0, (n + 1) * sizeof(I));
-
-  for (I i = 0; i < nnz; i++)
-    col_ptr[col_ind[i] + 1]++;
-
-  for (I i = 0; i < n; i++)
-    col_ptr[i + 1] += col_ptr[i];
+  int num_threads = 1;
+#ifdef _OPENMP
+  num_threads = static_cast<int>(std::max<I>(1, std::min<I>(
+      omp_get_max_threads(), nnz / std::max<I>(n, 1))));
+#endif
+  std::vector<I> part(num_threads + 1);
+  spmat_partition(m, row_ptr, num_threads, part.data());
+
+  // count[t * n + j] := number of entries of thread t in column j.
+  std::vector<I> count(static_cast<size_t>(num_threads) * n, 0);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+#endif
+  for (int t = 0; t < num_threads; ++t) {
+    I *count_t = count.data() + static_cast<size_t>(t) * n;
+    for (I l = row_ptr[part[t]]; l < row_ptr[part[t + 1]]; ++l)
+      ++count_t[col_ind[l]];
+  }
 
-  for (I i = 0; i < m; i++) {
-    for (I j = row_ptr[i]; j < row_ptr[i + 1]; j++) {
-      I k = col_ind[j];
-      I l = col_ptr[k]++;
-      row_ind[l] = i;
-      at[l] = a[j];
+  // count[t * n + j] := offset of thread t within column j and
+  // col_ptr[j + 1] := number of entries in column j.
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads)
+#endif
+  for (I j = 0; j < n; ++j) {
+    I sum = 0;
+    for (int t = 0; t < num_threads; ++t) {
+      I c = count[static_cast<size_t>(t) * n + j];
+      count[static_cast<size_t>(t) * n + j] = sum;
+      sum += c;
     }
+    col_ptr[j + 1] = sum;
   }
 
-  for (I i = n; i > 0; i--)
-    col_ptr[i] = col_ptr[i - 1];
-
+  // Cumulative sum of col_ptr, scanning blocks of columns in parallel and
+  // then adding the totals of the preceding blocks.
   col_ptr[0] = 0;
+  std::vector<I> block_sum(num_threads + 1, 0);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+#endif
+  for (int t = 0; t < num_threads; ++t) {
+    I begin = static_cast<I>(static_cast<size_t>(n) * t / num_threads);
+    I end = static_cast<I>(static_cast<size_t>(n) * (t + 1) / num_threads);
+    for (I j = begin + 1; j < end; ++j)
+      col_ptr[j + 1] += col_ptr[j];
+    block_sum[t + 1] = begin < end ? col_ptr[end] : 0;
+  }
+  for (int t = 0; t < num_threads; ++t)
+    block_sum[t + 1] += block_sum[t];
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+#endif
+  for (int t = 1; t < num_threads; ++t) {
+    I begin = static_cast<I>(static_cast<size_t>(n) * t / num_threads);
+    I end = static_cast<I>(static_cast<size_t>(n) * (t + 1) / num_threads);
+    for (I j = begin; j < end; ++j)
+      col_ptr[j + 1] += block_sum[t];
+  }
+
+  // Each thread fills its slots of every column in row order.
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+#endif
+  for (int t = 0; t < num_threads; ++t) {
+    I *count_t = count.data() + static_cast<size_t>(t) * n;
+    for (I i = part[t]; i < part[t + 1]; ++i) {
+      for (I l = row_ptr[i]; l < row_ptr[i + 1]; ++l) {
+        I k = col_ind[l];
+        I pos = col_ptr[k] + count_t[k]++;
+        row_ind[pos] = i;
+        at[pos] = a[l];
+      }
+    }
+  }
 }
 
 template <typename T, typename I, CBLAS_ORDER O>
@@ -88,8 +206,9 @@ void spmat_memcpy(spmat<T, I, O> *A,
   memcpy(A->val, val, A->nnz * sizeof(T));
   memcpy(A->ind, ind, A->nnz * sizeof(I));
   memcpy(A->ptr, ptr, ptr_len(*A) * sizeof(I));
-  MatTransp<T, I, O>(A->m, A->n, A->nnz, A->val, A->ptr, A->ind,
-      A->val + A->nnz, A->ind + A->nnz, A->ptr + ptr_len(*A));
+  if (A->transp)
+    MatTransp<T, I, O>(A->m, A->n, A->nnz, A->val, A->ptr, A->ind,
+        A->val + A->nnz, A->ind + A->nnz, A->ptr + ptr_len(*A));
 }
 
 }  // namespace
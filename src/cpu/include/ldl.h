@@ -0,0 +1,254 @@
+#ifndef LDL_H_
+#define LDL_H_
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace ldl {
+
+// Approximate minimum degree ordering of a symmetric matrix, whose pattern
+// is given in CSC format with both triangles and without the diagonal.
+// Eliminated nodes are kept as elements of a quotient graph, so that fill
+// is never formed explicitly, and degrees are the approximate external
+// degrees of Amestoy, Davis and Duff (without supervariable detection).
+// Ties are broken by index. On exit perm[k] is the k-th node eliminated.
+template <typename I>
+void MinDegree(I n, const I *ptr, const I *ind, I *perm) {
+  // Adjacent variables and elements of each variable, variables of each
+  // element. An element is absorbed once it is a subset of a newer one.
+  std::vector<std::vector<I> > vars(n), elems(n), elem_vars(n);
+  std::vector<bool> done(n, false), absorbed(n, false);
+  std::vector<I> degree(n), mark(n, -1), w(n, -1), w_mark(n, -1);
+  std::set<std::pair<I, I> > queue;
+  for (I j = 0; j < n; ++j) {
+    vars[j].assign(ind + ptr[j], ind + ptr[j + 1]);
+    degree[j] = static_cast<I>(vars[j].size());
+    queue.insert(std::make_pair(degree[j], j));
+  }
+
+  for (I k = 0; k < n; ++k) {
+    I p = queue.begin()->second;
+    queue.erase(queue.begin());
+    perm[k] = p;
+    done[p] = true;
+
+    // L_p, the variables adjacent to p directly or through its elements,
+    // which are absorbed into the new element p.
+    std::vector<I> &Lp = elem_vars[p];
+    mark[p] = p;
+    for (size_t t = 0; t < elems[p].size(); ++t) {
+      I e = elems[p][t];
+      if (absorbed[e])
+        continue;
+      for (size_t l = 0; l < elem_vars[e].size(); ++l) {
+        I i = elem_vars[e][l];
+        if (mark[i] != p) {
+          mark[i] = p;
+          Lp.push_back(i);
+        }
+      }
+      absorbed[e] = true;
+      std::vector<I>().swap(elem_vars[e]);
+    }
+    for (size_t t = 0; t < vars[p].size(); ++t) {
+      I i = vars[p][t];
+      if (!done[i] && mark[i] != p) {
+        mark[i] = p;
+        Lp.push_back(i);
+      }
+    }
+    std::vector<I>().swap(vars[p]);
+    std::vector<I>().swap(elems[p]);
+
+    // w(e) = |L_e \ L_p| for the elements adjacent to L_p.
+    for (size_t t = 0; t < Lp.size(); ++t) {
+      const std::vector<I> &elems_i = elems[Lp[t]];
+      for (size_t l = 0; l < elems_i.size(); ++l) {
+        I e = elems_i[l];
+        if (absorbed[e])
+          continue;
+        if (w_mark[e] != p) {
+          w_mark[e] = p;
+          w[e] = static_cast<I>(elem_vars[e].size());
+        }
+        --w[e];
+      }
+    }
+
+    // Prune the lists of each i in L_p and bound its external degree.
+    I len_p = static_cast<I>(Lp.size());
+    for (size_t t = 0; t < Lp.size(); ++t) {
+      I i = Lp[t];
+      queue.erase(std::make_pair(degree[i], i));
+
+      std::vector<I> &elems_i = elems[i];
+      I deg = len_p - 1;
+      size_t len = 0;
+      for (size_t l = 0; l < elems_i.size(); ++l) {
+        I e = elems_i[l];
+        if (absorbed[e])
+          continue;
+        if (w[e] == 0) {
+          // L_e is a subset of L_p.
+          absorbed[e] = true;
+          std::vector<I>().swap(elem_vars[e]);
+          continue;
+        }
+        deg += w[e];
+        elems_i[len++] = e;
+      }
+      elems_i.resize(len);
+      elems_i.push_back(p);
+
+      // Variables in L_p are now reached through p.
+      std::vector<I> &vars_i = vars[i];
+      len = 0;
+      for (size_t l = 0; l < vars_i.size(); ++l) {
+        I j = vars_i[l];
+        if (!done[j] && mark[j] != p)
+          vars_i[len++] = j;
+      }
+      vars_i.resize(len);
+      deg += static_cast<I>(len);
+
+      deg = std::min(deg, degree[i] + len_p - 1);
+      degree[i] = std::min(deg, n - k - 2);
+      queue.insert(std::make_pair(degree[i], i));
+    }
+  }
+}
+
+// Sparse LDL' factorization without pivoting, for matrices whose leading
+// minors are all nonsingular, such as quasi-definite matrices. The
+// constructor does the symbolic analysis of the upper triangle of A (CSC
+// format), Factor computes the numeric factor into caller owned arrays, so
+// that several factors of matrices with the same pattern can share the
+// analysis. Any fill-reducing permutation must be applied to A beforehand.
+template <typename T, typename I>
+class Ldl {
+ public:
+  Ldl(I n, const I *ptr, const I *ind);
+
+  I Size() const { return _n; }
+
+  // Number of off-diagonal entries of L.
+  I Nnz() const { return _Lp[_n]; }
+
+  // Computes L (values only, Nnz() entries) and D (n entries) from the
+  // values val of the upper triangle. Returns k + 1 if the k-th pivot is
+  // zero and 0 on success.
+  I Factor(const T *val, T *Lx, T *D) const;
+
+  // x := (L D L')^{-1} x.
+  void Solve(const T *Lx, const T *D, T *x) const;
+
+ private:
+  I _n;
+  const I *_ptr, *_ind;
+  std::vector<I> _Lp, _Li, _parent;
+};
+
+// Elimination tree and column counts, followed by the pattern of L. Row k of
+// L is the set of nodes reached by walking up the tree from the entries of
+// column k of A, and is appended to the columns of L in increasing k.
+template <typename T, typename I>
+Ldl<T, I>::Ldl(I n, const I *ptr, const I *ind)
+    : _n(n), _ptr(ptr), _ind(ind), _Lp(n + 1), _parent(n) {
+  std::vector<I> flag(n), lnz(n);
+  for (I k = 0; k < n; ++k) {
+    _parent[k] = -1;
+    flag[k] = k;
+    lnz[k] = 0;
+    for (I p = ptr[k]; p < ptr[k + 1]; ++p) {
+      for (I i = ind[p]; i < k && flag[i] != k; i = _parent[i]) {
+        if (_parent[i] == -1)
+          _parent[i] = k;
+        ++lnz[i];
+        flag[i] = k;
+      }
+    }
+  }
+  _Lp[0] = 0;
+  for (I k = 0; k < n; ++k)
+    _Lp[k + 1] = _Lp[k] + lnz[k];
+
+  _Li.resize(_Lp[n]);
+  for (I k = 0; k < n; ++k) {
+    flag[k] = k;
+    lnz[k] = 0;
+    for (I p = ptr[k]; p < ptr[k + 1]; ++p) {
+      for (I i = ind[p]; i < k && flag[i] != k; i = _parent[i]) {
+        _Li[_Lp[i] + lnz[i]++] = k;
+        flag[i] = k;
+      }
+    }
+  }
+}
+
+// Up-looking factorization, row k of L is found by a sparse triangular solve
+// with the first k rows.
+template <typename T, typename I>
+I Ldl<T, I>::Factor(const T *val, T *Lx, T *D) const {
+  std::vector<T> y(_n, static_cast<T>(0));
+  std::vector<I> flag(_n), pattern(_n), lnz(_n, 0);
+  for (I k = 0; k < _n; ++k) {
+    // Scatter column k of A into y and find the pattern of row k of L in
+    // topological order.
+    I top = _n;
+    flag[k] = k;
+    for (I p = _ptr[k]; p < _ptr[k + 1]; ++p) {
+      I i = _ind[p];
+      y[i] += val[p];
+      I len = 0;
+      for (; i < k && flag[i] != k; i = _parent[i]) {
+        pattern[len++] = i;
+        flag[i] = k;
+      }
+      while (len > 0)
+        pattern[--top] = pattern[--len];
+    }
+
+    T d = y[k];
+    y[k] = static_cast<T>(0);
+    for (; top < _n; ++top) {
+      I i = pattern[top];
+      T y_i = y[i];
+      y[i] = static_cast<T>(0);
+      I p_end = _Lp[i] + lnz[i];
+      for (I p = _Lp[i]; p < p_end; ++p)
+        y[_Li[p]] -= Lx[p] * y_i;
+      T l_ki = y_i / D[i];
+      d -= l_ki * y_i;
+      Lx[p_end] = l_ki;
+      ++lnz[i];
+    }
+    if (d == static_cast<T>(0))
+      return k + 1;
+    D[k] = d;
+  }
+  return 0;
+}
+
+template <typename T, typename I>
+void Ldl<T, I>::Solve(const T *Lx, const T *D, T *x) const {
+  for (I j = 0; j < _n; ++j) {
+    T x_j = x[j];
+    for (I p = _Lp[j]; p < _Lp[j + 1]; ++p)
+      x[_Li[p]] -= Lx[p] * x_j;
+  }
+  for (I j = 0; j < _n; ++j)
+    x[j] /= D[j];
+  for (I j = _n; j-- > 0; ) {
+    T x_j = x[j];
+    for (I p = _Lp[j]; p < _Lp[j + 1]; ++p)
+      x_j -= Lx[p] * x[_Li[p]];
+    x[j] = x_j;
+  }
+}
+
+}  // namespace ldl
+
+#endif  // LDL_H_
+
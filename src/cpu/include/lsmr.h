@@ -0,0 +1,305 @@
+//  LSMR Least Squares Minimal Residual
+//  Attempts to solve the damped least squares problem
+//
+//    min. ||Ax - b||_2^2 + s ||x||_2^2
+//
+//  by applying LSMR (Fong and Saunders, 2011) to the augmented system
+//  [A; sqrt(s) I] x = [b; 0]. Unlike CGLS, the norm of the normal equation
+//  residual ||A'(b - Ax) - s x|| decreases monotonically, which makes LSMR
+//  safer to stop early on ill-conditioned problems.
+//
+//  Template Arguments:
+//  T          - Data type (float or double).
+//
+//  F          - Generic GEMV-like functor, see cgls::Gemv.
+//
+//  Function Arguments:
+//  A          - Operator that computes Ax and A^Tx.
+//
+//  (m, n)     - Matrix dimensions of A.
+//
+//  b          - Pointer to right-hand-side vector.
+//
+//  x          - Pointer to solution. This vector will also be used as an
+//               initial guess, so it must be initialized (eg. to 0).
+//
+//  shift      - Regularization parameter s. Solves (A'*A + shift*I)*x = A'*b.
+//
+//  tol        - Stops once ||A'(b - Ax) - s x|| <= tol * norms0, the same
+//               criterion as cgls::Solve.
+//
+//  maxit      - Maximum number of iterations.
+//
+//  quiet      - Disable printing to console.
+//
+//  norms_ref  - (Optional) If positive, used as norms0 instead of the initial
+//               residual, see cgls::Solve.
+//
+//  iter       - (Optional) Number of iterations taken.
+//
+//  work       - (Optional) Caller owned workspace.
+//
+//  Returns:
+//  0 : LSMR converged to the desired tolerance tol within maxit iterations.
+//  1 : The initial residual had norm less than eps, solution likely x = 0.
+//  2 : LSMR iterated maxit times but did not converge.
+//  3 : Breakdown of the bidiagonalization.
+//  5 : Error in applying operator A.
+//  6 : Error in applying operator A^T.
+//
+//  Reference:
+//  http://web.stanford.edu/group/SOL/software/lsmr/
+//
+
+#ifndef LSMR_H_
+#define LSMR_H_
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "cgls.h"
+
+namespace lsmr {
+
+using cgls::INT;
+
+// Workspace for Solve, with room for the vectors of an m x n problem.
+template <typename T>
+class Workspace {
+ public:
+  Workspace() : _m(0), _n(0) { }
+
+  void Reserve(INT m, INT n) {
+    if (m <= _m && n <= _n)
+      return;
+    _m = std::max(m, _m);
+    _n = std::max(n, _n);
+    _data.resize(4 * static_cast<size_t>(_n) + static_cast<size_t>(_m));
+  }
+
+  // Vectors u2, v, h and hbar of length n, u1 of length m.
+  T* Vec(int i) {
+    return _data.data() + (i < 4 ? i * static_cast<size_t>(_n) :
+        4 * static_cast<size_t>(_n));
+  }
+
+ private:
+  INT _m, _n;
+  std::vector<T> _data;
+};
+
+namespace {
+
+// u2 := lambda*v - c*u2, returns ||u2||^2.
+template <typename T>
+double UpdateU2(INT n, T lambda, T c, const T *v, T *u2) {
+  double nrm2 = 0.;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nrm2)
+#endif
+  for (INT i = 0; i < n; ++i) {
+    T u_i = lambda * v[i] - c * u2[i];
+    u2[i] = u_i;
+    nrm2 += static_cast<double>(u_i) * u_i;
+  }
+  return nrm2;
+}
+
+// v := v + c*u2, returns ||v||^2.
+template <typename T>
+double UpdateV(INT n, T c, const T *u2, T *v) {
+  double nrm2 = 0.;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nrm2)
+#endif
+  for (INT i = 0; i < n; ++i) {
+    T v_i = v[i] + c * u2[i];
+    v[i] = v_i;
+    nrm2 += static_cast<double>(v_i) * v_i;
+  }
+  return nrm2;
+}
+
+// Scales v by inv_alpha and updates hbar, x and h in one sweep. Returns
+// ||x||^2.
+template <typename T>
+double UpdateX(INT n, T inv_alpha, T c_hbar, T c_x, T c_h, T *v, T *h,
+               T *hbar, T *x) {
+  double nrm2 = 0.;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nrm2)
+#endif
+  for (INT i = 0; i < n; ++i) {
+    T v_i = v[i] * inv_alpha;
+    T hbar_i = h[i] - c_hbar * hbar[i];
+    T x_i = x[i] + c_x * hbar_i;
+    v[i] = v_i;
+    hbar[i] = hbar_i;
+    x[i] = x_i;
+    h[i] = v_i - c_h * h[i];
+    nrm2 += static_cast<double>(x_i) * x_i;
+  }
+  return nrm2;
+}
+
+}  // namespace
+
+// The vector u of the bidiagonalization is kept unnormalized, with norm
+// beta, so that the normalization folds into the next matvec.
+template <typename T, typename F>
+int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
+          const double shift, const double tol, const int maxit, bool quiet,
+          double norms_ref, int *iter, Workspace<T> *work) {
+  char fmt[] = "%5d %9.2e %12.5g\n";
+  int err = 0, k = 0, flag = 0;
+
+  const T kNegOne   = static_cast<T>(-1.);
+  const T kZero     = static_cast<T>( 0.);
+  const T kOne      = static_cast<T>( 1.);
+  const double kEps = std::numeric_limits<T>::epsilon();
+  const double lambda = std::sqrt(shift);
+
+  work->Reserve(m, n);
+  T *u2 = work->Vec(0);
+  T *v = work->Vec(1);
+  T *h = work->Vec(2);
+  T *hbar = work->Vec(3);
+  T *u1 = work->Vec(4);
+
+  gsl::vector<T> x_vec = gsl::vector_view_array(x, n);
+  gsl::vector<T> u1_vec = gsl::vector_view_array(u1, m);
+
+  // u = [b - A*x; -lambda*x].
+  memcpy(u1, b, m * sizeof(T));
+  double normx = gsl::blas_nrm2(&x_vec);
+  if (normx > 0.) {
+    err = A('n', kNegOne, x, kOne, u1);
+    if (err)
+      flag = 5;
+  }
+  memset(u2, 0, n * sizeof(T));
+  double beta = std::sqrt(std::pow(gsl::blas_nrm2(&u1_vec), 2) +
+      UpdateU2(n, static_cast<T>(-lambda), kZero, x, u2));
+
+  // v = [A' lambda*I] * u / beta.
+  double alpha = 0.;
+  if (beta > 0.) {
+    err = A('t', static_cast<T>(1. / beta), u1, kZero, v);
+    if (err)
+      flag = 6;
+    alpha = std::sqrt(UpdateV(n, static_cast<T>(lambda / beta), u2, v));
+  } else {
+    memset(v, 0, n * sizeof(T));
+  }
+  T inv_alpha = static_cast<T>(alpha > 0. ? 1. / alpha : 0.);
+  for (INT i = 0; i < n; ++i) {
+    v[i] *= inv_alpha;
+    h[i] = v[i];
+    hbar[i] = kZero;
+  }
+
+  double alphabar = alpha, zetabar = alpha * beta, rho = 1., rhobar = 1.;
+  double cbar = 1., sbar = 0.;
+  double normar = zetabar;
+  double norms0 = norms_ref > 0. ? norms_ref : normar;
+
+  if (normar < kEps)
+    flag = 1;
+
+  // A warm start may already be accurate enough.
+  bool done = normar <= norms0 * tol;
+
+  if (!quiet)
+    printf("    k     normx        resNE\n");
+
+  for (k = 0; k < maxit && !flag && !done; ++k) {
+    // u := A*v - alpha*u.
+    T c_u = static_cast<T>(alpha / beta);
+    err = A('n', kOne, v, -c_u, u1);
+    if (err) {
+      flag = 5;
+      break;
+    }
+    beta = std::sqrt(std::pow(gsl::blas_nrm2(&u1_vec), 2) +
+        UpdateU2(n, static_cast<T>(lambda), c_u, v, u2));
+
+    // v := A'*u - beta*v, normalized in UpdateX.
+    if (beta > 0.) {
+      err = A('t', static_cast<T>(1. / beta), u1, static_cast<T>(-beta), v);
+      if (err) {
+        flag = 6;
+        break;
+      }
+      alpha = std::sqrt(UpdateV(n, static_cast<T>(lambda / beta), u2, v));
+    } else {
+      alpha = 0.;
+    }
+
+    // Plane rotations.
+    double rho_old = rho;
+    rho = std::hypot(alphabar, beta);
+    if (rho == 0.) {
+      flag = 3;
+      break;
+    }
+    double c = alphabar / rho;
+    double s = beta / rho;
+    double theta_new = s * alpha;
+    alphabar = c * alpha;
+
+    double rhobar_old = rhobar;
+    double thetabar = sbar * rho;
+    double rho_temp = cbar * rho;
+    rhobar = std::hypot(rho_temp, theta_new);
+    if (rhobar == 0.) {
+      flag = 3;
+      break;
+    }
+    cbar = rho_temp / rhobar;
+    sbar = theta_new / rhobar;
+    double zeta = cbar * zetabar;
+    zetabar = -sbar * zetabar;
+
+    // hbar := h - c_hbar*hbar, x := x + c_x*hbar, h := v - c_h*h.
+    inv_alpha = static_cast<T>(alpha > 0. ? 1. / alpha : 0.);
+    normx = std::sqrt(UpdateX(n, inv_alpha,
+        static_cast<T>(thetabar * rho / (rho_old * rhobar_old)),
+        static_cast<T>(zeta / (rho * rhobar)),
+        static_cast<T>(theta_new / rho), v, h, hbar, x));
+
+    // Convergence check, |zetabar| = ||A'(b - Ax) - s x||.
+    normar = std::fabs(zetabar);
+    bool converged = (normar <= norms0 * tol) || (normx * tol >= 1.);
+    if (!quiet && (converged || k % 10 == 0))
+      printf(fmt, k, normx, normar / norms0);
+    if (converged)
+      break;
+  }
+
+  if (k == maxit)
+    flag = 2;
+
+  if (iter)
+    *iter = k;
+
+  return flag;
+}
+
+template <typename T, typename F>
+int Solve(const F& A, const INT m, const INT n, const T *b, T *x,
+          const double shift, const double tol, const int maxit, bool quiet,
+          double norms_ref, int *iter) {
+  Workspace<T> work;
+  return Solve(A, m, n, b, x, shift, tol, maxit, quiet, norms_ref, iter,
+      &work);
+}
+
+}  // namespace lsmr
+
+#endif  // LSMR_H_
+
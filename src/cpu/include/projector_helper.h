@@ -1,9 +1,16 @@
 #ifndef PROJECTOR_HELPER_H_
 #define PROJECTOR_HELPER_H_
 
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "cgls.h"
 #include "gsl/gsl_blas.h" 
 #include "gsl/gsl_vector.h" 
 #include "matrix/matrix.h" 
+#include "projector/projector.h"
 #include "util.h" 
 
 namespace pogs {
@@ -40,6 +47,99 @@ void CheckProjection(const Matrix<T> *A, const T *x0, const T *y0,
   gsl::vector_free(&y_);
 }
 
+// Gemv for the Krylov solvers, counts the products with A.
+template <typename T, typename M>
+struct CountingGemv : cgls::Gemv<T> {
+  const M& A;
+  unsigned int *matvecs;
+  CountingGemv(const M& A, unsigned int *matvecs) : A(A), matvecs(matvecs) { }
+  int operator()(char op, const T alpha, const T *x, const T beta, T *y)
+      const {
+    ++*matvecs;
+    return A.Mul(op, alpha, x, beta, y);
+  }
+};
+
+// Cumulative statistics of a Krylov projector. Atomic, since sessions
+// sharing the projector may project concurrently.
+struct KrylovCounters {
+  std::atomic<unsigned int> projections, iters, matvecs;
+  KrylovCounters() : projections(0), iters(0), matvecs(0) { }
+  KrylovStats Get() const {
+    KrylovStats stats = { projections, iters, matvecs };
+    return stats;
+  }
+};
+
+// Warm start of one session of a Krylov projector: the previous solution and
+// scratch for the cold start residual.
+template <typename T>
+struct KrylovWarmStart {
+  std::vector<T> x_prev, s0;
+};
+
+// Sets up the least squares problem min ||Ax - b||_2^2 + s||x||_2^2 with
+// b = y0 - Ax0 (stored in y), whose solution plus x0 is the projection. The
+// initial x is the previous solution in ws shifted by x0 if warm_start, and
+// zero otherwise. Returns the reference for the tolerance of the solver,
+// ||A'b|| for a warm start and 0 (relative to the initial residual) for a
+// cold start. Adds the products with A to *matvecs.
+template <typename T, typename M>
+double KrylovBegin(const M& A, bool warm_start, const T *x0, const T *y0,
+                   T *x, T *y, KrylovWarmStart<T> *ws,
+                   unsigned int *matvecs) {
+  size_t m = A.Rows();
+  size_t n = A.Cols();
+
+  // y := y0 - Ax0;
+  memcpy(y, y0, m * sizeof(T));
+  A.Mul('n', static_cast<T>(-1.), x0, static_cast<T>(1.), y);
+  ++*matvecs;
+
+  // The tolerance of a warm start is relative to the cold start residual
+  // ||A'(y0 - Ax0)||, at the cost of one extra matvec.
+  double norms_ref = 0.;
+  if (warm_start && ws->x_prev.size() == n) {
+    const T *x_prev = ws->x_prev.data();
+    for (size_t i = 0; i < n; ++i)
+      x[i] = x_prev[i] - x0[i];
+    ws->s0.resize(n);
+    A.Mul('t', static_cast<T>(1.), y, static_cast<T>(0.), ws->s0.data());
+    ++*matvecs;
+    gsl::vector<T> s0_vec = gsl::vector_view_array(ws->s0.data(), n);
+    norms_ref = gsl::blas_nrm2(&s0_vec);
+  }
+  if (!(norms_ref > std::numeric_limits<T>::epsilon())) {
+    memset(x, 0, n * sizeof(T));
+    norms_ref = 0.;
+  }
+  return norms_ref;
+}
+
+// Completes the projection started by KrylovBegin once the solver has
+// returned x: sets x := x + x0 and y := Ax, saves x in ws if warm_start and
+// updates the counters.
+template <typename T, typename M>
+void KrylovEnd(const M& A, bool warm_start, const T *x0, T *x, T *y,
+               KrylovWarmStart<T> *ws, int iter, unsigned int matvecs,
+               KrylovCounters *counters) {
+  size_t n = A.Cols();
+
+  // x := x + x0
+  gsl::vector<T> x_vec = gsl::vector_view_array(x, n);
+  const gsl::vector<T> x0_vec = gsl::vector_view_array(x0, n);
+  gsl::blas_axpy(static_cast<T>(1.), &x0_vec, &x_vec);
+  if (warm_start)
+    ws->x_prev.assign(x, x + n);
+
+  // y := Ax
+  A.Mul('n', static_cast<T>(1.), x, static_cast<T>(0.), y);
+
+  ++counters->projections;
+  counters->iters += static_cast<unsigned int>(iter);
+  counters->matvecs += matvecs + 1;
+}
+
 }  // namespace
 }  // namespace pogs
 
@@ -68,6 +68,11 @@ MatrixDense<T>::~MatrixDense() {
   CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
   delete info;
   this->_info = 0;
+
+  if (this->_done_init && _data) {
+    delete [] _data;
+    _data = 0;
+  }
 }
 
 template <typename T>
@@ -110,6 +115,38 @@ int MatrixDense<T>::Mul(char trans, T alpha, const T *x, T beta, T *y) const {
   return 0;
 }
 
+template <typename T>
+int MatrixDense<T>::MulBatch(char trans, size_t k, T alpha, const T *x,
+                             size_t ldx, T beta, T *y, size_t ldy) const {
+  DEBUG_EXPECT(this->_done_init);
+  if (!this->_done_init)
+    return 1;
+
+  bool no_trans = trans == 'n' || trans == 'N';
+  size_t x_size = no_trans ? this->_n : this->_m;
+  size_t y_size = no_trans ? this->_m : this->_n;
+
+  const gsl::matrix<T, CblasColMajor> x_mat =
+      gsl::matrix_view_array<T, CblasColMajor>(x, x_size, k, ldx);
+  gsl::matrix<T, CblasColMajor> y_mat =
+      gsl::matrix_view_array<T, CblasColMajor>(y, y_size, k, ldy);
+
+  // A row major matrix is the transpose of its column major view.
+  if (_ord == ROW) {
+    const gsl::matrix<T, CblasColMajor> At =
+        gsl::matrix_view_array<T, CblasColMajor>(_data, this->_n, this->_m);
+    gsl::blas_gemm(no_trans ? CblasTrans : CblasNoTrans, CblasNoTrans, alpha,
+        &At, &x_mat, beta, &y_mat);
+  } else {
+    const gsl::matrix<T, CblasColMajor> A =
+        gsl::matrix_view_array<T, CblasColMajor>(_data, this->_m, this->_n);
+    gsl::blas_gemm(OpToCblasOp(trans), CblasNoTrans, alpha, &A, &x_mat, beta,
+        &y_mat);
+  }
+
+  return 0;
+}
+
 template <typename T>
 int MatrixDense<T>::Equil(T *d, T *e) {
   DEBUG_ASSERT(this->_done_init);
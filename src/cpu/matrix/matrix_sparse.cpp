@@ -1,3 +1,12 @@
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "gsl/gsl_sellmat.h"
 #include "gsl/gsl_spblas.h"
 #include "gsl/gsl_spmat.h"
 #include "gsl/gsl_vector.h"
@@ -17,59 +26,260 @@ namespace {
 const NormTypes kNormEquilibrate = kNorm2; 
 const NormTypes kNormNormalize   = kNormFro; 
 
-template <typename T>
+// nnz-balanced row ranges of each stored orientation, one per thread (see
+// gsl::spmat_partition), SELL-C-sigma copies of A in its own order
+// (sell[0]) and of the stored transpose (sell[1]), used by Mul once
+// sell_ready is set, and the permutations applied if reorder is set.
+// Without the transpose, products with it scatter into scatter, which is
+// sized for Mul in Init and lent to one product at a time.
+template <typename T, typename I>
 struct CpuData {
   const T *orig_data;
-  const POGS_INT *orig_ptr, *orig_ind;
-  CpuData(const T *data, const POGS_INT *ptr, const POGS_INT *ind)
-      : orig_data(data), orig_ptr(ptr), orig_ind(ind) { }
+  const I *orig_ptr, *orig_ind;
+  std::vector<I> part;
+  int num_parts;
+  bool use_sell, sell_ready, reorder;
+  gsl::sellmat<T, I> sell[2];
+  std::vector<size_t> row_perm, col_perm;
+  std::vector<T> scatter;
+  std::atomic<bool> scatter_busy;
+  CpuData(const T *data, const I *ptr, const I *ind, bool use_sell,
+          bool reorder)
+      : orig_data(data), orig_ptr(ptr), orig_ind(ind), num_parts(1),
+        use_sell(use_sell), sell_ready(false), reorder(reorder),
+        scatter_busy(false) { }
+  ~CpuData() {
+    gsl::sellmat_free(&sell[0]);
+    gsl::sellmat_free(&sell[1]);
+  }
 };
 
+// Lends the scatter buffer to A, unless another product is using it, in
+// which case A is left without one and spblas_scatter allocates. Returns
+// true if the buffer must be given back with ReleaseScatter.
+template <typename T, typename I, CBLAS_ORDER O>
+bool AcquireScatter(CpuData<T, I> *info, gsl::spmat<T, I, O> *A) {
+  if (info->scatter.empty() || info->scatter_busy.exchange(true))
+    return false;
+  A->work = info->scatter.data();
+  A->work_len = info->scatter.size();
+  return true;
+}
+
+template <typename T, typename I>
+void ReleaseScatter(CpuData<T, I> *info, bool acquired) {
+  if (acquired)
+    info->scatter_busy.store(false);
+}
+
+// Builds the SELL copies of the stored orientations, or only copies new
+// values if build is false. Orientation h is a CSR matrix with rows[h] rows
+// whose values and indices start at h * nnz.
+template <typename T, typename I>
+void UpdateSell(CpuData<T, I> *info, bool build, I m, I n, I nnz,
+                typename MatrixSparse<T, I>::Ord ord, bool transpose,
+                const T *data, const I *ind, const I *ptr) {
+  I rows[2] = { ord == MatrixSparse<T, I>::ROW ? m : n,
+                ord == MatrixSparse<T, I>::ROW ? n : m };
+  const I *ptr_h = ptr;
+  for (int h = 0; h < (transpose ? 2 : 1); ++h) {
+    if (build)
+      info->sell[h] = gsl::sellmat_from_csr(rows[h], rows[1 - h],
+          data + h * nnz, ptr_h, ind + h * nnz, info->num_parts);
+    else
+      gsl::sellmat_copy_val(&info->sell[h], data + h * nnz, ptr_h);
+    ptr_h += rows[h] + 1;
+  }
+  info->sell_ready = true;
+}
+
+// Reverse Cuthill-McKee ordering of the bipartite graph whose nodes are the
+// rows and columns of the rows x cols pattern (ptr, ind), given in CSR
+// format along with its transpose (ptr_t, ind_t). Each component is
+// searched from a pseudo-peripheral node (George and Liu) and neighbours
+// are visited by increasing degree, ties broken by index. On exit row i
+// (column j) of the reordered matrix is row row_perm[i] (column
+// col_perm[j]).
+template <typename I>
+void BipartiteRcm(I rows, I cols, const I *ptr, const I *ind, const I *ptr_t,
+                  const I *ind_t, size_t *row_perm, size_t *col_perm) {
+  // Node v < rows is row v and node rows + j is column j.
+  size_t num_rows = rows;
+  size_t num_nodes = num_rows + cols;
+  auto degree = [&](size_t v) {
+    return v < num_rows ? ptr[v + 1] - ptr[v] :
+        ptr_t[v - num_rows + 1] - ptr_t[v - num_rows];
+  };
+  auto by_degree = [&](size_t a, size_t b) {
+    return degree(a) < degree(b) || (degree(a) == degree(b) && a < b);
+  };
+
+  // Appends the nodes reachable from root to queue in breadth-first order.
+  // Returns the number of levels, and the start of the last in last_level.
+  std::vector<size_t> mark(num_nodes, 0);
+  size_t stamp = 0;
+  auto bfs = [&](size_t root, std::vector<size_t> *queue,
+                 size_t *last_level) {
+    ++stamp;
+    mark[root] = stamp;
+    size_t head = queue->size(), level_end = head + 1, num_levels = 1;
+    *last_level = head;
+    queue->push_back(root);
+    while (head < queue->size()) {
+      if (head == level_end) {
+        *last_level = level_end;
+        level_end = queue->size();
+        ++num_levels;
+      }
+      size_t v = (*queue)[head++];
+      size_t begin = queue->size();
+      const I *adj = v < num_rows ? ind : ind_t;
+      size_t offset = v < num_rows ? num_rows : 0;
+      I l_begin = v < num_rows ? ptr[v] : ptr_t[v - num_rows];
+      I l_end = v < num_rows ? ptr[v + 1] : ptr_t[v - num_rows + 1];
+      for (I l = l_begin; l < l_end; ++l) {
+        size_t u = offset + adj[l];
+        if (mark[u] != stamp) {
+          mark[u] = stamp;
+          queue->push_back(u);
+        }
+      }
+      std::sort(queue->begin() + begin, queue->end(), by_degree);
+    }
+    return num_levels;
+  };
+
+  std::vector<size_t> order, trial, trial_next;
+  order.reserve(num_nodes);
+  for (size_t s = 0; s < num_nodes; ++s) {
+    if (mark[s] != 0)
+      continue;
+    // Move the root to a node of least degree in the last level as long as
+    // this increases the number of levels.
+    size_t root = s, last, last_next;
+    trial.clear();
+    size_t num_levels = bfs(root, &trial, &last);
+    for (;;) {
+      size_t cand = *std::min_element(trial.begin() + last, trial.end(),
+          by_degree);
+      trial_next.clear();
+      size_t num_levels_next = bfs(cand, &trial_next, &last_next);
+      if (num_levels_next <= num_levels)
+        break;
+      root = cand;
+      num_levels = num_levels_next;
+      last = last_next;
+      trial.swap(trial_next);
+    }
+    bfs(root, &order, &last);
+  }
+
+  size_t i = 0, j = 0;
+  for (size_t k = num_nodes; k-- > 0; ) {
+    if (order[k] < num_rows)
+      row_perm[i++] = order[k];
+    else
+      col_perm[j++] = order[k] - num_rows;
+  }
+}
+
+// Computes the orderings of BipartiteRcm for the rows x cols CSR matrix
+// (data, ptr, ind) and the permuted matrix (data_p, ptr_p, ind_p), whose
+// rows hold their indices in increasing order.
+template <typename T, typename I>
+void PermuteRcm(I rows, I cols, I nnz, const T *data, const I *ptr,
+                const I *ind, std::vector<size_t> *row_perm,
+                std::vector<size_t> *col_perm, std::vector<T> *data_p,
+                std::vector<I> *ptr_p, std::vector<I> *ind_p) {
+  std::vector<T> data_t(nnz);
+  std::vector<I> ptr_t(cols + 1), ind_t(nnz);
+  gsl::csr2csc(rows, cols, nnz, data, ptr, ind, data_t.data(), ind_t.data(),
+      ptr_t.data());
+
+  row_perm->resize(rows);
+  col_perm->resize(cols);
+  BipartiteRcm(rows, cols, ptr, ind, ptr_t.data(), ind_t.data(),
+      row_perm->data(), col_perm->data());
+
+  // Permute the rows of A^T and renumber its indices, then transpose back,
+  // which sorts the indices of each row.
+  std::vector<I> row_inv(rows);
+  for (I i = 0; i < rows; ++i)
+    row_inv[(*row_perm)[i]] = i;
+  std::vector<T> data_pt(nnz);
+  std::vector<I> ptr_pt(cols + 1), ind_pt(nnz);
+  ptr_pt[0] = 0;
+  for (I j = 0; j < cols; ++j) {
+    size_t c = (*col_perm)[j];
+    ptr_pt[j + 1] = ptr_pt[j] + ptr_t[c + 1] - ptr_t[c];
+  }
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (I j = 0; j < cols; ++j) {
+    size_t c = (*col_perm)[j];
+    for (I l = ptr_t[c]; l < ptr_t[c + 1]; ++l) {
+      I l_p = ptr_pt[j] + l - ptr_t[c];
+      data_pt[l_p] = data_t[l];
+      ind_pt[l_p] = row_inv[ind_t[l]];
+    }
+  }
+
+  data_p->resize(nnz);
+  ptr_p->resize(rows + 1);
+  ind_p->resize(nnz);
+  gsl::csr2csc(cols, rows, nnz, data_pt.data(), ptr_pt.data(), ind_pt.data(),
+      data_p->data(), ind_p->data(), ptr_p->data());
+}
+
 CBLAS_TRANSPOSE_t OpToCblasOp(char trans) {
   ASSERT(trans == 'n' || trans == 'N' || trans == 't' || trans == 'T');
   return trans == 'n' || trans == 'N' ? CblasNoTrans : CblasTrans;
 }
 
-template <typename T>
-void MultDiag(const T *d, const T *e, POGS_INT m, POGS_INT n, POGS_INT nnz,
-              typename MatrixSparse<T>::Ord ord, T *data, const POGS_INT *ind,
-              const POGS_INT *ptr);
+template <typename T, typename I>
+void MultDiag(const T *d, const T *e, I m, I n, I nnz,
+              typename MatrixSparse<T, I>::Ord ord, bool transpose, T *data,
+              const I *ind, const I *ptr, const I *part, int num_parts);
 
-template <typename T>
-T NormEst(NormTypes norm_type, const MatrixSparse<T>& A);
+template <typename T, typename I>
+T NormEst(NormTypes norm_type, const MatrixSparse<T, I>& A);
 
 }  // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
 /////////////////////// MatrixDense Implementation /////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
-template <typename T>
-MatrixSparse<T>::MatrixSparse(char ord, POGS_INT m, POGS_INT n, POGS_INT nnz,
-                              const T *data, const POGS_INT *ptr,
-                              const POGS_INT *ind)
-    : Matrix<T>(m, n), _data(0), _ptr(0), _ind(0), _nnz(nnz) {
+template <typename T, typename I>
+MatrixSparse<T, I>::MatrixSparse(char ord, I m, I n, I nnz, const T *data,
+                                 const I *ptr, const I *ind,
+                                 bool store_transpose, bool use_sell,
+                                 bool reorder)
+    : Matrix<T>(m, n), _data(0), _ptr(0), _ind(0), _nnz(nnz),
+      _transpose(store_transpose) {
   ASSERT(ord == 'r' || ord == 'R' || ord == 'c' || ord == 'C');
   _ord = (ord == 'r' || ord == 'R') ? ROW : COL;
 
   // Set CPU specific data.
-  CpuData<T> *info = new CpuData<T>(data, ptr, ind);
+  CpuData<T, I> *info = new CpuData<T, I>(data, ptr, ind, use_sell,
+      reorder);
   this->_info = reinterpret_cast<void*>(info);
 }
 
-template <typename T>
-MatrixSparse<T>::MatrixSparse(const MatrixSparse<T>& A)
+template <typename T, typename I>
+MatrixSparse<T, I>::MatrixSparse(const MatrixSparse<T, I>& A)
     : Matrix<T>(A._m, A._n), _data(0), _ptr(0), _ind(0), _nnz(A._nnz), 
-      _ord(A._ord) {
+      _ord(A._ord), _transpose(A._transpose) {
 
-  CpuData<T> *info_A = reinterpret_cast<CpuData<T>*>(A._info);
-  CpuData<T> *info = new CpuData<T>(info_A->orig_data, info_A->orig_ptr,
-      info_A->orig_ind);
+  CpuData<T, I> *info_A = reinterpret_cast<CpuData<T, I>*>(A._info);
+  CpuData<T, I> *info = new CpuData<T, I>(info_A->orig_data, info_A->orig_ptr,
+      info_A->orig_ind, info_A->use_sell, info_A->reorder);
   this->_info = reinterpret_cast<void*>(info);
 }
 
-template <typename T>
-MatrixSparse<T>::~MatrixSparse() {
-  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+template <typename T, typename I>
+MatrixSparse<T, I>::~MatrixSparse() {
+  CpuData<T, I> *info = reinterpret_cast<CpuData<T, I>*>(this->_info);
   delete info;
   this->_info = 0;
 
@@ -91,47 +301,98 @@ MatrixSparse<T>::~MatrixSparse() {
   }
 }
 
-template <typename T>
-int MatrixSparse<T>::Init() {
+template <typename T, typename I>
+int MatrixSparse<T, I>::Init() {
   DEBUG_ASSERT(!this->_done_init);
   if (this->_done_init)
     return 1;
   this->_done_init = true;
 
-  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  CpuData<T, I> *info = reinterpret_cast<CpuData<T, I>*>(this->_info);
   const T *orig_data = info->orig_data;
-  const POGS_INT *orig_ptr = info->orig_ptr;
-  const POGS_INT *orig_ind = info->orig_ind;
+  const I *orig_ptr = info->orig_ptr;
+  const I *orig_ind = info->orig_ind;
+  I rows_own = _ord == ROW ? this->_m : this->_n;
+  I rows_tr = _ord == ROW ? this->_n : this->_m;
+
+  // Copy the reordered matrix instead, if requested.
+  std::vector<T> perm_data;
+  std::vector<I> perm_ptr, perm_ind;
+  if (info->reorder) {
+    std::vector<size_t> &perm_own =
+        _ord == ROW ? info->row_perm : info->col_perm;
+    std::vector<size_t> &perm_tr =
+        _ord == ROW ? info->col_perm : info->row_perm;
+    PermuteRcm(rows_own, rows_tr, _nnz, orig_data, orig_ptr, orig_ind,
+        &perm_own, &perm_tr, &perm_data, &perm_ptr, &perm_ind);
+    orig_data = perm_data.data();
+    orig_ptr = perm_ptr.data();
+    orig_ind = perm_ind.data();
+  }
 
-  // Allocate sparse matrix on gpu.
-  _data = new T[static_cast<size_t>(2) * _nnz];
+  // Allocate sparse matrix, with room for the transpose if it is stored.
+  size_t copies = _transpose ? 2 : 1;
+  size_t ptr_len = _transpose ? this->_m + this->_n + 2 :
+      (_ord == ROW ? this->_m : this->_n) + 1;
+  _data = new T[copies * _nnz];
   ASSERT(_data != 0);
-  _ind = new POGS_INT[static_cast<size_t>(2) * _nnz];
+  _ind = new I[copies * _nnz];
   ASSERT(_ind != 0);
-  _ptr = new POGS_INT[this->_m + this->_n + 2];
+  _ptr = new I[ptr_len];
   ASSERT(_ptr != 0);
 
   if (_ord == ROW) {
-    gsl::spmat<T, POGS_INT, CblasRowMajor> A(_data, _ind, _ptr, this->_m,
-        this->_n, _nnz);
+    gsl::spmat<T, I, CblasRowMajor> A(_data, _ind, _ptr, this->_m,
+        this->_n, _nnz, _transpose);
     gsl::spmat_memcpy(&A, orig_data, orig_ind, orig_ptr);
   } else {
-    gsl::spmat<T, POGS_INT, CblasColMajor> A(_data, _ind, _ptr, this->_m,
-        this->_n, _nnz);
+    gsl::spmat<T, I, CblasColMajor> A(_data, _ind, _ptr, this->_m,
+        this->_n, _nnz, _transpose);
     gsl::spmat_memcpy(&A, orig_data, orig_ind, orig_ptr);
   }
 
+  // Row ranges with equal nnz for each thread.
+#ifdef _OPENMP
+  info->num_parts = omp_get_max_threads();
+#endif
+  info->part.resize(copies * (info->num_parts + 1));
+  gsl::spmat_partition(rows_own, _ptr, info->num_parts, info->part.data());
+  if (_transpose)
+    gsl::spmat_partition(rows_tr, _ptr + rows_own + 1, info->num_parts,
+        info->part.data() + info->num_parts + 1);
+  else
+    info->scatter.resize(gsl::spblas_scatter_len(
+        static_cast<size_t>(rows_tr), 1, info->num_parts));
+
+  if (info->use_sell)
+    UpdateSell<T, I>(info, true, this->_m, this->_n, _nnz, _ord, _transpose,
+        _data, _ind, _ptr);
+
   return 0;
 }
 
-template <typename T>
-int MatrixSparse<T>::Mul(char trans, T alpha, const T *x, T beta, T *y) const {
+template <typename T, typename I>
+const size_t *MatrixSparse<T, I>::RowPerm() const {
+  CpuData<T, I> *info = reinterpret_cast<CpuData<T, I>*>(this->_info);
+  return info->row_perm.empty() ? 0 : info->row_perm.data();
+}
+
+template <typename T, typename I>
+const size_t *MatrixSparse<T, I>::ColPerm() const {
+  CpuData<T, I> *info = reinterpret_cast<CpuData<T, I>*>(this->_info);
+  return info->col_perm.empty() ? 0 : info->col_perm.data();
+}
+
+template <typename T, typename I>
+int MatrixSparse<T, I>::Mul(char trans, T alpha, const T *x, T beta,
+                            T *y) const {
   DEBUG_ASSERT(this->_done_init);
   if (!this->_done_init)
     return 1;
 
+  bool no_trans = trans == 'n' || trans == 'N';
   gsl::vector<T> x_vec, y_vec;
-  if (trans == 'n' || trans == 'N') {
+  if (no_trans) {
     x_vec = gsl::vector_view_array<T>(x, this->_n);
     y_vec = gsl::vector_view_array<T>(y, this->_m);
   } else {
@@ -139,27 +400,87 @@ int MatrixSparse<T>::Mul(char trans, T alpha, const T *x, T beta, T *y) const {
     y_vec = gsl::vector_view_array<T>(y, this->_n);
   }
 
+  // Use the SELL copy whose rows are the rows of op(A), if it is stored.
+  CpuData<T, I> *info = reinterpret_cast<CpuData<T, I>*>(this->_info);
+  int h = no_trans == (_ord == ROW) ? 0 : 1;
+  if (info->sell_ready && (h == 0 || _transpose)) {
+    gsl::spblas_gemv(alpha, &info->sell[h], &x_vec, beta, &y_vec);
+    return 0;
+  }
+
   if (_ord == ROW) {
-    gsl::spmat<T, POGS_INT, CblasRowMajor> A(_data, _ind, _ptr, this->_m,
-        this->_n, _nnz);
+    gsl::spmat<T, I, CblasRowMajor> A(_data, _ind, _ptr, this->_m,
+        this->_n, _nnz, _transpose);
+    A.part = info->part.data();
+    A.num_parts = info->num_parts;
+    bool scatter = AcquireScatter(info, &A);
     gsl::spblas_gemv(OpToCblasOp(trans), alpha, &A, &x_vec, beta, &y_vec);
+    ReleaseScatter(info, scatter);
   } else {
-    gsl::spmat<T, POGS_INT, CblasColMajor> A(_data, _ind, _ptr, this->_m,
-        this->_n, _nnz);
+    gsl::spmat<T, I, CblasColMajor> A(_data, _ind, _ptr, this->_m,
+        this->_n, _nnz, _transpose);
+    A.part = info->part.data();
+    A.num_parts = info->num_parts;
+    bool scatter = AcquireScatter(info, &A);
     gsl::spblas_gemv(OpToCblasOp(trans), alpha, &A, &x_vec, beta, &y_vec);
+    ReleaseScatter(info, scatter);
+  }
+
+  return 0;
+}
+
+template <typename T, typename I>
+int MatrixSparse<T, I>::MulBatch(char trans, size_t k, T alpha, const T *x,
+                                 size_t ldx, T beta, T *y,
+                                 size_t ldy) const {
+  DEBUG_ASSERT(this->_done_init);
+  if (!this->_done_init)
+    return 1;
+
+  CpuData<T, I> *info = reinterpret_cast<CpuData<T, I>*>(this->_info);
+
+  bool no_trans = trans == 'n' || trans == 'N';
+  size_t x_size = no_trans ? this->_n : this->_m;
+  size_t y_size = no_trans ? this->_m : this->_n;
+
+  const gsl::matrix<T, CblasColMajor> x_mat =
+      gsl::matrix_view_array<T, CblasColMajor>(x, x_size, k, ldx);
+  gsl::matrix<T, CblasColMajor> y_mat =
+      gsl::matrix_view_array<T, CblasColMajor>(y, y_size, k, ldy);
+
+  if (_ord == ROW) {
+    gsl::spmat<T, I, CblasRowMajor> A(_data, _ind, _ptr, this->_m,
+        this->_n, _nnz, _transpose);
+    A.part = info->part.data();
+    A.num_parts = info->num_parts;
+    bool scatter = AcquireScatter(info, &A);
+    gsl::spblas_gemm(OpToCblasOp(trans), alpha, &A, &x_mat, beta, &y_mat);
+    ReleaseScatter(info, scatter);
+  } else {
+    gsl::spmat<T, I, CblasColMajor> A(_data, _ind, _ptr, this->_m,
+        this->_n, _nnz, _transpose);
+    A.part = info->part.data();
+    A.num_parts = info->num_parts;
+    bool scatter = AcquireScatter(info, &A);
+    gsl::spblas_gemm(OpToCblasOp(trans), alpha, &A, &x_mat, beta, &y_mat);
+    ReleaseScatter(info, scatter);
   }
 
   return 0;
 }
 
-template <typename T>
-int MatrixSparse<T>::Equil(T *d, T *e) {
+template <typename T, typename I>
+int MatrixSparse<T, I>::Equil(T *d, T *e) {
   DEBUG_ASSERT(this->_done_init);
   if (!this->_done_init)
     return 1;
 
+  // The SELL copies are stale until the end.
+  CpuData<T, I> *info = reinterpret_cast<CpuData<T, I>*>(this->_info);
+  info->sell_ready = false;
+
   // Number of elements in matrix.
-  size_t num_el = static_cast<size_t>(2) * _nnz;
+  size_t num_el = static_cast<size_t>(_transpose ? 2 : 1) * _nnz;
 
   // Create bit-vector with signs of entries in A and then let A = f(A),
   // where f = |A| or f = |A|.^2.
@@ -216,7 +537,8 @@ int MatrixSparse<T>::Equil(T *d, T *e) {
   }
 
   // Compute A := D * A * E.
-  MultDiag(d, e, this->_m, this->_n, _nnz, _ord, _data, _ind, _ptr);
+  MultDiag<T, I>(d, e, this->_m, this->_n, _nnz, _ord, _transpose, _data,
+      _ind, _ptr, info->part.data(), info->num_parts);
 
   // Scale A to have norm of 1 (in the kNormNormalize norm).
   T normA = NormEst(kNormNormalize, *this);
@@ -232,6 +554,10 @@ int MatrixSparse<T>::Equil(T *d, T *e) {
   DEBUG_PRINTF("norm A = %e, normd = %e, norme = %e\n", normA,
       gsl::blas_nrm2(&d_vec), gsl::blas_nrm2(&e_vec));
 
+  if (info->use_sell)
+    UpdateSell<T, I>(info, false, this->_m, this->_n, _nnz, _ord, _transpose,
+        _data, _ind, _ptr);
+
   delete [] sign;
 
   return 0;
@@ -243,8 +569,8 @@ int MatrixSparse<T>::Equil(T *d, T *e) {
 namespace {
 
 // Estimates norm of A. norm_type should either be kNorm2 or kNormFro.
-template <typename T>
-T NormEst(NormTypes norm_type, const MatrixSparse<T>& A) {
+template <typename T, typename I>
+T NormEst(NormTypes norm_type, const MatrixSparse<T, I>& A) {
   switch (norm_type) {
     case kNorm2: {
       return Norm2Est(&A);
@@ -263,39 +589,40 @@ T NormEst(NormTypes norm_type, const MatrixSparse<T>& A) {
 }
 
 // Performs D * A * E for A in row major
-template <typename T>
-void MultRow(const T *d, const T *e, T *data, const POGS_INT *row_ptr,
-             const POGS_INT *col_ind, POGS_INT size) {
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-  for (POGS_INT t = 0; t < size; ++t)
-    for (POGS_INT i = row_ptr[t]; i < row_ptr[t + 1]; ++i)
-      data[i] *= d[t] * e[col_ind[i]];
+template <typename T, typename I>
+void MultRow(const T *d, const T *e, T *data, const I *row_ptr,
+             const I *col_ind, I size, const I *part, int num_parts) {
+  gsl::spmat_for_rows(size, part, num_parts, [&](I begin, I end) {
+    for (I t = begin; t < end; ++t)
+      for (I i = row_ptr[t]; i < row_ptr[t + 1]; ++i)
+        data[i] *= d[t] * e[col_ind[i]];
+  });
 }
 
 // Performs D * A * E for A in col major
-template <typename T>
-void MultCol(const T *d, const T *e, T *data, const POGS_INT *col_ptr,
-             const POGS_INT *row_ind, POGS_INT size) {
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-  for (POGS_INT t = 0; t < size; ++t)
-    for (POGS_INT i = col_ptr[t]; i < col_ptr[t + 1]; ++i)
-      data[i] *= d[row_ind[i]] * e[t];
+template <typename T, typename I>
+void MultCol(const T *d, const T *e, T *data, const I *col_ptr,
+             const I *row_ind, I size, const I *part, int num_parts) {
+  gsl::spmat_for_rows(size, part, num_parts, [&](I begin, I end) {
+    for (I t = begin; t < end; ++t)
+      for (I i = col_ptr[t]; i < col_ptr[t + 1]; ++i)
+        data[i] *= d[row_ind[i]] * e[t];
+  });
 }
 
-template <typename T>
-void MultDiag(const T *d, const T *e, POGS_INT m, POGS_INT n, POGS_INT nnz,
-              typename MatrixSparse<T>::Ord ord, T *data, const POGS_INT *ind,
-              const POGS_INT *ptr) {
-  if (ord == MatrixSparse<T>::ROW) {
-    MultRow(d, e, data, ptr, ind, m);
-    MultCol(d, e, data + nnz, ptr + m + 1, ind + nnz, n);
+template <typename T, typename I>
+void MultDiag(const T *d, const T *e, I m, I n, I nnz,
+              typename MatrixSparse<T, I>::Ord ord, bool transpose, T *data,
+              const I *ind, const I *ptr, const I *part, int num_parts) {
+  const I *part_t = part + num_parts + 1;
+  if (ord == MatrixSparse<T, I>::ROW) {
+    MultRow(d, e, data, ptr, ind, m, part, num_parts);
+    if (transpose)
+      MultCol(d, e, data + nnz, ptr + m + 1, ind + nnz, n, part_t, num_parts);
   } else {
-    MultCol(d, e, data, ptr, ind, n);
-    MultRow(d, e, data + nnz, ptr + n + 1, ind + nnz, m);
+    MultCol(d, e, data, ptr, ind, n, part, num_parts);
+    if (transpose)
+      MultRow(d, e, data + nnz, ptr + n + 1, ind + nnz, m, part_t, num_parts);
   }
 }
 
@@ -303,10 +630,12 @@ void MultDiag(const T *d, const T *e, POGS_INT m, POGS_INT n, POGS_INT nnz,
 
 #if !defined(POGS_DOUBLE) || POGS_DOUBLE==1
 template class MatrixSparse<double>;
+template class MatrixSparse<double, POGS_INT64>;
 #endif
 
 #if !defined(POGS_SINGLE) || POGS_SINGLE==1
 template class MatrixSparse<float>;
+template class MatrixSparse<float, POGS_INT64>;
 #endif
 
 }  // namespace pogs
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <functional>
 
+#include "anderson.h"
 #include "gsl/gsl_blas.h"
 #include "gsl/gsl_vector.h"
 #include "interface_defs.h"
@@ -12,6 +13,8 @@
 #include "projector/projector.h"
 #include "projector/projector_direct.h"
 #include "projector/projector_cgls.h"
+#include "projector/projector_eig.h"
+#include "projector/projector_lsmr.h"
 #include "util.h"
 
 #include "timer.h"
@@ -23,36 +26,212 @@ namespace pogs {
 
 namespace {
 
+// Scales p to account for the diagonal scaling s, p[i] := op(p[i], s[i])
+// or op(op(p[i], s[i]), s[i]) if twice is set. A single entry is expanded
+// to size entries first, unless it is zero.
 template <typename T, typename Op>
-struct ApplyOp: std::binary_function<FunctionObj<T>, FunctionObj<T>, T> {
-  Op binary_op;
-  ApplyOp(Op binary_op) : binary_op(binary_op) { }
-  FunctionObj<T> operator()(FunctionObj<T> &h, T x) {
-    h.a = binary_op(h.a, x);
-    h.d = binary_op(h.d, x);
-    h.e = binary_op(binary_op(h.e, x), x);
-    return h;
+void ScaleParam(size_t size, const T *s, Op op, bool twice,
+                std::vector<T> *p) {
+  if (p->size() == 1) {
+    T p0 = (*p)[0];
+    if (p0 == static_cast<T>(0))
+      return;
+    p->assign(size, p0);
   }
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < size; ++i)
+    (*p)[i] = twice ? op(op((*p)[i], s[i]), s[i]) : op((*p)[i], s[i]);
+}
+
+// (a, d, e) := (op(a, s), op(d, s), op(op(e, s), s)) for each element.
+template <typename T, typename Op>
+void ScaleFunctions(const T *s, Op op, FunctionVector<T> *f_obj) {
+  ScaleParam(f_obj->size(), s, op, false, &f_obj->a);
+  ScaleParam(f_obj->size(), s, op, false, &f_obj->d);
+  ScaleParam(f_obj->size(), s, op, true, &f_obj->e);
+}
+
+// Fused kernels for the ADMM iteration. Each makes a single pass over its
+// arguments and replaces a sequence of memcpy/axpy/dot/nrm2 calls, since the
+// loop body is memory bandwidth bound. Norms are returned squared and are
+// accumulated in double precision.
+
+// zprev := z, z := z - zt.
+template <typename T>
+void SaveAndShift(size_t size, const T *zt, T *z, T *zprev) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < size; ++i) {
+    zprev[i] = z[i];
+    z[i] -= zt[i];
+  }
+}
+
+// z := z - z12 and ztemp := zt + alpha * z12 + (1 - alpha) * zprev, while
+// accumulating <z, z12>, ||z||^2 and ||z12||^2 on [begin, end).
+template <typename T>
+void DiffRelax(size_t begin, size_t end, T alpha, const T *zt, const T *z12,
+               const T *zprev, T *z, T *ztemp, double *dot, double *nrm2_z,
+               double *nrm2_z12) {
+  double dot_ = 0., nrm2_z_ = 0., nrm2_z12_ = 0.;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:dot_,nrm2_z_,nrm2_z12_)
+#endif
+  for (size_t i = begin; i < end; ++i) {
+    T z12_i = z12[i];
+    T z_i = z[i] - z12_i;
+    z[i] = z_i;
+    ztemp[i] = zt[i] + alpha * z12_i + (1 - alpha) * zprev[i];
+    dot_ += static_cast<double>(z_i) * z12_i;
+    nrm2_z_ += static_cast<double>(z_i) * z_i;
+    nrm2_z12_ += static_cast<double>(z12_i) * z12_i;
+  }
+  *dot = dot_;
+  *nrm2_z = nrm2_z_;
+  *nrm2_z12 = nrm2_z12_;
+}
+
+// Computes ||zprev - z||^2 and ||z12 - z||^2 without writing either
+// difference to memory.
+template <typename T>
+void ResidualNorms(size_t size, const T *zprev, const T *z12, const T *z,
+                   double *nrm2_s, double *nrm2_r) {
+  double nrm2_s_ = 0., nrm2_r_ = 0.;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:nrm2_s_,nrm2_r_)
+#endif
+  for (size_t i = 0; i < size; ++i) {
+    double s_i = static_cast<double>(zprev[i]) - z[i];
+    double r_i = static_cast<double>(z12[i]) - z[i];
+    nrm2_s_ += s_i * s_i;
+    nrm2_r_ += r_i * r_i;
+  }
+  *nrm2_s = nrm2_s_;
+  *nrm2_r = nrm2_r_;
+}
+
+// ztemp := z12 + zt - zprev.
+template <typename T>
+void AddSub(size_t size, const T *z12, const T *zt, const T *zprev,
+            T *ztemp) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < size; ++i)
+    ztemp[i] = z12[i] + zt[i] - zprev[i];
+}
+
+// zt := zt + alpha * z12 + (1 - alpha) * zprev - z.
+template <typename T>
+void DualUpdate(size_t size, T alpha, const T *z12, const T *zprev,
+                const T *z, T *zt) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < size; ++i)
+    zt[i] += alpha * z12[i] + (1 - alpha) * zprev[i] - z[i];
+}
+
+// y[i] := x[perm[i]], or y := x if perm is null. Maps vectors indexed like
+// A to the order of a reordered matrix, see Matrix::RowPerm.
+template <typename V>
+void Gather(size_t size, const size_t *perm, const V *x, V *y) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < size; ++i)
+    y[i] = x[perm ? perm[i] : i];
+}
+
+// y[perm[i]] := x[i], or y := x if perm is null. Inverse of Gather.
+template <typename V>
+void Scatter(size_t size, const size_t *perm, const V *x, V *y) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < size; ++i)
+    y[perm ? perm[i] : i] = x[i];
+}
+
+// Per-problem scalars for SolveBatch.
+template <typename T>
+struct BatchState {
+  size_t id;
+  T rho, delta, xi;
+  unsigned int kd, ku;
+  T nrm_r, nrm_s, gap, eps_gap, eps_pri, eps_dua;
+  bool exact;
 };
 
 }  // namespace
 
+template <typename T, typename M, typename P>
+PogsPrepared<T, M, P>::PogsPrepared(const M &A)
+    : _A(A), _P(_A), _de(0), _done_init(false) { }
+
+template <typename T, typename M, typename P>
+int PogsPrepared<T, M, P>::Init() {
+  DEBUG_EXPECT(!_done_init);
+  if (_done_init)
+    return 1;
+  _done_init = true;
+
+  size_t m = _A.Rows();
+  size_t n = _A.Cols();
+
+  _de = new T[m + n]();
+  ASSERT(_de != 0);
+
+  _A.Init();
+  _A.Equil(_de, _de + m);
+  _P.Init();
+
+  // Solve always projects with s = 1. Project once here so that a direct
+  // projector has its factorization cached before the solvers share it.
+  std::vector<T> zero(m + n, static_cast<T>(0)), z(m + n);
+  _P.Project(zero.data(), zero.data() + n, static_cast<T>(1), z.data(),
+      z.data() + n, static_cast<T>(1));
+
+  return 0;
+}
+
+template <typename T, typename M, typename P>
+PogsPrepared<T, M, P>::~PogsPrepared() {
+  delete [] _de;
+  _de = 0;
+}
+
 template <typename T, typename M, typename P>
 Pogs<T, M, P>::Pogs(const M &A)
-    : _A(A), _P(_A),
+    : Pogs(std::make_shared<PogsPrepared<T, M, P> >(A)) { }
+
+template <typename T, typename M, typename P>
+Pogs<T, M, P>::Pogs(const std::shared_ptr<PogsPrepared<T, M, P> > &prep)
+    : _prep(prep), _A(prep->_A), _P(prep->_P),
       _de(0), _z(0), _zt(0),
       _rho(static_cast<T>(kRhoInit)),
       _done_init(false),
+      _zprev(0), _ztemp(0), _z12(0), _num_alloc(0), _anderson(0),
+      _proj_work(0),
       _x(0), _y(0), _mu(0), _lambda(0), _optval(static_cast<T>(0.)),
-      _final_iter(0),
+      _final_iter(0), _final_matvec_saved(0),
+      _final_aa_accepted(0), _final_aa_rejected(0), _final_krylov_iter(0),
+      _final_prox_stats(),
       _abs_tol(static_cast<T>(kAbsTol)),
       _rel_tol(static_cast<T>(kRelTol)),
       _max_iter(kMaxIter),
       _init_iter(kInitIter),
       _verbose(kVerbose),
+      _exact_freq(kExactFreq),
+      _anderson_mem(kAndersonMem),
       _adaptive_rho(kAdaptiveRho),
       _gap_stop(kGapStop),
-      _init_x(false), _init_lambda(false) {
+      _init_x(false), _init_lambda(false),
+      _prox_warm_start(kProxWarmStart),
+      _prox_accuracy(kProxAccuracy) {
   _x = new T[_A.Cols()]();
   _y = new T[_A.Rows()]();
   _mu = new T[_A.Cols()]();
@@ -69,19 +248,29 @@ int Pogs<T, M, P>::_Init() {
   size_t m = _A.Rows();
   size_t n = _A.Cols();
 
-  _de = new T[m + n];
-  ASSERT(_de != 0);
   _z = new T[m + n];
   ASSERT(_z != 0);
   _zt = new T[m + n];
   ASSERT(_zt != 0);
-  memset(_de, 0, (m + n) * sizeof(T));
   memset(_z, 0, (m + n) * sizeof(T));
   memset(_zt, 0, (m + n) * sizeof(T));
 
-  _A.Init();
-  _A.Equil(_de, _de + m);
-  _P.Init();
+  // Allocate workspace used by Solve.
+  _zprev = new T[m + n]();
+  ASSERT(_zprev != 0);
+  _ztemp = new T[m + n]();
+  ASSERT(_ztemp != 0);
+  _z12 = new T[m + n]();
+  ASSERT(_z12 != 0);
+  _num_alloc += 5;
+
+  if (!_prep->IsInit())
+    _prep->Init();
+  _de = _prep->_de;
+
+  _proj_work = _P.NewWork();
+  if (_proj_work != 0)
+    ++_num_alloc;
 
   return 0;
 }
@@ -89,7 +278,33 @@ int Pogs<T, M, P>::_Init() {
 template <typename T, typename M, typename P>
 PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
                                 const std::vector<FunctionObj<T> > &g) {
+  return _Solve(f, g, RunOps<T>(), RunOps<T>());
+}
+
+template <typename T, typename M, typename P>
+PogsStatus Pogs<T, M, P>::Solve(const FunctionVector<T> &f,
+                                const FunctionVector<T> &g) {
+  return _SolveOps(f, g, RunOps<T>(), RunOps<T>());
+}
+
+template <typename T, typename M, typename P>
+PogsStatus Pogs<T, M, P>::_SolveOps(const FunctionVector<T> &f,
+                                    const FunctionVector<T> &g,
+                                    const FunctionOps<T> &f_ops,
+                                    const FunctionOps<T> &g_ops) {
+  DEBUG_EXPECT(f.IsValid() && g.IsValid());
+  if (!f.IsValid() || !g.IsValid())
+    return POGS_ERROR;
+  return _Solve(f, g, f_ops, g_ops);
+}
+
+template <typename T, typename M, typename P>
+template <typename F>
+PogsStatus Pogs<T, M, P>::_Solve(const F &f, const F &g,
+                                 const FunctionOps<T> &f_ops,
+                                 const FunctionOps<T> &g_ops) {
   double t0 = timer<double>();
+  unsigned int krylov_iter0 = _P.GetKrylovStats().iters;
   // Constants for adaptive-rho and over-relaxation.
   const T kDeltaMin   = static_cast<T>(1.05);
   const T kGamma      = static_cast<T>(1.01);
@@ -104,7 +319,6 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   const T kProjTolMin = static_cast<T>(1e-2);
   const T kProjTolPow = static_cast<T>(1.3);
   const T kProjTolIni = static_cast<T>(1e-5);
-  bool use_exact_stop = true;
 
   // Initialize Projector P and Matrix A.
   if (!_done_init)
@@ -113,16 +327,45 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   // Extract values from pogs_data
   size_t m = _A.Rows();
   size_t n = _A.Cols();
-  std::vector<FunctionObj<T> > f_cpu = f;
-  std::vector<FunctionObj<T> > g_cpu = g;
 
-  // Allocate data for ADMM variables.
+  // Copy f and g into workspace (only allocates if more of their parameters
+  // vary than before), in the order of the rows and columns of A after any
+  // reordering. Their runs only allocate if there are more than before.
+  size_t fg_capacity = _f.Capacity() + _g.Capacity();
+  size_t runs_capacity = _f_runs.capacity() + _g_runs.capacity();
+  DEBUG_EXPECT(_A.RowPerm() == 0 || f.size() == m);
+  DEBUG_EXPECT(_A.ColPerm() == 0 || g.size() == n);
+  _f.Assign(f, _A.RowPerm());
+  _g.Assign(g, _A.ColPerm());
+  FunctionRuns(_f, &_f_runs);
+  FunctionRuns(_g, &_g_runs);
+  if (_f_runs.capacity() + _g_runs.capacity() > runs_capacity)
+    ++_num_alloc;
+  FunctionVector<T> &f_cpu = _f;
+  FunctionVector<T> &g_cpu = _g;
+
+  // Anderson workspace is only reallocated if the memory depth changed.
+  Anderson<T> *aa = static_cast<Anderson<T>*>(_anderson);
+  if (aa != 0 && aa->Mem() != _anderson_mem) {
+    delete aa;
+    aa = 0;
+  }
+  if (aa == 0 && _anderson_mem > 0) {
+    aa = new Anderson<T>(m + n, _anderson_mem);
+    ASSERT(aa != 0);
+    ++_num_alloc;
+  } else if (aa != 0) {
+    aa->Reset();
+  }
+  _anderson = aa;
+
+  // Create views for ADMM variables.
   gsl::vector<T> de    = gsl::vector_view_array(_de, m + n);
   gsl::vector<T> z     = gsl::vector_view_array(_z, m + n);
   gsl::vector<T> zt    = gsl::vector_view_array(_zt, m + n);
-  gsl::vector<T> zprev = gsl::vector_calloc<T>(m + n);
-  gsl::vector<T> ztemp = gsl::vector_calloc<T>(m + n);
-  gsl::vector<T> z12   = gsl::vector_calloc<T>(m + n);
+  gsl::vector<T> zprev = gsl::vector_view_array(_zprev, m + n);
+  gsl::vector<T> ztemp = gsl::vector_view_array(_ztemp, m + n);
+  gsl::vector<T> z12   = gsl::vector_view_array(_z12, m + n);
 
   // Create views for x and y components.
   gsl::vector<T> d     = gsl::vector_subvector(&de, 0, m);
@@ -137,20 +380,20 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   gsl::vector<T> ytemp = gsl::vector_subvector(&ztemp, n, m);
 
   // Scale f and g to account for diagonal scaling e and d.
-  std::transform(f_cpu.begin(), f_cpu.end(), d.data, f_cpu.begin(),
-      ApplyOp<T, std::divides<T> >(std::divides<T>()));
-  std::transform(g_cpu.begin(), g_cpu.end(), e.data, g_cpu.begin(),
-      ApplyOp<T, std::multiplies<T> >(std::multiplies<T>()));
+  ScaleFunctions(d.data, std::divides<T>(), &f_cpu);
+  ScaleFunctions(e.data, std::multiplies<T>(), &g_cpu);
+  if (_f.Capacity() + _g.Capacity() > fg_capacity)
+    ++_num_alloc;
 
   // Initialize (x, lambda) from (x0, lambda0).
   if (_init_x) {
-    gsl::vector_memcpy(&xtemp, _x);
+    Gather(n, _A.ColPerm(), _x, xtemp.data);
     gsl::vector_div(&xtemp, &e);
     _A.Mul('n', kOne, xtemp.data, kZero, ytemp.data);
     gsl::vector_memcpy(&z, &ztemp);
   }
   if (_init_lambda) {
-    gsl::vector_memcpy(&ytemp, _lambda);
+    Gather(m, _A.RowPerm(), _lambda, ytemp.data);
     gsl::vector_div(&ytemp, &d);
     _A.Mul('t', -kOne, ytemp.data, kZero, xtemp.data);
     gsl::blas_scal(-kOne / _rho, &ztemp);
@@ -164,10 +407,10 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
     //   2. \mu = -A^T\lambda
     gsl::vector_set_all(&zprev, kZero);
     for (unsigned int i = 0; i < kInitIter; ++i) {
-      ProjSubgradEval(g_cpu, xprev.data, x.data, xtemp.data);
-      ProjSubgradEval(f_cpu, yprev.data, y.data, ytemp.data);
+      g_ops.proj_subgrad(g_cpu, xprev.data, x.data, xtemp.data);
+      f_ops.proj_subgrad(f_cpu, yprev.data, y.data, ytemp.data);
       _P.Project(xtemp.data, ytemp.data, kOne, xprev.data, yprev.data,
-          kProjTolIni);
+          kProjTolIni, _proj_work);
       gsl::blas_axpy(-kOne, &ztemp, &zprev);
       gsl::blas_scal(-kOne, &zprev);
     }
@@ -200,60 +443,70 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   T sqrtm_atol = std::sqrt(static_cast<T>(m)) * _abs_tol;
   T sqrtmn_atol = std::sqrt(static_cast<T>(m + n)) * _abs_tol;
   T delta = kDeltaMin, xi = static_cast<T>(1.0);
-  unsigned int k = 0u, kd = 0u, ku = 0u;
+  unsigned int k = 0u, kd = 0u, ku = 0u, matvec_saved = 0u;
+  unsigned int aa_accepted = 0u, aa_rejected = 0u;
   bool converged = false;
+  bool prox_warm = _prox_warm_start && _prox_accuracy == kProxAccurate;
+  ProxStats prox_stats = { 0, 0 };
   T nrm_r, nrm_s, gap, eps_gap, eps_pri, eps_dua;
 
   for (;; ++k) {
-    gsl::vector_memcpy(&zprev, &z);
-
     // Evaluate Proximal Operators
-    gsl::blas_axpy(-kOne, &zt, &z);
-    ProxEval(g_cpu, _rho, x.data, x12.data);
-    ProxEval(f_cpu, _rho, y.data, y12.data);
-
-    // Compute gap, optval, and tolerances.
-    gsl::blas_axpy(-kOne, &z12, &z);
-    gsl::blas_dot(&z, &z12, &gap);
-    gap = std::abs(gap);
-    eps_gap = sqrtmn_atol + _rel_tol * gsl::blas_nrm2(&z) *
-        gsl::blas_nrm2(&z12);
-    eps_pri = sqrtm_atol + _rel_tol * gsl::blas_nrm2(&y12);
-    eps_dua = sqrtn_atol + _rel_tol * _rho * gsl::blas_nrm2(&x);
-
-    // Apply over relaxation.
-    gsl::vector_memcpy(&ztemp, &zt);
-    gsl::blas_axpy(kAlpha, &z12, &ztemp);
-    gsl::blas_axpy(kOne - kAlpha, &zprev, &ztemp);
+    SaveAndShift(m + n, zt.data, z.data, zprev.data);
+    if (prox_warm) {
+      // z12 holds the prox of the previous iteration.
+      ProxEvalWarm(g_cpu, _g_runs, _rho, x.data, x12.data, k > 0,
+          &prox_stats);
+      ProxEvalWarm(f_cpu, _f_runs, _rho, y.data, y12.data, k > 0,
+          &prox_stats);
+    } else {
+      g_ops.prox(g_cpu, _g_runs, _rho, x.data, x12.data, _prox_accuracy);
+      f_ops.prox(f_cpu, _f_runs, _rho, y.data, y12.data, _prox_accuracy);
+    }
+
+    // Compute gap, optval, and tolerances, and apply over relaxation.
+    double dot_x, dot_y, nrm2_x, nrm2_y, nrm2_x12, nrm2_y12;
+    DiffRelax<T>(0, n, kAlpha, zt.data, z12.data, zprev.data, z.data,
+        ztemp.data, &dot_x, &nrm2_x, &nrm2_x12);
+    DiffRelax<T>(n, m + n, kAlpha, zt.data, z12.data, zprev.data, z.data,
+        ztemp.data, &dot_y, &nrm2_y, &nrm2_y12);
+    gap = std::abs(static_cast<T>(dot_x + dot_y));
+    eps_gap = sqrtmn_atol + _rel_tol *
+        static_cast<T>(std::sqrt(nrm2_x + nrm2_y)) *
+        static_cast<T>(std::sqrt(nrm2_x12 + nrm2_y12));
+    eps_pri = sqrtm_atol + _rel_tol * static_cast<T>(std::sqrt(nrm2_y12));
+    eps_dua = sqrtn_atol + _rel_tol * _rho *
+        static_cast<T>(std::sqrt(nrm2_x));
 
     // Project onto y = Ax.
     T proj_tol = kProjTolMin / std::pow(static_cast<T>(k + 1), kProjTolPow);
     proj_tol = std::max(proj_tol, kProjTolMax);
-    _P.Project(xtemp.data, ytemp.data, kOne, x.data, y.data, proj_tol);
+    _P.Project(xtemp.data, ytemp.data, kOne, x.data, y.data, proj_tol,
+        _proj_work);
 
     // Calculate residuals.
-    gsl::vector_memcpy(&ztemp, &zprev);
-    gsl::blas_axpy(-kOne, &z, &ztemp);
-    nrm_s = _rho * gsl::blas_nrm2(&ztemp);
-
-    gsl::vector_memcpy(&ztemp, &z12);
-    gsl::blas_axpy(-kOne, &z, &ztemp);
-    nrm_r = gsl::blas_nrm2(&ztemp);
+    double nrm2_s, nrm2_r;
+    ResidualNorms(m + n, zprev.data, z12.data, z.data, &nrm2_s, &nrm2_r);
+    nrm_s = _rho * static_cast<T>(std::sqrt(nrm2_s));
+    nrm_r = static_cast<T>(std::sqrt(nrm2_r));
 
     // Calculate exact residuals only if necessary.
     bool exact = false;
+    bool use_exact_stop = _exact_freq > 0 && k % _exact_freq == 0;
     if ((nrm_r < eps_pri && nrm_s < eps_dua) || use_exact_stop) {
-      gsl::vector_memcpy(&ztemp, &z12);
+      gsl::vector_memcpy(&ytemp, &y12);
       _A.Mul('n', kOne, x12.data, -kOne, ytemp.data);
       nrm_r = gsl::blas_nrm2(&ytemp);
       if ((nrm_r < eps_pri) || use_exact_stop) {
-        gsl::vector_memcpy(&ztemp, &z12);
-        gsl::blas_axpy(kOne, &zt, &ztemp);
-        gsl::blas_axpy(-kOne, &zprev, &ztemp);
+        AddSub(m + n, z12.data, zt.data, zprev.data, ztemp.data);
         _A.Mul('t', kOne, ytemp.data, kOne, xtemp.data);
         nrm_s = _rho * gsl::blas_nrm2(&xtemp);
         exact = true;
+      } else {
+        ++matvec_saved;
       }
+    } else {
+      matvec_saved += 2;
     }
 
     // Evaluate stopping criteria.
@@ -262,7 +515,7 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
     if ((_verbose > 2 && k % 10  == 0) ||
         (_verbose > 1 && k % 100 == 0) ||
         (_verbose > 1 && converged)) {
-      T optval = FuncEval(f_cpu, y12.data) + FuncEval(g_cpu, x12.data);
+      T optval = f_ops.func(f_cpu, y12.data) + g_ops.func(g_cpu, x12.data);
       Printf("%5d : %.2e  %.2e  %.2e  %.2e  %.2e  %.2e % .2e\n",
           k, nrm_r, eps_pri, nrm_s, eps_dua, gap, eps_gap, optval);
     }
@@ -270,15 +523,30 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
     // Break if converged or there are nans
     if (converged || k == _max_iter - 1){
       _final_iter = k;
+      _final_matvec_saved = matvec_saved;
+      _final_aa_accepted = aa_accepted;
+      _final_aa_rejected = aa_rejected;
+      _final_krylov_iter = _P.GetKrylovStats().iters - krylov_iter0;
+      _final_prox_stats = prox_stats;
       break;
     }
 
     // Update dual variable.
-    gsl::blas_axpy(kAlpha, &z12, &zt);
-    gsl::blas_axpy(kOne - kAlpha, &zprev, &zt);
-    gsl::blas_axpy(-kOne, &z, &zt);
+    if (aa != 0)
+      aa->SetIterate(zprev.data, zt.data);
+    DualUpdate(m + n, kAlpha, z12.data, zprev.data, z.data, zt.data);
+
+    // Anderson step on (z, zt).
+    if (aa != 0) {
+      int aa_status = aa->Step(z.data, zt.data);
+      if (aa_status > 0)
+        ++aa_accepted;
+      else if (aa_status < 0)
+        ++aa_rejected;
+    }
 
     // Rescale rho.
+    T rho_prev = _rho;
     if (_adaptive_rho) {
       if (nrm_s < xi * eps_dua && nrm_r > xi * eps_pri &&
           kTau * static_cast<T>(k) > static_cast<T>(kd)) {
@@ -306,10 +574,14 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
         delta = kDeltaMin;
       }
     }
+
+    // The fixed-point map depends on rho, so the Anderson memory is stale.
+    if (aa != 0 && _rho != rho_prev)
+      aa->Reset();
   }
 
   // Get optimal value
-  _optval = FuncEval(f_cpu, y12.data) + FuncEval(g_cpu, x12.data);
+  _optval = f_ops.func(f_cpu, y12.data) + g_ops.func(g_cpu, x12.data);
 
   // Check status
   PogsStatus status;
@@ -325,8 +597,23 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
     Printf(__HBAR__
         "Status: %s\n"
         "Timing: Total = %3.2e s, Init = %3.2e s\n"
-        "Iter  : %u\n",
-        PogsStatusString(status).c_str(), timer<double>() - t0, time_init, k);
+        "Iter  : %u\n"
+        "Matvec: %u saved on residuals\n",
+        PogsStatusString(status).c_str(), timer<double>() - t0, time_init, k,
+        matvec_saved);
+    if (aa != 0)
+      Printf("AA    : %u accepted, %u rejected\n", aa_accepted, aa_rejected);
+    if (_final_krylov_iter > 0)
+      Printf("Krylov: %u iterations, %.1f per ADMM iteration\n",
+          _final_krylov_iter,
+          static_cast<double>(_final_krylov_iter) / (k + 1));
+    if (prox_stats.elements > 0)
+      Printf("Prox  : %.2f inner iterations per element\n",
+          static_cast<double>(prox_stats.iters) / prox_stats.elements);
+    FactorStats factor_stats = _P.GetFactorStats();
+    if (factor_stats.misses > 0)
+      Printf("Factor: %u hits, %u misses, %3.2e s\n", factor_stats.hits,
+          factor_stats.misses, factor_stats.time);
     Printf(__HBAR__
         "Error Metrics:\n"
         "Pri: "
@@ -340,9 +627,7 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   }
 
   // Scale x, y, lambda and mu for output.
-  gsl::vector_memcpy(&ztemp, &zt);
-  gsl::blas_axpy(-kOne, &zprev, &ztemp);
-  gsl::blas_axpy(kOne, &z12, &ztemp);
+  AddSub(m + n, z12.data, zt.data, zprev.data, ztemp.data);
   gsl::blas_scal(-_rho, &ztemp);
   gsl::vector_mul(&ytemp, &d);
   gsl::vector_div(&xtemp, &e);
@@ -350,30 +635,330 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   gsl::vector_div(&y12, &d);
   gsl::vector_mul(&x12, &e);
 
-  // Copy results to output.
-  gsl::vector_memcpy(_x, &x12);
-  gsl::vector_memcpy(_y, &y12);
-  gsl::vector_memcpy(_mu, &xtemp);
-  gsl::vector_memcpy(_lambda, &ytemp);
+  // Copy results to output, undoing any reordering.
+  Scatter(n, _A.ColPerm(), x12.data, _x);
+  Scatter(m, _A.RowPerm(), y12.data, _y);
+  Scatter(n, _A.ColPerm(), xtemp.data, _mu);
+  Scatter(m, _A.RowPerm(), ytemp.data, _lambda);
 
   // Store z.
   gsl::vector_memcpy(&z, &zprev);
 
-  // Free memory.
-  gsl::vector_free(&z12);
-  gsl::vector_free(&zprev);
-  gsl::vector_free(&ztemp);
+  return status;
+}
+
+template <typename T, typename M, typename P>
+std::vector<PogsStatus> Pogs<T, M, P>::SolveBatch(
+    const std::vector<std::vector<FunctionObj<T> > > &f,
+    const std::vector<std::vector<FunctionObj<T> > > &g,
+    T *x, T *y, T *mu, T *lambda, T *optval) {
+  double t0 = timer<double>();
+  unsigned int krylov_iter0 = _P.GetKrylovStats().iters;
+  // Constants for adaptive-rho and over-relaxation.
+  const T kDeltaMin   = static_cast<T>(1.05);
+  const T kGamma      = static_cast<T>(1.01);
+  const T kTau        = static_cast<T>(0.8);
+  const T kAlpha      = static_cast<T>(1.7);
+  const T kRhoMin     = static_cast<T>(1e-4);
+  const T kRhoMax     = static_cast<T>(1e4);
+  const T kKappa      = static_cast<T>(0.9);
+  const T kOne        = static_cast<T>(1.0);
+  const T kProjTolMax = static_cast<T>(1e-8);
+  const T kProjTolMin = static_cast<T>(1e-2);
+  const T kProjTolPow = static_cast<T>(1.3);
+
+  DEBUG_EXPECT_EQ(f.size(), g.size());
+  size_t num = std::min(f.size(), g.size());
+  std::vector<PogsStatus> status(num, POGS_ERROR);
+  if (num == 0)
+    return status;
+
+  // Initialize Projector P and Matrix A.
+  if (!_done_init)
+    _Init();
+
+  size_t m = _A.Rows();
+  size_t n = _A.Cols();
+  size_t ld = m + n;
+
+  gsl::vector<T> de = gsl::vector_view_array(_de, m + n);
+  gsl::vector<T> d  = gsl::vector_subvector(&de, 0, m);
+  gsl::vector<T> e  = gsl::vector_subvector(&de, m, n);
+
+  // Permute f and g to the order of the rows and columns of A after any
+  // reordering, and scale them to account for diagonal scaling e and d.
+  std::vector<FunctionVector<T> > f_cpu(num), g_cpu(num);
+  std::vector<std::vector<FunctionRun> > f_runs(num), g_runs(num);
+  for (size_t i = 0; i < num; ++i) {
+    DEBUG_EXPECT_EQ(f[i].size(), m);
+    DEBUG_EXPECT_EQ(g[i].size(), n);
+    f_cpu[i].Assign(f[i], _A.RowPerm());
+    g_cpu[i].Assign(g[i], _A.ColPerm());
+    ScaleFunctions(d.data, std::divides<T>(), &f_cpu[i]);
+    ScaleFunctions(e.data, std::multiplies<T>(), &g_cpu[i]);
+    FunctionRuns(f_cpu[i], &f_runs[i]);
+    FunctionRuns(g_cpu[i], &g_runs[i]);
+  }
+
+  // The iterates of the problem in slot j are stored at offset j * ld. Slots
+  // [0, num_active) hold the problems that are still running.
+  std::vector<T> work(5 * num * ld, static_cast<T>(0));
+  T *z_all     = work.data();
+  T *zt_all    = z_all + num * ld;
+  T *zprev_all = zt_all + num * ld;
+  T *ztemp_all = zprev_all + num * ld;
+  T *z12_all   = ztemp_all + num * ld;
+  T *slots[] = { z_all, zt_all, zprev_all, ztemp_all, z12_all };
+
+  // Projector state of each problem, moved along with its slot.
+  std::vector<void*> proj_work(num);
+  for (size_t i = 0; i < num; ++i)
+    proj_work[i] = _P.NewWork();
+
+  std::vector<BatchState<T> > state(num);
+  for (size_t i = 0; i < num; ++i) {
+    state[i].id = i;
+    state[i].rho = _rho;
+    state[i].delta = kDeltaMin;
+    state[i].xi = kOne;
+    state[i].kd = state[i].ku = 0u;
+  }
+
+  // Signal start of execution.
+  if (_verbose > 0) {
+    Printf(__HBAR__
+        "           POGS v%s - Proximal Graph Solver                      \n"
+        "           (c) Christopher Fougner, Stanford University 2014-2015\n",
+        POGS_VERSION.c_str());
+  }
+  if (_verbose > 1) {
+    Printf(__HBAR__
+        " Prob |  Iter | pri res | pri tol | dua res | dua tol |   gap   |"
+        " pri obj\n" __HBAR__);
+  }
+
+  // Initialize scalars.
+  T sqrtn_atol = std::sqrt(static_cast<T>(n)) * _abs_tol;
+  T sqrtm_atol = std::sqrt(static_cast<T>(m)) * _abs_tol;
+  T sqrtmn_atol = std::sqrt(static_cast<T>(m + n)) * _abs_tol;
+  size_t num_active = num, num_solved = 0;
+  bool prox_warm = _prox_warm_start && _prox_accuracy == kProxAccurate;
+  ProxStats prox_stats = { 0, 0 };
+  _final_iter = 0;
+
+  for (unsigned int k = 0u; num_active > 0; ++k) {
+    // Evaluate proximal operators, tolerances and over relaxation.
+    for (size_t j = 0; j < num_active; ++j) {
+      BatchState<T> &st = state[j];
+      T *z = z_all + j * ld, *zt = zt_all + j * ld, *zprev = zprev_all + j * ld;
+      T *ztemp = ztemp_all + j * ld, *z12 = z12_all + j * ld;
+      SaveAndShift(ld, zt, z, zprev);
+      if (prox_warm) {
+        ProxEvalWarm(g_cpu[st.id], g_runs[st.id], st.rho, z, z12, k > 0,
+            &prox_stats);
+        ProxEvalWarm(f_cpu[st.id], f_runs[st.id], st.rho, z + n, z12 + n,
+            k > 0, &prox_stats);
+      } else {
+        ProxEval(g_cpu[st.id], g_runs[st.id], st.rho, z, z12, _prox_accuracy);
+        ProxEval(f_cpu[st.id], f_runs[st.id], st.rho, z + n, z12 + n,
+            _prox_accuracy);
+      }
+
+      double dot_x, dot_y, nrm2_x, nrm2_y, nrm2_x12, nrm2_y12;
+      DiffRelax<T>(0, n, kAlpha, zt, z12, zprev, z, ztemp, &dot_x, &nrm2_x,
+          &nrm2_x12);
+      DiffRelax<T>(n, ld, kAlpha, zt, z12, zprev, z, ztemp, &dot_y, &nrm2_y,
+          &nrm2_y12);
+      st.gap = std::abs(static_cast<T>(dot_x + dot_y));
+      st.eps_gap = sqrtmn_atol + _rel_tol *
+          static_cast<T>(std::sqrt(nrm2_x + nrm2_y)) *
+          static_cast<T>(std::sqrt(nrm2_x12 + nrm2_y12));
+      st.eps_pri = sqrtm_atol + _rel_tol *
+          static_cast<T>(std::sqrt(nrm2_y12));
+      st.eps_dua = sqrtn_atol + _rel_tol * st.rho *
+          static_cast<T>(std::sqrt(nrm2_x));
+    }
+
+    // Project all active problems onto y = Ax at once.
+    T proj_tol = kProjTolMin / std::pow(static_cast<T>(k + 1), kProjTolPow);
+    proj_tol = std::max(proj_tol, kProjTolMax);
+    _P.ProjectBatch(num_active, ztemp_all, ztemp_all + n, ld, kOne, z_all,
+        z_all + n, proj_tol, proj_work.data());
+
+    // Calculate residuals.
+    bool use_exact_stop = _exact_freq > 0 && k % _exact_freq == 0;
+    bool exact_pri = use_exact_stop;
+    for (size_t j = 0; j < num_active; ++j) {
+      BatchState<T> &st = state[j];
+      double nrm2_s, nrm2_r;
+      ResidualNorms(ld, zprev_all + j * ld, z12_all + j * ld, z_all + j * ld,
+          &nrm2_s, &nrm2_r);
+      st.nrm_s = st.rho * static_cast<T>(std::sqrt(nrm2_s));
+      st.nrm_r = static_cast<T>(std::sqrt(nrm2_r));
+      st.exact = false;
+      exact_pri = exact_pri || (st.nrm_r < st.eps_pri && st.nrm_s < st.eps_dua);
+    }
+
+    // Exact residuals are computed for the whole batch if any problem needs
+    // them, since the matvecs are shared.
+    if (exact_pri) {
+      for (size_t j = 0; j < num_active; ++j)
+        memcpy(ztemp_all + j * ld + n, z12_all + j * ld + n, m * sizeof(T));
+      _A.MulBatch('n', num_active, kOne, z12_all, ld, -kOne, ztemp_all + n,
+          ld);
+      bool exact_dua = use_exact_stop;
+      for (size_t j = 0; j < num_active; ++j) {
+        gsl::vector<T> ytemp =
+            gsl::vector_view_array(ztemp_all + j * ld + n, m);
+        state[j].nrm_r = gsl::blas_nrm2(&ytemp);
+        exact_dua = exact_dua || state[j].nrm_r < state[j].eps_pri;
+      }
+      if (exact_dua) {
+        for (size_t j = 0; j < num_active; ++j)
+          AddSub(ld, z12_all + j * ld, zt_all + j * ld, zprev_all + j * ld,
+              ztemp_all + j * ld);
+        _A.MulBatch('t', num_active, kOne, ztemp_all + n, ld, kOne, ztemp_all,
+            ld);
+        for (size_t j = 0; j < num_active; ++j) {
+          gsl::vector<T> xtemp = gsl::vector_view_array(ztemp_all + j * ld, n);
+          state[j].nrm_s = state[j].rho * gsl::blas_nrm2(&xtemp);
+          state[j].exact = true;
+        }
+      }
+    }
+
+    // Retire problems that have stopped, update the rest.
+    for (size_t j = 0; j < num_active; ) {
+      BatchState<T> &st = state[j];
+      T *zt = zt_all + j * ld, *zprev = zprev_all + j * ld;
+      T *ztemp = ztemp_all + j * ld, *z12 = z12_all + j * ld;
+
+      bool converged = st.exact && st.nrm_r < st.eps_pri &&
+          st.nrm_s < st.eps_dua && (!_gap_stop || st.gap < st.eps_gap);
+      if (converged || k == _max_iter - 1) {
+        size_t id = st.id;
+        T optval_i = FuncEval(f_cpu[id], z12 + n) + FuncEval(g_cpu[id], z12);
+        status[id] = converged ? POGS_SUCCESS : POGS_MAX_ITER;
+        num_solved += converged;
+        _final_iter = k;
+        if (_verbose > 1) {
+          Printf("%5u : %5u  %.2e  %.2e  %.2e  %.2e  %.2e % .2e\n",
+              static_cast<unsigned int>(id), k, st.nrm_r, st.eps_pri,
+              st.nrm_s, st.eps_dua, st.gap, optval_i);
+        }
+
+        // Scale x, y, lambda and mu for output.
+        gsl::vector<T> ztemp_vec = gsl::vector_view_array(ztemp, ld);
+        gsl::vector<T> xtemp = gsl::vector_subvector(&ztemp_vec, 0, n);
+        gsl::vector<T> ytemp = gsl::vector_subvector(&ztemp_vec, n, m);
+        gsl::vector<T> x12 = gsl::vector_view_array(z12, n);
+        gsl::vector<T> y12 = gsl::vector_view_array(z12 + n, m);
+        AddSub(ld, z12, zt, zprev, ztemp);
+        gsl::blas_scal(-st.rho, &ztemp_vec);
+        gsl::vector_mul(&ytemp, &d);
+        gsl::vector_div(&xtemp, &e);
+        gsl::vector_div(&y12, &d);
+        gsl::vector_mul(&x12, &e);
+
+        // Copy results to output, undoing any reordering.
+        if (x)
+          Scatter(n, _A.ColPerm(), x12.data, x + id * n);
+        if (y)
+          Scatter(m, _A.RowPerm(), y12.data, y + id * m);
+        if (mu)
+          Scatter(n, _A.ColPerm(), xtemp.data, mu + id * n);
+        if (lambda)
+          Scatter(m, _A.RowPerm(), ytemp.data, lambda + id * m);
+        if (optval)
+          optval[id] = optval_i;
+
+        // Move the last active problem into this slot.
+        --num_active;
+        if (j != num_active) {
+          std::swap(state[j], state[num_active]);
+          std::swap(proj_work[j], proj_work[num_active]);
+          for (unsigned int l = 0; l < sizeof(slots) / sizeof(slots[0]); ++l)
+            std::swap_ranges(slots[l] + j * ld, slots[l] + (j + 1) * ld,
+                slots[l] + num_active * ld);
+        }
+        continue;
+      }
+
+      // Update dual variable.
+      DualUpdate(ld, kAlpha, z12, zprev, z_all + j * ld, zt);
+
+      // Rescale rho.
+      if (_adaptive_rho) {
+        gsl::vector<T> zt_vec = gsl::vector_view_array(zt, ld);
+        if (st.nrm_s < st.xi * st.eps_dua && st.nrm_r > st.xi * st.eps_pri &&
+            kTau * static_cast<T>(k) > static_cast<T>(st.kd)) {
+          if (st.rho < kRhoMax) {
+            st.rho *= st.delta;
+            gsl::blas_scal(1 / st.delta, &zt_vec);
+            st.delta = kGamma * st.delta;
+            st.ku = k;
+          }
+        } else if (st.nrm_s > st.xi * st.eps_dua &&
+            st.nrm_r < st.xi * st.eps_pri &&
+            kTau * static_cast<T>(k) > static_cast<T>(st.ku)) {
+          if (st.rho > kRhoMin) {
+            st.rho /= st.delta;
+            gsl::blas_scal(st.delta, &zt_vec);
+            st.delta = kGamma * st.delta;
+            st.kd = k;
+          }
+        } else if (st.nrm_s < st.xi * st.eps_dua &&
+            st.nrm_r < st.xi * st.eps_pri) {
+          st.xi *= kKappa;
+        } else {
+          st.delta = kDeltaMin;
+        }
+      }
+      ++j;
+    }
+  }
+
+  _final_krylov_iter = _P.GetKrylovStats().iters - krylov_iter0;
+  _final_prox_stats = prox_stats;
+  for (size_t i = 0; i < num; ++i)
+    _P.DeleteWork(proj_work[i]);
+
+  // Print summary
+  if (_verbose > 0) {
+    Printf(__HBAR__
+        "Status: %u of %u solved\n"
+        "Timing: Total = %3.2e s\n"
+        "Iter  : %u\n",
+        static_cast<unsigned int>(num_solved), static_cast<unsigned int>(num),
+        timer<double>() - t0, _final_iter);
+    if (_final_krylov_iter > 0)
+      Printf("Krylov: %u iterations\n", _final_krylov_iter);
+    if (prox_stats.elements > 0)
+      Printf("Prox  : %.2f inner iterations per element\n",
+          static_cast<double>(prox_stats.iters) / prox_stats.elements);
+    Printf(__HBAR__);
+  }
 
   return status;
 }
 
 template <typename T, typename M, typename P>
 Pogs<T, M, P>::~Pogs() {
-  delete [] _de;
   delete [] _z;
   delete [] _zt;
   _de = _z = _zt = 0;
 
+  delete [] _zprev;
+  delete [] _ztemp;
+  delete [] _z12;
+  _zprev = _ztemp = _z12 = 0;
+
+  delete static_cast<Anderson<T>*>(_anderson);
+  _anderson = 0;
+
+  _P.DeleteWork(_proj_work);
+  _proj_work = 0;
+
   delete [] _x;
   delete [] _y;
   delete [] _mu;
@@ -387,8 +972,34 @@ template class Pogs<double, MatrixDense<double>,
     ProjectorDirect<double, MatrixDense<double> > >;
 template class Pogs<double, MatrixDense<double>,
     ProjectorCgls<double, MatrixDense<double> > >;
+template class Pogs<double, MatrixDense<double>,
+    ProjectorEig<double, MatrixDense<double> > >;
+template class Pogs<double, MatrixDense<double>,
+    ProjectorLsmr<double, MatrixDense<double> > >;
+template class Pogs<double, MatrixSparse<double>,
+    ProjectorDirect<double, MatrixSparse<double> > >;
 template class Pogs<double, MatrixSparse<double>,
     ProjectorCgls<double, MatrixSparse<double> > >;
+template class Pogs<double, MatrixSparse<double>,
+    ProjectorLsmr<double, MatrixSparse<double> > >;
+template class Pogs<double, MatrixSparse<double, POGS_INT64>,
+    ProjectorCgls<double, MatrixSparse<double, POGS_INT64> > >;
+template class PogsPrepared<double, MatrixDense<double>,
+    ProjectorDirect<double, MatrixDense<double> > >;
+template class PogsPrepared<double, MatrixDense<double>,
+    ProjectorCgls<double, MatrixDense<double> > >;
+template class PogsPrepared<double, MatrixDense<double>,
+    ProjectorEig<double, MatrixDense<double> > >;
+template class PogsPrepared<double, MatrixDense<double>,
+    ProjectorLsmr<double, MatrixDense<double> > >;
+template class PogsPrepared<double, MatrixSparse<double>,
+    ProjectorDirect<double, MatrixSparse<double> > >;
+template class PogsPrepared<double, MatrixSparse<double>,
+    ProjectorCgls<double, MatrixSparse<double> > >;
+template class PogsPrepared<double, MatrixSparse<double>,
+    ProjectorLsmr<double, MatrixSparse<double> > >;
+template class PogsPrepared<double, MatrixSparse<double, POGS_INT64>,
+    ProjectorCgls<double, MatrixSparse<double, POGS_INT64> > >;
 #endif
 
 #if !defined(POGS_SINGLE) || POGS_SINGLE==1
@@ -396,8 +1007,34 @@ template class Pogs<float, MatrixDense<float>,
     ProjectorDirect<float, MatrixDense<float> > >;
 template class Pogs<float, MatrixDense<float>,
     ProjectorCgls<float, MatrixDense<float> > >;
+template class Pogs<float, MatrixDense<float>,
+    ProjectorEig<float, MatrixDense<float> > >;
+template class Pogs<float, MatrixDense<float>,
+    ProjectorLsmr<float, MatrixDense<float> > >;
 template class Pogs<float, MatrixSparse<float>,
+    ProjectorDirect<float, MatrixSparse<float> > >;
+template class Pogs<float, MatrixSparse<float>,
+    ProjectorCgls<float, MatrixSparse<float> > >;
+template class Pogs<float, MatrixSparse<float>,
+    ProjectorLsmr<float, MatrixSparse<float> > >;
+template class Pogs<float, MatrixSparse<float, POGS_INT64>,
+    ProjectorCgls<float, MatrixSparse<float, POGS_INT64> > >;
+template class PogsPrepared<float, MatrixDense<float>,
+    ProjectorDirect<float, MatrixDense<float> > >;
+template class PogsPrepared<float, MatrixDense<float>,
+    ProjectorCgls<float, MatrixDense<float> > >;
+template class PogsPrepared<float, MatrixDense<float>,
+    ProjectorEig<float, MatrixDense<float> > >;
+template class PogsPrepared<float, MatrixDense<float>,
+    ProjectorLsmr<float, MatrixDense<float> > >;
+template class PogsPrepared<float, MatrixSparse<float>,
+    ProjectorDirect<float, MatrixSparse<float> > >;
+template class PogsPrepared<float, MatrixSparse<float>,
     ProjectorCgls<float, MatrixSparse<float> > >;
+template class PogsPrepared<float, MatrixSparse<float>,
+    ProjectorLsmr<float, MatrixSparse<float> > >;
+template class PogsPrepared<float, MatrixSparse<float, POGS_INT64>,
+    ProjectorCgls<float, MatrixSparse<float, POGS_INT64> > >;
 #endif
 
 }  // namespace pogs
@@ -1,8 +1,11 @@
 #include <algorithm>
-#include <limits>
+#include <cstring>
+#include <vector>
 
 #include "cgls.h"
+#include "cgls_precond.h"
 #include "gsl/gsl_blas.h"
+#include "gsl/gsl_spmat.h"
 #include "gsl/gsl_vector.h"
 #include "matrix/matrix_dense.h"
 #include "matrix/matrix_sparse.h"
@@ -17,25 +20,170 @@ namespace {
 int kMaxIter = 100;
 bool kCglsQuiet = true;
 
-// CGLS Gemv struct for matrix multiplication.
-template <typename T, typename M>
-struct Gemv : cgls::Gemv<T> {
-  const M& A;
-  Gemv(const M& A) : A(A) { }
-  int operator()(char op, const T alpha, const T *x, const T beta, T *y)
-      const {
-    return A.Mul(op, alpha, x, beta, y);
+// State of one session: warm start, CGLS workspace and the incomplete
+// Cholesky factor for the last s.
+template <typename T>
+struct Work {
+  KrylovWarmStart<T> warm;
+  cgls::Workspace<T> cgls;
+  cgls::IncCholPrecond<T> inc_chol;
+};
+
+// Settings and preconditioner data, read only after Init, and the counters.
+template <typename T>
+struct CpuData {
+  bool warm_start;
+  KrylovCounters counters;
+  CglsPrecond precond;
+  std::vector<T> col_nrm2;
+  cgls::IncChol<T> *inc_chol;
+  CpuData(CglsPrecond precond)
+      : warm_start(true), precond(precond), inc_chol(0) { }
+  ~CpuData() {
+    delete inc_chol;
   }
 };
 
+// Squared column norms of A.
+template <typename T>
+void ColNrm2(const MatrixDense<T>& A, T *nrm2) {
+  size_t m = A.Rows();
+  size_t n = A.Cols();
+  const T *data = A.Data();
+  memset(nrm2, 0, n * sizeof(T));
+  if (A.Order() == MatrixDense<T>::ROW) {
+    for (size_t i = 0; i < m; ++i)
+      for (size_t j = 0; j < n; ++j)
+        nrm2[j] += data[i * n + j] * data[i * n + j];
+  } else {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t j = 0; j < n; ++j)
+      for (size_t i = 0; i < m; ++i)
+        nrm2[j] += data[i + j * m] * data[i + j * m];
+  }
+}
+
+template <typename T, typename I>
+void ColNrm2(const MatrixSparse<T, I>& A, T *nrm2) {
+  size_t n = A.Cols();
+  memset(nrm2, 0, n * sizeof(T));
+  if (A.Order() == MatrixSparse<T, I>::ROW) {
+    for (I l = 0; l < A.Nnz(); ++l)
+      nrm2[A.Ind()[l]] += A.Data()[l] * A.Data()[l];
+  } else {
+    for (size_t j = 0; j < n; ++j)
+      for (I l = A.Ptr()[j]; l < A.Ptr()[j + 1]; ++l)
+        nrm2[j] += A.Data()[l] * A.Data()[l];
+  }
+}
+
+// Incomplete Cholesky is only implemented for sparse A.
+template <typename T>
+cgls::IncChol<T>* NewIncChol(const MatrixDense<T>& A) {
+  return 0;
+}
+
+// IncCholPrecond has 32-bit indices, 64-bit matrices fall back to Jacobi.
+template <typename T>
+cgls::IncChol<T>* NewIncChol(const MatrixSparse<T, POGS_INT64>& A) {
+  return 0;
+}
+
+// MatrixSparse stores A in its own order followed by its transpose, which
+// gives both the CSC and the CSR arrays. Without the transpose, the other
+// orientation is built here and dropped once A'A is formed.
+template <typename T>
+cgls::IncChol<T>* NewIncChol(const MatrixSparse<T>& A) {
+  POGS_INT m = static_cast<POGS_INT>(A.Rows());
+  POGS_INT n = static_cast<POGS_INT>(A.Cols());
+  POGS_INT nnz = A.Nnz();
+  bool row = A.Order() == MatrixSparse<T>::ROW;
+  const T *val = A.Data(), *val_t = val + nnz;
+  const POGS_INT *ptr = A.Ptr(), *ind = A.Ind();
+  const POGS_INT *ptr_t = ptr + (row ? m : n) + 1, *ind_t = ind + nnz;
+  std::vector<T> val_tmp;
+  std::vector<POGS_INT> ptr_tmp, ind_tmp;
+  if (!A.HasTranspose()) {
+    val_tmp.resize(nnz);
+    ind_tmp.resize(nnz);
+    ptr_tmp.resize((row ? n : m) + 1);
+    gsl::csr2csc(row ? m : n, row ? n : m, nnz, val, ptr, ind, val_tmp.data(),
+        ind_tmp.data(), ptr_tmp.data());
+    val_t = val_tmp.data();
+    ptr_t = ptr_tmp.data();
+    ind_t = ind_tmp.data();
+  }
+  if (row)
+    return new cgls::IncChol<T>(n, ptr_t, ind_t, val_t, ptr, ind, val);
+  else
+    return new cgls::IncChol<T>(n, ptr, ind, val, ptr_t, ind_t, val_t);
+}
+
+template <typename T, typename M>
+void SetupPrecond(const M& A, CpuData<T> *info) {
+  if (info->precond == kCglsPrecondIncChol && info->inc_chol == 0) {
+    info->inc_chol = NewIncChol(A);
+    if (info->inc_chol == 0)
+      info->precond = kCglsPrecondJacobi;
+  }
+  if (info->precond == kCglsPrecondJacobi && info->col_nrm2.empty()) {
+    info->col_nrm2.resize(A.Cols());
+    ColNrm2(A, info->col_nrm2.data());
+  }
+}
+
+template <typename T, typename M>
+int ProjectOne(const M& A, CpuData<T> *info, bool warm_start, const T *x0,
+               const T *y0, T s, T *x, T *y, T tol, Work<T> *work) {
+  size_t m = A.Rows();
+  size_t n = A.Cols();
+
+  unsigned int matvecs = 0;
+  double norms_ref = KrylovBegin(A, warm_start, x0, y0, x, y,
+      &work->warm, &matvecs);
+
+  // Preconditioner for A'A + sI.
+  const cgls::Precond<T> *precond = 0;
+  cgls::JacobiPrecond<T> jacobi(static_cast<cgls::INT>(n),
+      info->col_nrm2.data(), s);
+  if (info->precond == kCglsPrecondJacobi) {
+    precond = &jacobi;
+  } else if (info->precond == kCglsPrecondIncChol) {
+    // Unpreconditioned if the factorization breaks down.
+    if (work->inc_chol.Factor(info->inc_chol, s) == 0)
+      precond = &work->inc_chol;
+  }
+
+  // Minimize ||Ax - b||_2^2 + s||x||_2^2
+  int iter = 0;
+  cgls::Solve(CountingGemv<T, M>(A, &matvecs), static_cast<cgls::INT>(m),
+      static_cast<cgls::INT>(n), y, x, s, tol, kMaxIter, kCglsQuiet,
+      norms_ref, &iter, precond, &work->cgls);
+
+  KrylovEnd(A, warm_start, x0, x, y, &work->warm, iter, matvecs,
+      &info->counters);
+
+  return 0;
+}
+
 }  // namespace
 
 template <typename T, typename M>
-ProjectorCgls<T, M>::ProjectorCgls(const M& A)
-    : _A(A) { }
+ProjectorCgls<T, M>::ProjectorCgls(const M& A, CglsPrecond precond)
+    : _A(A) {
+  // Set CPU specific this->_info.
+  CpuData<T> *info = new CpuData<T>(precond);
+  this->_info = reinterpret_cast<void*>(info);
+}
 
 template <typename T, typename M>
-ProjectorCgls<T, M>::~ProjectorCgls() { }
+ProjectorCgls<T, M>::~ProjectorCgls() {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  delete info;
+  this->_info = 0;
+}
 
 template <typename T, typename M>
 int ProjectorCgls<T, M>::Init() {
@@ -45,35 +193,34 @@ int ProjectorCgls<T, M>::Init() {
 
   ASSERT(_A.IsInit());
 
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  SetupPrecond(_A, info);
+
   return 0;
 }
 
+template <typename T, typename M>
+void *ProjectorCgls<T, M>::NewWork() const {
+  return new Work<T>();
+}
+
+template <typename T, typename M>
+void ProjectorCgls<T, M>::DeleteWork(void *work) const {
+  delete reinterpret_cast<Work<T>*>(work);
+}
+
 template <typename T, typename M>
 int ProjectorCgls<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
-                                 T tol) {
+                                 T tol, void *work) {
   DEBUG_EXPECT(this->_done_init);
   DEBUG_EXPECT(s >= static_cast<T>(0.));
   if (!this->_done_init || s < static_cast<T>(0.))
     return 1;
 
-  // Set initial x and y.
-  memset(x, 0, _A.Cols() * sizeof(T));
-  memcpy(y, y0, _A.Rows() * sizeof(T));
-
-  // y := y0 - Ax0;
-  _A.Mul('n', static_cast<T>(-1.), x0, static_cast<T>(1.), y);
-
-  // Minimize ||Ax - b||_2^2 + s||x||_2^2
-  cgls::Solve(Gemv<T, M>(_A), static_cast<cgls::INT>(_A.Rows()),
-      static_cast<cgls::INT>(_A.Cols()), y, x, s, tol, kMaxIter, kCglsQuiet);
- 
-  // x := x + x0
-  gsl::vector<T> x_vec = gsl::vector_view_array(x, _A.Cols());
-  const gsl::vector<T> x0_vec = gsl::vector_view_array(x0, _A.Cols());
-  gsl::blas_axpy(static_cast<T>(1.), &x0_vec, &x_vec);
-
-  // y := Ax
-  _A.Mul('n', static_cast<T>(1.), x, static_cast<T>(0.), y);
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  Work<T> tmp;
+  ProjectOne(_A, info, info->warm_start && work, x0, y0, s, x, y, tol,
+      work ? reinterpret_cast<Work<T>*>(work) : &tmp);
 
 #ifdef DEBUG
   // Verify that projection was successful.
@@ -83,14 +230,62 @@ int ProjectorCgls<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
   return 0;
 }
 
+// CGLS has no multi-vector form, so solve one vector at a time.
+template <typename T, typename M>
+int ProjectorCgls<T, M>::ProjectBatch(size_t k, const T *x0, const T *y0,
+                                      size_t ld, T s, T *x, T *y, T tol,
+                                      void *const *work) {
+  DEBUG_EXPECT(this->_done_init);
+  DEBUG_EXPECT(s >= static_cast<T>(0.));
+  if (!this->_done_init || s < static_cast<T>(0.))
+    return 1;
+
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  Work<T> tmp;
+  for (size_t i = 0; i < k; ++i)
+    ProjectOne(_A, info, info->warm_start && work, x0 + i * ld, y0 + i * ld,
+        s, x + i * ld, y + i * ld, tol,
+        work ? reinterpret_cast<Work<T>*>(work[i]) : &tmp);
+  return 0;
+}
+
+template <typename T, typename M>
+void ProjectorCgls<T, M>::SetWarmStart(bool warm_start) {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  info->warm_start = warm_start;
+}
+
+template <typename T, typename M>
+void ProjectorCgls<T, M>::SetPrecond(CglsPrecond precond) {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  info->precond = precond;
+  if (this->_done_init)
+    SetupPrecond(_A, info);
+}
+
+template <typename T, typename M>
+FactorStats ProjectorCgls<T, M>::GetFactorStats() const {
+  FactorStats stats = { 0u, 0u, 0. };
+  return stats;
+}
+
+template <typename T, typename M>
+KrylovStats ProjectorCgls<T, M>::GetKrylovStats() const {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  return info->counters.Get();
+}
+
 #if !defined(POGS_DOUBLE) || POGS_DOUBLE==1
 template class ProjectorCgls<double, MatrixDense<double> >;
 template class ProjectorCgls<double, MatrixSparse<double> >;
+template class ProjectorCgls<double, MatrixSparse<double, POGS_INT64> >;
 #endif
 
 #if !defined(POGS_SINGLE) || POGS_SINGLE==1
 template class ProjectorCgls<float, MatrixDense<float> >;
 template class ProjectorCgls<float, MatrixSparse<float> >;
+template class ProjectorCgls<float, MatrixSparse<float, POGS_INT64> >;
 #endif
 
 }  // namespace pogs
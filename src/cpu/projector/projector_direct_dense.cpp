@@ -1,6 +1,9 @@
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <limits>
+#include <list>
+#include <utility>
 
 #include "gsl/cblas.h"
 #include "gsl/gsl_blas.h"
@@ -9,18 +12,73 @@
 #include "matrix/matrix_dense.h"
 #include "projector/projector_direct.h"
 #include "projector_helper.h"
+#include "timer.h"
 #include "util.h"
 
 namespace pogs {
 
 namespace {
 
+// Cholesky factors of AA + s * I for the most recently used values of s,
+// most recent first. A projection whose s is at the front of the cache only
+// reads it, so concurrent projections with the same s are safe.
 template<typename T>
 struct CpuData {
-  T *AA, *L, s;
-  CpuData() : AA(0), L(0), s(static_cast<T>(-1.)) { }
+  T *AA;
+  std::list<std::pair<T, T*> > factors;
+  size_t max_factors;
+  std::atomic<unsigned int> hits, misses;
+  double factor_time;
+  CpuData()
+      : AA(0), max_factors(1), hits(0), misses(0), factor_time(0.) { }
 };
 
+// L := chol(AA + s * I).
+template <typename T, CBLAS_ORDER O>
+void Factor(const T *AA_data, T *L_data, size_t min_dim, T s) {
+  const gsl::matrix<T, O> AA = gsl::matrix_view_array<T, O>
+      (AA_data, min_dim, min_dim);
+  gsl::matrix<T, O> L = gsl::matrix_view_array<T, O>
+      (L_data, min_dim, min_dim);
+  gsl::matrix_memcpy(&L, &AA);
+  gsl::vector<T> diagL = gsl::matrix_diagonal(&L);
+  gsl::vector_add_constant(&diagL, s);
+  gsl::linalg_cholesky_decomp(&L);
+}
+
+// Returns the factor of AA + s * I. On a miss the factor is computed,
+// replacing the least recently used one if the cache is full.
+template <typename T>
+const T* CachedFactor(CpuData<T> *info, bool row, size_t min_dim, T s) {
+  typename std::list<std::pair<T, T*> >::iterator it = info->factors.begin();
+  while (it != info->factors.end() && it->first != s)
+    ++it;
+  if (it != info->factors.end()) {
+    ++info->hits;
+    if (it != info->factors.begin())
+      info->factors.splice(info->factors.begin(), info->factors, it);
+    return info->factors.front().second;
+  }
+
+  ++info->misses;
+  double t0 = timer<double>();
+  T *L;
+  if (info->factors.size() < info->max_factors) {
+    L = new T[min_dim * min_dim];
+    ASSERT(L != 0);
+  } else {
+    L = info->factors.back().second;
+    info->factors.pop_back();
+  }
+  if (row)
+    Factor<T, CblasRowMajor>(info->AA, L, min_dim, s);
+  else
+    Factor<T, CblasColMajor>(info->AA, L, min_dim, s);
+  info->factors.push_front(std::make_pair(s, L));
+  info->factor_time += timer<double>() - t0;
+  return L;
+}
+
 }  // namespace
 
 template <typename T, typename M>
@@ -40,10 +98,10 @@ ProjectorDirect<T, M>::~ProjectorDirect() {
     info->AA = 0;
   }
 
-  if (info->L) {
-    delete [] info->L;
-    info->L = 0;
-  }
+  for (typename std::list<std::pair<T, T*> >::iterator it =
+      info->factors.begin(); it != info->factors.end(); ++it)
+    delete [] it->second;
+  info->factors.clear();
 
   delete info;
   this->_info = 0;
@@ -62,10 +120,7 @@ int ProjectorDirect<T, M>::Init() {
 
   info->AA = new T[min_dim * min_dim];
   ASSERT(info->AA != 0);
-  info->L = new T[min_dim * min_dim];
-  ASSERT(info->L != 0);
   memset(info->AA, 0, min_dim * min_dim * sizeof(T));
-  memset(info->L, 0, min_dim * min_dim * sizeof(T));
 
   CBLAS_TRANSPOSE_t op_type = _A.Rows() > _A.Cols() ? CblasTrans : CblasNoTrans;
 
@@ -91,9 +146,17 @@ int ProjectorDirect<T, M>::Init() {
   return 0;
 }
 
+template <typename T, typename M>
+void *ProjectorDirect<T, M>::NewWork() const {
+  return 0;
+}
+
+template <typename T, typename M>
+void ProjectorDirect<T, M>::DeleteWork(void *work) const { }
+
 template <typename T, typename M>
 int ProjectorDirect<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
-                                   T tol) {
+                                   T tol, void *work) {
   DEBUG_EXPECT(this->_done_init);
   if (!this->_done_init || s < static_cast<T>(0.))
     return 1;
@@ -116,17 +179,10 @@ int ProjectorDirect<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
     const gsl::matrix<T, CblasRowMajor> A =
         gsl::matrix_view_array<T, CblasRowMajor>
         (_A.Data(), _A.Rows(), _A.Cols());
-    gsl::matrix<T, CblasRowMajor> AA = gsl::matrix_view_array<T, CblasRowMajor>
-        (info->AA, min_dim, min_dim);
-    gsl::matrix<T, CblasRowMajor> L = gsl::matrix_view_array<T, CblasRowMajor>
-        (info->L, min_dim, min_dim);
-
-    if (s != info->s) {
-      gsl::matrix_memcpy(&L, &AA);
-      gsl::vector<T> diagL = gsl::matrix_diagonal(&L);
-      gsl::vector_add_constant(&diagL, s);
-      gsl::linalg_cholesky_decomp(&L);
-    }
+    const gsl::matrix<T, CblasRowMajor> L =
+        gsl::matrix_view_array<T, CblasRowMajor>
+        (CachedFactor(info, true, min_dim, s), min_dim, min_dim);
+
     if (_A.Rows() > _A.Cols()) {
       gsl::blas_gemv(CblasTrans, static_cast<T>(1.), &A, &y_vec,
           static_cast<T>(1.), &x_vec);
@@ -145,17 +201,10 @@ int ProjectorDirect<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
     const gsl::matrix<T, CblasColMajor> A =
         gsl::matrix_view_array<T, CblasColMajor>
         (_A.Data(), _A.Rows(), _A.Cols());
-    gsl::matrix<T, CblasColMajor> AA = gsl::matrix_view_array<T, CblasColMajor>
-        (info->AA, min_dim, min_dim);
-    gsl::matrix<T, CblasColMajor> L = gsl::matrix_view_array<T, CblasColMajor>
-        (info->L, min_dim, min_dim);
-
-    if (s != info->s) {
-      gsl::matrix_memcpy(&L, &AA);
-      gsl::vector<T> diagL = gsl::matrix_diagonal(&L);
-      gsl::vector_add_constant(&diagL, s);
-      gsl::linalg_cholesky_decomp(&L);
-    }
+    const gsl::matrix<T, CblasColMajor> L =
+        gsl::matrix_view_array<T, CblasColMajor>
+        (CachedFactor(info, false, min_dim, s), min_dim, min_dim);
+
     if (_A.Rows() > _A.Cols()) {
       gsl::blas_gemv(CblasTrans, static_cast<T>(1.), &A, &y_vec,
           static_cast<T>(1.), &x_vec);
@@ -178,10 +227,105 @@ int ProjectorDirect<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
       static_cast<T>(1e3) * std::numeric_limits<T>::epsilon());
 #endif
 
-  info->s = s;
   return 0;
 }
 
+template <typename T, typename M>
+int ProjectorDirect<T, M>::ProjectBatch(size_t k, const T *x0, const T *y0,
+                                        size_t ld, T s, T *x, T *y, T tol,
+                                        void *const *work) {
+  DEBUG_EXPECT(this->_done_init);
+  if (!this->_done_init || s < static_cast<T>(0.))
+    return 1;
+
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  size_t m = _A.Rows();
+  size_t n = _A.Cols();
+  size_t min_dim = std::min(m, n);
+  bool row = _A.Order() == MatrixDense<T>::ROW;
+
+  // Set (x, y) = (x0, y0).
+  for (size_t i = 0; i < k; ++i) {
+    memcpy(x + i * ld, x0 + i * ld, n * sizeof(T));
+    memcpy(y + i * ld, y0 + i * ld, m * sizeof(T));
+  }
+
+  // Work with column major views throughout. Row major A and L are then
+  // A^T and L^T, which is accounted for by flipping op and uplo.
+  const gsl::matrix<T, CblasColMajor> A = row ?
+      gsl::matrix_view_array<T, CblasColMajor>(_A.Data(), n, m) :
+      gsl::matrix_view_array<T, CblasColMajor>(_A.Data(), m, n);
+  const gsl::matrix<T, CblasColMajor> L =
+      gsl::matrix_view_array<T, CblasColMajor>
+      (CachedFactor(info, row, min_dim, s), min_dim, min_dim);
+  CBLAS_TRANSPOSE_t op_n = row ? CblasTrans : CblasNoTrans;
+  CBLAS_TRANSPOSE_t op_t = row ? CblasNoTrans : CblasTrans;
+  CBLAS_UPLO_t uplo = row ? CblasUpper : CblasLower;
+
+  gsl::matrix<T, CblasColMajor> x_mat =
+      gsl::matrix_view_array<T, CblasColMajor>(x, n, k, ld);
+  gsl::matrix<T, CblasColMajor> y_mat =
+      gsl::matrix_view_array<T, CblasColMajor>(y, m, k, ld);
+
+  if (m > n) {
+    gsl::blas_gemm(op_t, CblasNoTrans, static_cast<T>(1.), &A, &y_mat,
+        static_cast<T>(1.), &x_mat);
+    gsl::blas_trsm(CblasLeft, uplo, op_n, CblasNonUnit, static_cast<T>(1.),
+        &L, &x_mat);
+    gsl::blas_trsm(CblasLeft, uplo, op_t, CblasNonUnit, static_cast<T>(1.),
+        &L, &x_mat);
+    gsl::blas_gemm(op_n, CblasNoTrans, static_cast<T>(1.), &A, &x_mat,
+        static_cast<T>(0.), &y_mat);
+  } else {
+    gsl::blas_gemm(op_n, CblasNoTrans, static_cast<T>(1.), &A, &x_mat,
+        static_cast<T>(-1.), &y_mat);
+    gsl::blas_trsm(CblasLeft, uplo, op_n, CblasNonUnit, static_cast<T>(1.),
+        &L, &y_mat);
+    gsl::blas_trsm(CblasLeft, uplo, op_t, CblasNonUnit, static_cast<T>(1.),
+        &L, &y_mat);
+    gsl::blas_gemm(op_t, CblasNoTrans, static_cast<T>(-1.), &A, &y_mat,
+        static_cast<T>(1.), &x_mat);
+    for (size_t i = 0; i < k; ++i) {
+      gsl::vector<T> y_i = gsl::matrix_column(&y_mat, i);
+      const gsl::vector<T> y0_i = gsl::vector_view_array(y0 + i * ld, m);
+      gsl::blas_axpy(static_cast<T>(1.), &y0_i, &y_i);
+    }
+  }
+
+  return 0;
+}
+
+template <typename T, typename M>
+void ProjectorDirect<T, M>::SetFactorCacheBytes(size_t bytes) {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  size_t min_dim = std::min(_A.Rows(), _A.Cols());
+  size_t factor_bytes = std::max<size_t>(min_dim * min_dim * sizeof(T), 1);
+  info->max_factors = std::max<size_t>(bytes / factor_bytes, 1);
+  while (info->factors.size() > info->max_factors) {
+    delete [] info->factors.back().second;
+    info->factors.pop_back();
+  }
+}
+
+template <typename T, typename M>
+FactorStats ProjectorDirect<T, M>::GetFactorStats() const {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  FactorStats stats;
+  stats.hits = info->hits;
+  stats.misses = info->misses;
+  stats.time = info->factor_time;
+  return stats;
+}
+
+template <typename T, typename M>
+KrylovStats ProjectorDirect<T, M>::GetKrylovStats() const {
+  KrylovStats stats = { 0u, 0u, 0u };
+  return stats;
+}
+
 #if !defined(POGS_DOUBLE) || POGS_DOUBLE==1
 template class ProjectorDirect<double, MatrixDense<double> >;
 #endif
@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "gsl/gsl_spmat.h"
+#include "ldl.h"
+#include "matrix/matrix_sparse.h"
+#include "projector/projector_direct.h"
+#include "projector_helper.h"
+#include "timer.h"
+#include "util.h"
+
+namespace pogs {
+
+namespace {
+
+// Entries of the KKT matrix that are not taken from A.
+const POGS_INT kDiagX = -1;
+const POGS_INT kDiagY = -2;
+
+// The projection solves the quasi-definite KKT system
+//
+//   [sI  A'] [x]   [s x0]
+//   [A   -I] [z] = [y0  ],   y = y0 + z,
+//
+// with a sparse LDL' factorization. The upper triangle of the permuted KKT
+// matrix is stored in CSC format, with src mapping each entry to its value
+// in A (or to one of the diagonal blocks). The ordering and the symbolic
+// analysis are done once in Init, a new s only requires a numeric
+// factorization. Factors are cached per s as in the dense case.
+template<typename T>
+struct CpuData {
+  std::vector<POGS_INT> perm, ptr, ind, src;
+  ldl::Ldl<T, POGS_INT> *ldl;
+  std::list<std::pair<T, T*> > factors;
+  size_t max_factors;
+  std::atomic<unsigned int> hits, misses;
+  double factor_time;
+  CpuData()
+      : ldl(0), max_factors(1), hits(0), misses(0), factor_time(0.) { }
+  ~CpuData() {
+    delete ldl;
+    for (typename std::list<std::pair<T, T*> >::iterator it = factors.begin();
+        it != factors.end(); ++it)
+      delete [] it->second;
+  }
+};
+
+// Returns the factor (L followed by D) of the KKT matrix for s. On a miss
+// the factor is computed, replacing the least recently used one if the
+// cache is full. Returns 0 if a pivot is zero.
+template <typename T>
+const T* CachedFactor(CpuData<T> *info, const T *data, T s) {
+  typename std::list<std::pair<T, T*> >::iterator it = info->factors.begin();
+  while (it != info->factors.end() && it->first != s)
+    ++it;
+  if (it != info->factors.end()) {
+    ++info->hits;
+    if (it != info->factors.begin())
+      info->factors.splice(info->factors.begin(), info->factors, it);
+    return info->factors.front().second;
+  }
+
+  ++info->misses;
+  double t0 = timer<double>();
+  size_t nnz = info->src.size();
+  std::vector<T> val(nnz);
+  for (size_t l = 0; l < nnz; ++l) {
+    POGS_INT src = info->src[l];
+    val[l] = src == kDiagX ? s : (src == kDiagY ? static_cast<T>(-1.) :
+        data[src]);
+  }
+
+  T *LD;
+  if (info->factors.size() < info->max_factors) {
+    LD = new T[info->ldl->Nnz() + info->ldl->Size()];
+    ASSERT(LD != 0);
+  } else {
+    LD = info->factors.back().second;
+    info->factors.pop_back();
+  }
+  POGS_INT err = info->ldl->Factor(val.data(), LD, LD + info->ldl->Nnz());
+  info->factor_time += timer<double>() - t0;
+  if (err) {
+    delete [] LD;
+    return 0;
+  }
+  info->factors.push_front(std::make_pair(s, LD));
+  return LD;
+}
+
+// Solves the KKT system for one pair (x0, y0).
+template <typename T>
+void SolveKkt(const CpuData<T> *info, const T *LD, size_t m, size_t n,
+              const T *x0, const T *y0, T s, T *x, T *y, T *work) {
+  const POGS_INT *perm = info->perm.data();
+  for (size_t k = 0; k < m + n; ++k) {
+    POGS_INT i = perm[k];
+    work[k] = i < static_cast<POGS_INT>(n) ? s * x0[i] : y0[i - n];
+  }
+  info->ldl->Solve(LD, LD + info->ldl->Nnz(), work);
+  for (size_t k = 0; k < m + n; ++k) {
+    POGS_INT i = perm[k];
+    if (i < static_cast<POGS_INT>(n))
+      x[i] = work[k];
+    else
+      y[i - n] = y0[i - n] + work[k];
+  }
+}
+
+}  // namespace
+
+template <typename T, typename M>
+ProjectorDirect<T, M>::ProjectorDirect(const M& A)
+    : _A(A) {
+  // Set CPU specific this->_info.
+  CpuData<T> *info = new CpuData<T>();
+  this->_info = reinterpret_cast<void*>(info);
+}
+
+template <typename T, typename M>
+ProjectorDirect<T, M>::~ProjectorDirect() {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  delete info;
+  this->_info = 0;
+}
+
+template <typename T, typename M>
+int ProjectorDirect<T, M>::Init() {
+  if (this->_done_init)
+    return 1;
+  this->_done_init = true;
+  ASSERT(_A.IsInit());
+
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  POGS_INT m = static_cast<POGS_INT>(_A.Rows());
+  POGS_INT n = static_cast<POGS_INT>(_A.Cols());
+  POGS_INT nnz = _A.Nnz();
+  POGS_INT dim = m + n;
+
+  // A is stored in its own order, followed by its transpose if
+  // HasTranspose(). Locate the CSR and CSC arrays, building the missing
+  // orientation if needed, and the position of each CSR entry in Data().
+  bool row = _A.Order() == MatrixSparse<T>::ROW;
+  const POGS_INT *own_ptr = _A.Ptr(), *own_ind = _A.Ind();
+  const POGS_INT *tr_ptr, *tr_ind;
+  std::vector<POGS_INT> tr_ptr_tmp, tr_ind_tmp, tr_src;
+  if (_A.HasTranspose()) {
+    tr_ptr = own_ptr + (row ? m : n) + 1;
+    tr_ind = own_ind + nnz;
+  } else {
+    // Transposing the positions 0, ..., nnz - 1 gives the position in
+    // Data() of each entry of the transpose.
+    std::vector<POGS_INT> own_src(nnz);
+    for (POGS_INT l = 0; l < nnz; ++l)
+      own_src[l] = l;
+    tr_ptr_tmp.resize((row ? n : m) + 1);
+    tr_ind_tmp.resize(nnz);
+    tr_src.resize(nnz);
+    gsl::csr2csc(row ? m : n, row ? n : m, nnz, own_src.data(), own_ptr,
+        own_ind, tr_src.data(), tr_ind_tmp.data(), tr_ptr_tmp.data());
+    tr_ptr = tr_ptr_tmp.data();
+    tr_ind = tr_ind_tmp.data();
+  }
+  const POGS_INT *row_ptr = row ? own_ptr : tr_ptr;
+  const POGS_INT *col_ind = row ? own_ind : tr_ind;
+  const POGS_INT *col_ptr = row ? tr_ptr : own_ptr;
+  const POGS_INT *row_ind = row ? tr_ind : own_ind;
+
+  // Graph of the KKT matrix, x_j is node j and y_i is node n + i.
+  std::vector<POGS_INT> adj_ptr(dim + 1), adj_ind(2 * nnz);
+  for (POGS_INT j = 0; j <= n; ++j)
+    adj_ptr[j] = col_ptr[j];
+  for (POGS_INT i = 0; i <= m; ++i)
+    adj_ptr[n + i] = nnz + row_ptr[i];
+  for (POGS_INT l = 0; l < nnz; ++l) {
+    adj_ind[l] = n + row_ind[l];
+    adj_ind[nnz + l] = col_ind[l];
+  }
+  info->perm.resize(dim);
+  ldl::MinDegree(dim, adj_ptr.data(), adj_ind.data(), info->perm.data());
+  std::vector<POGS_INT> pinv(dim);
+  for (POGS_INT k = 0; k < dim; ++k)
+    pinv[info->perm[k]] = k;
+
+  // Upper triangle of the permuted KKT matrix. Entry (j, n + i) of the
+  // original matrix is a_ij, moved to (min, max) of (pinv[j], pinv[n + i]).
+  std::vector<POGS_INT> &ptr = info->ptr;
+  ptr.assign(dim + 1, 0);
+  for (POGS_INT k = 0; k < dim; ++k)
+    ++ptr[k + 1];
+  for (POGS_INT i = 0; i < m; ++i) {
+    for (POGS_INT l = row_ptr[i]; l < row_ptr[i + 1]; ++l)
+      ++ptr[std::max(pinv[col_ind[l]], pinv[n + i]) + 1];
+  }
+  for (POGS_INT k = 0; k < dim; ++k)
+    ptr[k + 1] += ptr[k];
+  info->ind.resize(ptr[dim]);
+  info->src.resize(ptr[dim]);
+  std::vector<POGS_INT> pos(ptr.begin(), ptr.end() - 1);
+  for (POGS_INT k = 0; k < dim; ++k) {
+    POGS_INT p = pos[pinv[k]]++;
+    info->ind[p] = pinv[k];
+    info->src[p] = k < n ? kDiagX : kDiagY;
+  }
+  for (POGS_INT i = 0; i < m; ++i) {
+    for (POGS_INT l = row_ptr[i]; l < row_ptr[i + 1]; ++l) {
+      POGS_INT r = pinv[col_ind[l]];
+      POGS_INT c = pinv[n + i];
+      POGS_INT p = pos[std::max(r, c)]++;
+      info->ind[p] = std::min(r, c);
+      info->src[p] = row ? l : (tr_src.empty() ? nnz + l : tr_src[l]);
+    }
+  }
+
+  info->ldl = new ldl::Ldl<T, POGS_INT>(dim, info->ptr.data(),
+      info->ind.data());
+
+  return 0;
+}
+
+template <typename T, typename M>
+void *ProjectorDirect<T, M>::NewWork() const {
+  return new std::vector<T>(_A.Rows() + _A.Cols());
+}
+
+template <typename T, typename M>
+void ProjectorDirect<T, M>::DeleteWork(void *work) const {
+  delete reinterpret_cast<std::vector<T>*>(work);
+}
+
+template <typename T, typename M>
+int ProjectorDirect<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
+                                   T tol, void *work) {
+  return ProjectBatch(1, x0, y0, 0, s, x, y, tol, &work);
+}
+
+template <typename T, typename M>
+int ProjectorDirect<T, M>::ProjectBatch(size_t k, const T *x0, const T *y0,
+                                        size_t ld, T s, T *x, T *y, T tol,
+                                        void *const *work) {
+  DEBUG_EXPECT(this->_done_init);
+  if (!this->_done_init || s < static_cast<T>(0.))
+    return 1;
+
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  size_t m = _A.Rows();
+  size_t n = _A.Cols();
+
+  // A zero pivot can only occur for s = 0.
+  const T *LD = CachedFactor(info, _A.Data(), s);
+  DEBUG_EXPECT(LD != 0);
+  if (LD == 0)
+    return 1;
+
+  // The whole batch is solved in the buffer of its first vector.
+  std::vector<T> tmp;
+  std::vector<T> *scratch = work && work[0] ?
+      reinterpret_cast<std::vector<T>*>(work[0]) : &tmp;
+  scratch->resize(m + n);
+  for (size_t i = 0; i < k; ++i) {
+    SolveKkt(info, LD, m, n, x0 + i * ld, y0 + i * ld, s, x + i * ld,
+        y + i * ld, scratch->data());
+
+#ifdef DEBUG
+    // Verify that projection was successful.
+    CheckProjection(&_A, x0 + i * ld, y0 + i * ld, x + i * ld, y + i * ld, s,
+        static_cast<T>(1e3) * std::numeric_limits<T>::epsilon());
+#endif
+  }
+
+  return 0;
+}
+
+template <typename T, typename M>
+void ProjectorDirect<T, M>::SetFactorCacheBytes(size_t bytes) {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  // Before Init the factor size is unknown, bound it by that of a dense L.
+  size_t dim = _A.Rows() + _A.Cols();
+  size_t factor_len = info->ldl ? info->ldl->Nnz() + info->ldl->Size() :
+      dim * (dim + 1) / 2;
+  size_t factor_bytes = std::max<size_t>(factor_len * sizeof(T), 1);
+  info->max_factors = std::max<size_t>(bytes / factor_bytes, 1);
+  while (info->factors.size() > info->max_factors) {
+    delete [] info->factors.back().second;
+    info->factors.pop_back();
+  }
+}
+
+template <typename T, typename M>
+FactorStats ProjectorDirect<T, M>::GetFactorStats() const {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  FactorStats stats;
+  stats.hits = info->hits;
+  stats.misses = info->misses;
+  stats.time = info->factor_time;
+  return stats;
+}
+
+template <typename T, typename M>
+KrylovStats ProjectorDirect<T, M>::GetKrylovStats() const {
+  KrylovStats stats = { 0u, 0u, 0u };
+  return stats;
+}
+
+#if !defined(POGS_DOUBLE) || POGS_DOUBLE==1
+template class ProjectorDirect<double, MatrixSparse<double> >;
+#endif
+
+#if !defined(POGS_SINGLE) || POGS_SINGLE==1
+template class ProjectorDirect<float, MatrixSparse<float> >;
+#endif
+
+}  // namespace pogs
+
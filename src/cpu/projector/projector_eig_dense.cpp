@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "gsl/cblas.h"
+#include "gsl/gsl_blas.h"
+#include "gsl/gsl_linalg.h"
+#include "gsl/gsl_matrix.h"
+#include "matrix/matrix_dense.h"
+#include "projector/projector_eig.h"
+#include "projector_helper.h"
+#include "timer.h"
+#include "util.h"
+
+namespace pogs {
+
+namespace {
+
+// Column major eigenvectors Q and eigenvalues lambda of AA. Both are only
+// read after Init, so concurrent projections are safe.
+template<typename T>
+struct CpuData {
+  T *Q, *lambda;
+  std::atomic<unsigned int> hits;
+  double factor_time;
+  CpuData() : Q(0), lambda(0), hits(0), factor_time(0.) { }
+};
+
+// t_i := t_i / (lambda_i + s) for each of the k columns of t.
+template <typename T>
+void ScaleInv(size_t n, size_t k, const T *lambda, T s, T *t) {
+  for (size_t j = 0; j < k; ++j)
+    for (size_t i = 0; i < n; ++i)
+      t[i + j * n] /= lambda[i] + s;
+}
+
+}  // namespace
+
+template <typename T, typename M>
+ProjectorEig<T, M>::ProjectorEig(const M& A)
+    : _A(A) {
+  // Set CPU specific this->_info.
+  CpuData<T> *info = new CpuData<T>();
+  this->_info = reinterpret_cast<void*>(info);
+}
+
+template <typename T, typename M>
+ProjectorEig<T, M>::~ProjectorEig() {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  if (info->Q) {
+    delete [] info->Q;
+    info->Q = 0;
+  }
+
+  if (info->lambda) {
+    delete [] info->lambda;
+    info->lambda = 0;
+  }
+
+  delete info;
+  this->_info = 0;
+}
+
+template <typename T, typename M>
+int ProjectorEig<T, M>::Init() {
+  if (this->_done_init)
+    return 1;
+  this->_done_init = true;
+  ASSERT(_A.IsInit());
+
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  size_t min_dim = std::min(_A.Rows(), _A.Cols());
+
+  info->Q = new T[min_dim * min_dim];
+  ASSERT(info->Q != 0);
+  info->lambda = new T[min_dim];
+  ASSERT(info->lambda != 0);
+
+  std::vector<T> AA_data(min_dim * min_dim);
+  gsl::matrix<T, CblasColMajor> Q = gsl::matrix_view_array<T, CblasColMajor>
+      (info->Q, min_dim, min_dim);
+  gsl::vector<T> lambda = gsl::vector_view_array(info->lambda, min_dim);
+
+  CBLAS_TRANSPOSE_t op_type = _A.Rows() > _A.Cols() ? CblasTrans : CblasNoTrans;
+
+  // Compute AA and its eigendecomposition.
+  double t0;
+  if (_A.Order() == MatrixDense<T>::ROW) {
+    const gsl::matrix<T, CblasRowMajor> A =
+        gsl::matrix_view_array<T, CblasRowMajor>
+        (_A.Data(), _A.Rows(), _A.Cols());
+    gsl::matrix<T, CblasRowMajor> AA = gsl::matrix_view_array<T, CblasRowMajor>
+        (AA_data.data(), min_dim, min_dim);
+    gsl::blas_syrk(CblasLower, op_type,
+        static_cast<T>(1.), &A, static_cast<T>(0.), &AA);
+    t0 = timer<double>();
+    gsl::linalg_eigen_symmv(&AA, &lambda, &Q);
+  } else {
+    const gsl::matrix<T, CblasColMajor> A =
+        gsl::matrix_view_array<T, CblasColMajor>
+        (_A.Data(), _A.Rows(), _A.Cols());
+    gsl::matrix<T, CblasColMajor> AA = gsl::matrix_view_array<T, CblasColMajor>
+        (AA_data.data(), min_dim, min_dim);
+    gsl::blas_syrk(CblasLower, op_type,
+        static_cast<T>(1.), &A, static_cast<T>(0.), &AA);
+    t0 = timer<double>();
+    gsl::linalg_eigen_symmv(&AA, &lambda, &Q);
+  }
+  info->factor_time = timer<double>() - t0;
+
+  return 0;
+}
+
+template <typename T, typename M>
+void *ProjectorEig<T, M>::NewWork() const {
+  return new std::vector<T>(std::min(_A.Rows(), _A.Cols()));
+}
+
+template <typename T, typename M>
+void ProjectorEig<T, M>::DeleteWork(void *work) const {
+  delete reinterpret_cast<std::vector<T>*>(work);
+}
+
+template <typename T, typename M>
+int ProjectorEig<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
+                                T tol, void *work) {
+  DEBUG_EXPECT(this->_done_init);
+  if (!this->_done_init || s < static_cast<T>(0.))
+    return 1;
+
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  ++info->hits;
+
+  size_t m = _A.Rows();
+  size_t n = _A.Cols();
+  size_t min_dim = std::min(m, n);
+  bool row = _A.Order() == MatrixDense<T>::ROW;
+
+  // Set up views for raw vectors.
+  gsl::vector<T> y_vec = gsl::vector_view_array(y, m);
+  const gsl::vector<T> y0_vec = gsl::vector_view_array(y0, m);
+  gsl::vector<T> x_vec = gsl::vector_view_array(x, n);
+  const gsl::vector<T> x0_vec = gsl::vector_view_array(x0, n);
+
+  std::vector<T> tmp;
+  std::vector<T> &t_data = work ? *reinterpret_cast<std::vector<T>*>(work) :
+      tmp;
+  t_data.resize(min_dim);
+  gsl::vector<T> t_vec = gsl::vector_view_array(t_data.data(), min_dim);
+
+  // Set (x, y) = (x0, y0).
+  gsl::vector_memcpy(&x_vec, &x0_vec);
+  gsl::vector_memcpy(&y_vec, &y0_vec);
+
+  // Row major A is viewed as column major A^T, see ProjectBatch.
+  const gsl::matrix<T, CblasColMajor> A = row ?
+      gsl::matrix_view_array<T, CblasColMajor>(_A.Data(), n, m) :
+      gsl::matrix_view_array<T, CblasColMajor>(_A.Data(), m, n);
+  const gsl::matrix<T, CblasColMajor> Q =
+      gsl::matrix_view_array<T, CblasColMajor>(info->Q, min_dim, min_dim);
+  CBLAS_TRANSPOSE_t op_n = row ? CblasTrans : CblasNoTrans;
+  CBLAS_TRANSPOSE_t op_t = row ? CblasNoTrans : CblasTrans;
+
+  // v := Q diag(1 / (lambda + s)) Q^T v, where v = x or y.
+  gsl::vector<T> *v_vec = m > n ? &x_vec : &y_vec;
+  if (m > n)
+    gsl::blas_gemv(op_t, static_cast<T>(1.), &A, &y_vec, static_cast<T>(1.),
+        &x_vec);
+  else
+    gsl::blas_gemv(op_n, static_cast<T>(1.), &A, &x_vec, static_cast<T>(-1.),
+        &y_vec);
+  gsl::blas_gemv(CblasTrans, static_cast<T>(1.), &Q, v_vec,
+      static_cast<T>(0.), &t_vec);
+  ScaleInv(min_dim, 1, info->lambda, s, t_data.data());
+  gsl::blas_gemv(CblasNoTrans, static_cast<T>(1.), &Q, &t_vec,
+      static_cast<T>(0.), v_vec);
+  if (m > n) {
+    gsl::blas_gemv(op_n, static_cast<T>(1.), &A, &x_vec, static_cast<T>(0.),
+        &y_vec);
+  } else {
+    gsl::blas_gemv(op_t, static_cast<T>(-1.), &A, &y_vec, static_cast<T>(1.),
+        &x_vec);
+    gsl::blas_axpy(static_cast<T>(1.), &y0_vec, &y_vec);
+  }
+
+#ifdef DEBUG
+  // Verify that projection was successful.
+  CheckProjection(&_A, x0, y0, x, y, s,
+      static_cast<T>(1e3) * std::numeric_limits<T>::epsilon());
+#endif
+
+  return 0;
+}
+
+template <typename T, typename M>
+int ProjectorEig<T, M>::ProjectBatch(size_t k, const T *x0, const T *y0,
+                                     size_t ld, T s, T *x, T *y, T tol,
+                                     void *const *work) {
+  DEBUG_EXPECT(this->_done_init);
+  if (!this->_done_init || s < static_cast<T>(0.))
+    return 1;
+
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  info->hits += static_cast<unsigned int>(k);
+
+  size_t m = _A.Rows();
+  size_t n = _A.Cols();
+  size_t min_dim = std::min(m, n);
+  bool row = _A.Order() == MatrixDense<T>::ROW;
+
+  // Set (x, y) = (x0, y0).
+  for (size_t i = 0; i < k; ++i) {
+    memcpy(x + i * ld, x0 + i * ld, n * sizeof(T));
+    memcpy(y + i * ld, y0 + i * ld, m * sizeof(T));
+  }
+
+  const gsl::matrix<T, CblasColMajor> A = row ?
+      gsl::matrix_view_array<T, CblasColMajor>(_A.Data(), n, m) :
+      gsl::matrix_view_array<T, CblasColMajor>(_A.Data(), m, n);
+  const gsl::matrix<T, CblasColMajor> Q =
+      gsl::matrix_view_array<T, CblasColMajor>(info->Q, min_dim, min_dim);
+  CBLAS_TRANSPOSE_t op_n = row ? CblasTrans : CblasNoTrans;
+  CBLAS_TRANSPOSE_t op_t = row ? CblasNoTrans : CblasTrans;
+
+  gsl::matrix<T, CblasColMajor> x_mat =
+      gsl::matrix_view_array<T, CblasColMajor>(x, n, k, ld);
+  gsl::matrix<T, CblasColMajor> y_mat =
+      gsl::matrix_view_array<T, CblasColMajor>(y, m, k, ld);
+  // Q^T v for the whole batch, in the work of the first vector. It only
+  // grows when the batch is larger than any before.
+  std::vector<T> tmp;
+  std::vector<T> &t_data = work && work[0] ?
+      *reinterpret_cast<std::vector<T>*>(work[0]) : tmp;
+  if (t_data.size() < min_dim * k)
+    t_data.resize(min_dim * k);
+  gsl::matrix<T, CblasColMajor> t_mat =
+      gsl::matrix_view_array<T, CblasColMajor>(t_data.data(), min_dim, k);
+
+  gsl::matrix<T, CblasColMajor> *v_mat = m > n ? &x_mat : &y_mat;
+  if (m > n)
+    gsl::blas_gemm(op_t, CblasNoTrans, static_cast<T>(1.), &A, &y_mat,
+        static_cast<T>(1.), &x_mat);
+  else
+    gsl::blas_gemm(op_n, CblasNoTrans, static_cast<T>(1.), &A, &x_mat,
+        static_cast<T>(-1.), &y_mat);
+  gsl::blas_gemm(CblasTrans, CblasNoTrans, static_cast<T>(1.), &Q, v_mat,
+      static_cast<T>(0.), &t_mat);
+  ScaleInv(min_dim, k, info->lambda, s, t_data.data());
+  gsl::blas_gemm(CblasNoTrans, CblasNoTrans, static_cast<T>(1.), &Q, &t_mat,
+      static_cast<T>(0.), v_mat);
+  if (m > n) {
+    gsl::blas_gemm(op_n, CblasNoTrans, static_cast<T>(1.), &A, &x_mat,
+        static_cast<T>(0.), &y_mat);
+  } else {
+    gsl::blas_gemm(op_t, CblasNoTrans, static_cast<T>(-1.), &A, &y_mat,
+        static_cast<T>(1.), &x_mat);
+    for (size_t i = 0; i < k; ++i) {
+      gsl::vector<T> y_i = gsl::matrix_column(&y_mat, i);
+      const gsl::vector<T> y0_i = gsl::vector_view_array(y0 + i * ld, m);
+      gsl::blas_axpy(static_cast<T>(1.), &y0_i, &y_i);
+    }
+  }
+
+  return 0;
+}
+
+template <typename T, typename M>
+FactorStats ProjectorEig<T, M>::GetFactorStats() const {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+
+  FactorStats stats;
+  stats.hits = info->hits;
+  stats.misses = this->_done_init ? 1 : 0;
+  stats.time = info->factor_time;
+  return stats;
+}
+
+template <typename T, typename M>
+KrylovStats ProjectorEig<T, M>::GetKrylovStats() const {
+  KrylovStats stats = { 0u, 0u, 0u };
+  return stats;
+}
+
+#if !defined(POGS_DOUBLE) || POGS_DOUBLE==1
+template class ProjectorEig<double, MatrixDense<double> >;
+#endif
+
+#if !defined(POGS_SINGLE) || POGS_SINGLE==1
+template class ProjectorEig<float, MatrixDense<float> >;
+#endif
+
+}  // namespace pogs
+
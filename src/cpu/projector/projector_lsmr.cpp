@@ -0,0 +1,154 @@
+#include "lsmr.h"
+#include "matrix/matrix_dense.h"
+#include "matrix/matrix_sparse.h"
+#include "projector/projector_lsmr.h"
+#include "projector_helper.h"
+#include "util.h"
+
+namespace pogs {
+
+namespace {
+
+int kMaxIter = 100;
+bool kLsmrQuiet = true;
+
+// State of one session: warm start and LSMR workspace.
+template <typename T>
+struct Work {
+  KrylovWarmStart<T> warm;
+  lsmr::Workspace<T> lsmr;
+};
+
+template <typename T>
+struct CpuData {
+  bool warm_start;
+  KrylovCounters counters;
+  CpuData() : warm_start(true) { }
+};
+
+template <typename T, typename M>
+int ProjectOne(const M& A, CpuData<T> *info, bool warm_start, const T *x0,
+               const T *y0, T s, T *x, T *y, T tol, Work<T> *work) {
+  unsigned int matvecs = 0;
+  double norms_ref = KrylovBegin(A, warm_start, x0, y0, x, y,
+      &work->warm, &matvecs);
+
+  // Minimize ||Ax - b||_2^2 + s||x||_2^2
+  int iter = 0;
+  lsmr::Solve(CountingGemv<T, M>(A, &matvecs),
+      static_cast<cgls::INT>(A.Rows()), static_cast<cgls::INT>(A.Cols()), y,
+      x, s, tol, kMaxIter, kLsmrQuiet, norms_ref, &iter, &work->lsmr);
+
+  KrylovEnd(A, warm_start, x0, x, y, &work->warm, iter, matvecs,
+      &info->counters);
+
+  return 0;
+}
+
+}  // namespace
+
+template <typename T, typename M>
+ProjectorLsmr<T, M>::ProjectorLsmr(const M& A)
+    : _A(A) {
+  // Set CPU specific this->_info.
+  CpuData<T> *info = new CpuData<T>();
+  this->_info = reinterpret_cast<void*>(info);
+}
+
+template <typename T, typename M>
+ProjectorLsmr<T, M>::~ProjectorLsmr() {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  delete info;
+  this->_info = 0;
+}
+
+template <typename T, typename M>
+int ProjectorLsmr<T, M>::Init() {
+  if (this->_done_init)
+    return 1;
+  this->_done_init = true;
+
+  ASSERT(_A.IsInit());
+
+  return 0;
+}
+
+template <typename T, typename M>
+void *ProjectorLsmr<T, M>::NewWork() const {
+  return new Work<T>();
+}
+
+template <typename T, typename M>
+void ProjectorLsmr<T, M>::DeleteWork(void *work) const {
+  delete reinterpret_cast<Work<T>*>(work);
+}
+
+template <typename T, typename M>
+int ProjectorLsmr<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
+                                 T tol, void *work) {
+  DEBUG_EXPECT(this->_done_init);
+  DEBUG_EXPECT(s >= static_cast<T>(0.));
+  if (!this->_done_init || s < static_cast<T>(0.))
+    return 1;
+
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  Work<T> tmp;
+  ProjectOne(_A, info, info->warm_start && work, x0, y0, s, x, y, tol,
+      work ? reinterpret_cast<Work<T>*>(work) : &tmp);
+
+#ifdef DEBUG
+  // Verify that projection was successful.
+  CheckProjection(&_A, x0, y0, x, y, s, static_cast<T>(1e1 * kTol));
+#endif
+
+  return 0;
+}
+
+template <typename T, typename M>
+int ProjectorLsmr<T, M>::ProjectBatch(size_t k, const T *x0, const T *y0,
+                                      size_t ld, T s, T *x, T *y, T tol,
+                                      void *const *work) {
+  DEBUG_EXPECT(this->_done_init);
+  DEBUG_EXPECT(s >= static_cast<T>(0.));
+  if (!this->_done_init || s < static_cast<T>(0.))
+    return 1;
+
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  Work<T> tmp;
+  for (size_t i = 0; i < k; ++i)
+    ProjectOne(_A, info, info->warm_start && work, x0 + i * ld, y0 + i * ld,
+        s, x + i * ld, y + i * ld, tol,
+        work ? reinterpret_cast<Work<T>*>(work[i]) : &tmp);
+  return 0;
+}
+
+template <typename T, typename M>
+void ProjectorLsmr<T, M>::SetWarmStart(bool warm_start) {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  info->warm_start = warm_start;
+}
+
+template <typename T, typename M>
+FactorStats ProjectorLsmr<T, M>::GetFactorStats() const {
+  FactorStats stats = { 0u, 0u, 0. };
+  return stats;
+}
+
+template <typename T, typename M>
+KrylovStats ProjectorLsmr<T, M>::GetKrylovStats() const {
+  CpuData<T> *info = reinterpret_cast<CpuData<T>*>(this->_info);
+  return info->counters.Get();
+}
+
+#if !defined(POGS_DOUBLE) || POGS_DOUBLE==1
+template class ProjectorLsmr<double, MatrixDense<double> >;
+template class ProjectorLsmr<double, MatrixSparse<double> >;
+#endif
+
+#if !defined(POGS_SINGLE) || POGS_SINGLE==1
+template class ProjectorLsmr<float, MatrixDense<float> >;
+template class ProjectorLsmr<float, MatrixSparse<float> >;
+#endif
+
+}  // namespace pogs
+
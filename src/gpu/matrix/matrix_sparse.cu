@@ -61,14 +61,22 @@ T NormEst(cublasHandle_t hdl, NormTypes norm_type, const MatrixSparse<T>& A);
 ////////////////////////////////////////////////////////////////////////////////
 /////////////////////// MatrixDense Implementation /////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
-template <typename T>
-MatrixSparse<T>::MatrixSparse(char ord, POGS_INT m, POGS_INT n, POGS_INT nnz,
-                              const T *data, const POGS_INT *ptr,
-                              const POGS_INT *ind)
-    : Matrix<T>(m, n), _data(0), _ptr(0), _ind(0), _nnz(nnz) {
+template <typename T, typename I>
+MatrixSparse<T, I>::MatrixSparse(char ord, I m, I n, I nnz, const T *data,
+                                 const I *ptr, const I *ind,
+                                 bool store_transpose, bool use_sell,
+                                 bool reorder)
+    : Matrix<T>(m, n), _data(0), _ptr(0), _ind(0), _nnz(nnz),
+      _transpose(true) {
   ASSERT(ord == 'r' || ord == 'R' || ord == 'c' || ord == 'C');
   _ord = (ord == 'r' || ord == 'R') ? ROW : COL;
 
+  // cuSPARSE needs both orientations, the transpose is always stored, and
+  // the matrix is always in CSR format.
+  DEBUG_EXPECT(store_transpose);
+  DEBUG_EXPECT(!use_sell);
+  DEBUG_EXPECT(!reorder);
+
   // It should work up to 2^31 == 2B, but let's be sure.
   DEBUG_EXPECT(nnz < static_cast<POGS_INT>(1 << 29));
 
@@ -77,10 +85,10 @@ MatrixSparse<T>::MatrixSparse(char ord, POGS_INT m, POGS_INT n, POGS_INT nnz,
   this->_info = reinterpret_cast<void*>(info);
 }
 
-template <typename T>
-MatrixSparse<T>::MatrixSparse(const MatrixSparse<T>& A)
+template <typename T, typename I>
+MatrixSparse<T, I>::MatrixSparse(const MatrixSparse<T, I>& A)
     : Matrix<T>(A._m, A._n), _data(0), _ptr(0), _ind(0), _nnz(A._nnz), 
-      _ord(A._ord) {
+      _ord(A._ord), _transpose(A._transpose) {
 
   GpuData<T> *info_A = reinterpret_cast<GpuData<T>*>(A._info);
   GpuData<T> *info = new GpuData<T>(info_A->orig_data, info_A->orig_ptr,
@@ -88,8 +96,8 @@ MatrixSparse<T>::MatrixSparse(const MatrixSparse<T>& A)
   this->_info = reinterpret_cast<void*>(info);
 }
 
-template <typename T>
-MatrixSparse<T>::~MatrixSparse() {
+template <typename T, typename I>
+MatrixSparse<T, I>::~MatrixSparse() {
   GpuData<T> *info = reinterpret_cast<GpuData<T>*>(this->_info);
   delete info;
   this->_info = 0;
@@ -115,8 +123,8 @@ MatrixSparse<T>::~MatrixSparse() {
   }
 }
 
-template <typename T>
-int MatrixSparse<T>::Init() {
+template <typename T, typename I>
+int MatrixSparse<T, I>::Init() {
   DEBUG_ASSERT(!this->_done_init);
   if (this->_done_init)
     return 1;
@@ -147,8 +155,18 @@ int MatrixSparse<T>::Init() {
   return 0;
 }
 
-template <typename T>
-int MatrixSparse<T>::Mul(char trans, T alpha, const T *x, T beta, T *y) const {
+template <typename T, typename I>
+const size_t *MatrixSparse<T, I>::RowPerm() const {
+  return 0;
+}
+
+template <typename T, typename I>
+const size_t *MatrixSparse<T, I>::ColPerm() const {
+  return 0;
+}
+
+template <typename T, typename I>
+int MatrixSparse<T, I>::Mul(char trans, T alpha, const T *x, T beta, T *y) const {
   DEBUG_ASSERT(this->_done_init);
   if (!this->_done_init)
     return 1;
@@ -180,8 +198,8 @@ int MatrixSparse<T>::Mul(char trans, T alpha, const T *x, T beta, T *y) const {
   return 0;
 }
 
-template <typename T>
-int MatrixSparse<T>::Equil(T *d, T *e) {
+template <typename T, typename I>
+int MatrixSparse<T, I>::Equil(T *d, T *e) {
   DEBUG_ASSERT(this->_done_init);
   if (!this->_done_init)
     return 1;
@@ -368,6 +386,7 @@ void MultDiag(const T *d, const T *e, POGS_INT m, POGS_INT n, POGS_INT nnz,
 
 }  // namespace
 
+// cuSPARSE takes 32-bit indices, POGS_INT64 is CPU only.
 #if !defined(POGS_DOUBLE) || POGS_DOUBLE==1
 template class MatrixSparse<double>;
 #endif
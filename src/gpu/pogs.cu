@@ -40,22 +40,67 @@ struct ApplyOp: thrust::binary_function<FunctionObj<T>, FunctionObj<T>, T> {
 
 }  // namespace
 
+template <typename T, typename M, typename P>
+PogsPrepared<T, M, P>::PogsPrepared(const M &A)
+    : _A(A), _P(_A), _de(0), _done_init(false) { }
+
+template <typename T, typename M, typename P>
+int PogsPrepared<T, M, P>::Init() {
+  DEBUG_EXPECT(!_done_init);
+  if (_done_init)
+    return 1;
+  _done_init = true;
+
+  size_t m = _A.Rows();
+  size_t n = _A.Cols();
+
+  cudaMalloc(&_de, (m + n) * sizeof(T));
+  cudaMemset(_de, 0, (m + n) * sizeof(T));
+  CUDA_CHECK_ERR();
+
+  _A.Init();
+  _A.Equil(_de, _de + m);
+  _P.Init();
+  CUDA_CHECK_ERR();
+
+  return 0;
+}
+
+template <typename T, typename M, typename P>
+PogsPrepared<T, M, P>::~PogsPrepared() {
+  cudaFree(_de);
+  _de = 0;
+  CUDA_CHECK_ERR();
+}
+
 template <typename T, typename M, typename P>
 Pogs<T, M, P>::Pogs(const M &A)
-    : _A(A), _P(_A),
+    : Pogs(std::make_shared<PogsPrepared<T, M, P> >(A)) { }
+
+template <typename T, typename M, typename P>
+Pogs<T, M, P>::Pogs(const std::shared_ptr<PogsPrepared<T, M, P> > &prep)
+    : _prep(prep), _A(prep->_A), _P(prep->_P),
       _de(0), _z(0), _zt(0),
       _rho(static_cast<T>(kRhoInit)),
       _done_init(false),
+      _zprev(0), _ztemp(0), _z12(0), _num_alloc(0), _anderson(0),
+      _proj_work(0),
       _x(0), _y(0), _mu(0), _lambda(0), _optval(static_cast<T>(0.)),
-      _final_iter(0),
+      _final_iter(0), _final_matvec_saved(0),
+      _final_aa_accepted(0), _final_aa_rejected(0), _final_krylov_iter(0),
+      _final_prox_stats(),
       _abs_tol(static_cast<T>(kAbsTol)),
       _rel_tol(static_cast<T>(kRelTol)),
       _max_iter(kMaxIter),
       _init_iter(kInitIter),
       _verbose(kVerbose),
+      _exact_freq(kExactFreq),
+      _anderson_mem(kAndersonMem),
       _adaptive_rho(kAdaptiveRho),
       _gap_stop(kGapStop),
-      _init_x(false), _init_lambda(false) {
+      _init_x(false), _init_lambda(false),
+      _prox_warm_start(kProxWarmStart),
+      _prox_accuracy(kProxAccuracy) {
   _x = new T[_A.Cols()]();
   _y = new T[_A.Rows()]();
   _mu = new T[_A.Cols()]();
@@ -72,19 +117,30 @@ int Pogs<T, M, P>::_Init() {
   size_t m = _A.Rows();
   size_t n = _A.Cols();
 
-  cudaMalloc(&_de, (m + n) * sizeof(T));
   cudaMalloc(&_z, (m + n) * sizeof(T));
   cudaMalloc(&_zt, (m + n) * sizeof(T));
-  cudaMemset(_de, 0, (m + n) * sizeof(T));
   cudaMemset(_z, 0, (m + n) * sizeof(T));
   cudaMemset(_zt, 0, (m + n) * sizeof(T));
   CUDA_CHECK_ERR();
 
-  _A.Init();
-  _A.Equil(_de, _de + m);
-  _P.Init();
+  // Allocate workspace used by Solve.
+  cudaMalloc(&_zprev, (m + n) * sizeof(T));
+  cudaMalloc(&_ztemp, (m + n) * sizeof(T));
+  cudaMalloc(&_z12, (m + n) * sizeof(T));
+  cudaMemset(_zprev, 0, (m + n) * sizeof(T));
+  cudaMemset(_ztemp, 0, (m + n) * sizeof(T));
+  cudaMemset(_z12, 0, (m + n) * sizeof(T));
+  _num_alloc += 5;
   CUDA_CHECK_ERR();
 
+  if (!_prep->IsInit())
+    _prep->Init();
+  _de = _prep->_de;
+
+  _proj_work = _P.NewWork();
+  if (_proj_work != 0)
+    ++_num_alloc;
+
   return 0;
 }
 
@@ -106,7 +162,6 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   const T kProjTolMin = static_cast<T>(1e-2);
   const T kProjTolPow = static_cast<T>(1.3);
   const T kProjTolIni = static_cast<T>(1e-5);
-  bool use_exact_stop = true;
 
   // Initialize Projector P and Matrix A.
   if (!_done_init)
@@ -123,13 +178,13 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   cublasCreate(&hdl);
   CUDA_CHECK_ERR();
 
-  // Allocate data for ADMM variables.
+  // Create views for ADMM variables.
   cml::vector<T> de    = cml::vector_view_array(_de, m + n);
   cml::vector<T> z     = cml::vector_view_array(_z, m + n);
   cml::vector<T> zt    = cml::vector_view_array(_zt, m + n);
-  cml::vector<T> zprev = cml::vector_calloc<T>(m + n);
-  cml::vector<T> ztemp = cml::vector_calloc<T>(m + n);
-  cml::vector<T> z12   = cml::vector_calloc<T>(m + n);
+  cml::vector<T> zprev = cml::vector_view_array(_zprev, m + n);
+  cml::vector<T> ztemp = cml::vector_view_array(_ztemp, m + n);
+  cml::vector<T> z12   = cml::vector_view_array(_z12, m + n);
   CUDA_CHECK_ERR();
 
   // Create views for x and y components.
@@ -183,7 +238,7 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
       ProjSubgradEval(g_gpu, xprev.data, x.data, xtemp.data);
       ProjSubgradEval(f_gpu, yprev.data, y.data, ytemp.data);
       _P.Project(xtemp.data, ytemp.data, kOne, xprev.data, yprev.data,
-          kProjTolIni);
+          kProjTolIni, _proj_work);
       cudaDeviceSynchronize();
       CUDA_CHECK_ERR();
       cml::blas_axpy(hdl, -kOne, &ztemp, &zprev);
@@ -218,7 +273,7 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   T sqrtm_atol = std::sqrt(static_cast<T>(m)) * _abs_tol;
   T sqrtmn_atol = std::sqrt(static_cast<T>(m + n)) * _abs_tol;
   T delta = kDeltaMin, xi = static_cast<T>(1.0);
-  unsigned int k = 0u, kd = 0u, ku = 0u;
+  unsigned int k = 0u, kd = 0u, ku = 0u, matvec_saved = 0u;
   bool converged = false;
   T nrm_r, nrm_s, gap, eps_gap, eps_pri, eps_dua;
 
@@ -250,7 +305,8 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
     // Project onto y = Ax.
     T proj_tol = kProjTolMin / std::pow(static_cast<T>(k + 1), kProjTolPow);
     proj_tol = std::max(proj_tol, kProjTolMax);
-    _P.Project(xtemp.data, ytemp.data, kOne, x.data, y.data, proj_tol);
+    _P.Project(xtemp.data, ytemp.data, kOne, x.data, y.data, proj_tol,
+        _proj_work);
     cudaDeviceSynchronize();
     CUDA_CHECK_ERR();
 
@@ -267,6 +323,7 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
 
     // Calculate exact residuals only if necessary.
     bool exact = false;
+    bool use_exact_stop = _exact_freq > 0 && k % _exact_freq == 0;
     if ((nrm_r < eps_pri && nrm_s < eps_dua) || use_exact_stop) {
       cml::vector_memcpy(&ztemp, &z12);
       _A.Mul('n', kOne, x12.data, -kOne, ytemp.data);
@@ -280,7 +337,11 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
         cudaDeviceSynchronize();
         nrm_s = _rho * cml::blas_nrm2(hdl, &xtemp);
         exact = true;
+      } else {
+        ++matvec_saved;
       }
+    } else {
+      matvec_saved += 2;
     }
     CUDA_CHECK_ERR();
 
@@ -298,6 +359,7 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
     // Break if converged or there are nans
     if (converged || k == _max_iter - 1){ // || cml::vector_any_isnan(&zt))
       _final_iter = k;
+      _final_matvec_saved = matvec_saved;
       break;
     }
 
@@ -355,8 +417,10 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
     Printf(__HBAR__
         "Status: %s\n" 
         "Timing: Total = %3.2e s, Init = %3.2e s\n"
-        "Iter  : %u\n",
-        PogsStatusString(status).c_str(), timer<double>() - t0, time_init, k);
+        "Iter  : %u\n"
+        "Matvec: %u saved on residuals\n",
+        PogsStatusString(status).c_str(), timer<double>() - t0, time_init, k,
+        matvec_saved);
     Printf(__HBAR__
         "Error Metrics:\n"
         "Pri: "
@@ -390,23 +454,51 @@ PogsStatus Pogs<T, M, P>::Solve(const std::vector<FunctionObj<T> > &f,
   cml::vector_memcpy(&z, &zprev);
 
   // Free memory.
-  cml::vector_free(&z12);
-  cml::vector_free(&zprev);
-  cml::vector_free(&ztemp);
   cublasDestroy(hdl);
   CUDA_CHECK_ERR();
 
   return status;
 }
 
+// The GPU kernels take one function object per element, so f and g are
+// expanded.
+template <typename T, typename M, typename P>
+PogsStatus Pogs<T, M, P>::Solve(const FunctionVector<T> &f,
+                                const FunctionVector<T> &g) {
+  DEBUG_EXPECT(f.IsValid() && g.IsValid());
+  if (!f.IsValid() || !g.IsValid())
+    return POGS_ERROR;
+  std::vector<FunctionObj<T> > f_obj(f.size()), g_obj(g.size());
+  for (size_t i = 0; i < f.size(); ++i)
+    f_obj[i] = f[i];
+  for (size_t j = 0; j < g.size(); ++j)
+    g_obj[j] = g[j];
+  return Solve(f_obj, g_obj);
+}
+
+// The GPU kernels are not specialized, so f_ops and g_ops are not used.
+template <typename T, typename M, typename P>
+PogsStatus Pogs<T, M, P>::_SolveOps(const FunctionVector<T> &f,
+                                    const FunctionVector<T> &g,
+                                    const FunctionOps<T> &f_ops,
+                                    const FunctionOps<T> &g_ops) {
+  return Solve(f, g);
+}
+
 template <typename T, typename M, typename P>
 Pogs<T, M, P>::~Pogs() {
-  cudaFree(_de);
   cudaFree(_z);
   cudaFree(_zt);
   _de = _z = _zt = 0;
+  cudaFree(_zprev);
+  cudaFree(_ztemp);
+  cudaFree(_z12);
+  _zprev = _ztemp = _z12 = 0;
   CUDA_CHECK_ERR();
 
+  _P.DeleteWork(_proj_work);
+  _proj_work = 0;
+
   delete [] _x;
   delete [] _y;
   delete [] _mu;
@@ -422,6 +514,12 @@ template class Pogs<double, MatrixDense<double>,
     ProjectorCgls<double, MatrixDense<double> > >;
 template class Pogs<double, MatrixSparse<double>,
     ProjectorCgls<double, MatrixSparse<double> > >;
+template class PogsPrepared<double, MatrixDense<double>,
+    ProjectorDirect<double, MatrixDense<double> > >;
+template class PogsPrepared<double, MatrixDense<double>,
+    ProjectorCgls<double, MatrixDense<double> > >;
+template class PogsPrepared<double, MatrixSparse<double>,
+    ProjectorCgls<double, MatrixSparse<double> > >;
 #endif
 
 #if !defined(POGS_SINGLE) || POGS_SINGLE==1
@@ -431,6 +529,12 @@ template class Pogs<float, MatrixDense<float>,
     ProjectorCgls<float, MatrixDense<float> > >;
 template class Pogs<float, MatrixSparse<float>,
     ProjectorCgls<float, MatrixSparse<float> > >;
+template class PogsPrepared<float, MatrixDense<float>,
+    ProjectorDirect<float, MatrixDense<float> > >;
+template class PogsPrepared<float, MatrixDense<float>,
+    ProjectorCgls<float, MatrixDense<float> > >;
+template class PogsPrepared<float, MatrixSparse<float>,
+    ProjectorCgls<float, MatrixSparse<float> > >;
 #endif
 
 }  // namespace pogs
@@ -46,8 +46,9 @@ struct Gemv : cgls::Gemv<T> {
 }  // namespace
 
 template <typename T, typename M>
-ProjectorCgls<T, M>::ProjectorCgls(const M& A)
+ProjectorCgls<T, M>::ProjectorCgls(const M& A, CglsPrecond precond)
     : _A(A) {
+  // Preconditioning is not implemented on the GPU.
   // Set GPU specific this->_info.
   GpuData<T> *info = new GpuData<T>();
   this->_info = reinterpret_cast<void*>(info);
@@ -71,9 +72,18 @@ int ProjectorCgls<T, M>::Init() {
   return 0;
 }
 
+// Nothing is kept between projections on the GPU.
+template <typename T, typename M>
+void *ProjectorCgls<T, M>::NewWork() const {
+  return 0;
+}
+
+template <typename T, typename M>
+void ProjectorCgls<T, M>::DeleteWork(void *work) const { }
+
 template <typename T, typename M>
 int ProjectorCgls<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
-                                 T tol) {
+                                 T tol, void *work) {
   DEBUG_EXPECT(this->_done_init);
   DEBUG_EXPECT(s >= static_cast<T>(0.));
   if (!this->_done_init || s < static_cast<T>(0.))
@@ -113,6 +123,19 @@ int ProjectorCgls<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
   return 0;
 }
 
+template <typename T, typename M>
+FactorStats ProjectorCgls<T, M>::GetFactorStats() const {
+  FactorStats stats = { 0u, 0u, 0. };
+  return stats;
+}
+
+template <typename T, typename M>
+KrylovStats ProjectorCgls<T, M>::GetKrylovStats() const {
+  // Not tracked on the GPU.
+  KrylovStats stats = { 0u, 0u, 0u };
+  return stats;
+}
+
 #if !defined(POGS_DOUBLE) || POGS_DOUBLE==1
 template class ProjectorCgls<double, MatrixDense<double> >;
 template class ProjectorCgls<double, MatrixSparse<double> >;
@@ -18,8 +18,9 @@ namespace {
 template<typename T>
 struct GpuData {
   T *AA, *L, s;
+  unsigned int hits, misses;
   cublasHandle_t handle;
-  GpuData() : AA(0), L(0), s(static_cast<T>(-1.)) {
+  GpuData() : AA(0), L(0), s(static_cast<T>(-1.)), hits(0), misses(0) {
     cublasCreate(&handle);
     CUDA_CHECK_ERR();
   }
@@ -102,9 +103,18 @@ int ProjectorDirect<T, M>::Init() {
   return 0;
 }
 
+// Nothing is kept between projections on the GPU.
+template <typename T, typename M>
+void *ProjectorDirect<T, M>::NewWork() const {
+  return 0;
+}
+
+template <typename T, typename M>
+void ProjectorDirect<T, M>::DeleteWork(void *work) const { }
+
 template <typename T, typename M>
 int ProjectorDirect<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
-                                   T tol) {
+                                   T tol, void *work) {
   DEBUG_EXPECT(this->_done_init);
   if (!this->_done_init || s < static_cast<T>(0.))
     return 1;
@@ -126,6 +136,12 @@ int ProjectorDirect<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
   cml::vector_memcpy(&y_vec, &y0_vec);
   CUDA_CHECK_ERR();
 
+  // Only a single factor is kept on the GPU.
+  if (s != info->s)
+    ++info->misses;
+  else
+    ++info->hits;
+
   if (_A.Order() == MatrixDense<T>::ROW) {
     const cml::matrix<T, CblasRowMajor> A =
         cml::matrix_view_array<T, CblasRowMajor>
@@ -210,6 +226,20 @@ int ProjectorDirect<T, M>::Project(const T *x0, const T *y0, T s, T *x, T *y,
   return 0;
 }
 
+template <typename T, typename M>
+FactorStats ProjectorDirect<T, M>::GetFactorStats() const {
+  GpuData<T> *info = reinterpret_cast<GpuData<T>*>(this->_info);
+
+  FactorStats stats = { info->hits, info->misses, 0. };
+  return stats;
+}
+
+template <typename T, typename M>
+KrylovStats ProjectorDirect<T, M>::GetKrylovStats() const {
+  KrylovStats stats = { 0u, 0u, 0u };
+  return stats;
+}
+
 #if !defined(POGS_DOUBLE) || POGS_DOUBLE==1
 template class ProjectorDirect<double, MatrixDense<double> >;
 #endif
@@ -28,6 +28,12 @@ class Matrix {
   // Method to multiply by A and A^T.
   virtual int Mul(char trans, T alpha, const T *x, T beta, T *y) const = 0;
 
+  // Reordering applied by Init, if any: row i (column j) of the matrix that
+  // Equil and Mul act on is row RowPerm()[i] (column ColPerm()[j]) of A.
+  // Null if A is used as given.
+  virtual const size_t *RowPerm() const { return 0; }
+  virtual const size_t *ColPerm() const { return 0; }
+
   // Get dimensions and check if initialized
   size_t Rows() const { return _m; }
   size_t Cols() const { return _n; }
@@ -34,6 +34,10 @@ class MatrixDense : public Matrix<T> {
   // Method to multiply by A and A^T.
   int Mul(char trans, T alpha, const T *x, T beta, T *y) const;
 
+  // Same as Mul, for k vectors stored with strides ldx and ldy.
+  int MulBatch(char trans, size_t k, T alpha, const T *x, size_t ldx, T beta,
+               T *y, size_t ldy) const;
+
   // Getters
   const T* Data() const { return _data; }
   Ord Order() const { return _ord; }
@@ -1,13 +1,20 @@
 #ifndef MATRIX_MATRIX_SPARSE_H_
 #define MATRIX_MATRIX_SPARSE_H_
 
+#include <cstdint>
+
 #include "matrix.h"
 
 namespace pogs {
 
 typedef int POGS_INT;
 
-template <typename T>
+// Index type for matrices with 2^31 or more nonzeros.
+typedef int64_t POGS_INT64;
+
+// Sparse matrix with index type I (POGS_INT or POGS_INT64), which is used
+// for the dimensions, the pointers and the indices alike.
+template <typename T, typename I = POGS_INT>
 class MatrixSparse : public Matrix<T> {
  public:
   enum Ord {ROW, COL};
@@ -15,17 +22,31 @@ class MatrixSparse : public Matrix<T> {
  private:
   T *_data;
   
-  POGS_INT *_ptr, *_ind, _nnz;
+  I *_ptr, *_ind, _nnz;
 
   Ord _ord;
 
+  bool _transpose;
+
   // Get rid of assignment operator.
-  MatrixSparse<T>& operator=(const MatrixSparse<T>& A);
+  MatrixSparse<T, I>& operator=(const MatrixSparse<T, I>& A);
 
  public:
-  MatrixSparse(char ord, POGS_INT m, POGS_INT n, POGS_INT nnz, const T *data,
-      const POGS_INT *ptr, const POGS_INT *ind);
-  MatrixSparse(const MatrixSparse<T>& A);
+  // By default A is stored twice, in its own order and transposed, so that
+  // products with A and A^T both stream rows. With store_transpose = false
+  // only A is stored, halving the memory, and products with A^T scatter the
+  // rows (columns) of A instead. If use_sell is set, each stored
+  // orientation is also kept in SELL-C-sigma format, in which Mul runs as
+  // SIMD gathers (with AVX2 enabled at compile time), at the cost of another
+  // copy of A plus padding. If reorder is set, Init permutes the rows and
+  // columns of A by reverse Cuthill-McKee, so that the entries of x
+  // gathered by nearby rows are close in memory (see RowPerm and ColPerm).
+  // Pogs undoes the permutation in its output. These options are only
+  // supported on the CPU.
+  MatrixSparse(char ord, I m, I n, I nnz, const T *data, const I *ptr,
+      const I *ind, bool store_transpose = true, bool use_sell = false,
+      bool reorder = false);
+  MatrixSparse(const MatrixSparse<T, I>& A);
   ~MatrixSparse();
 
   // Call this before any other method.
@@ -37,12 +58,20 @@ class MatrixSparse : public Matrix<T> {
   // Method to multiply by A and A^T.
   int Mul(char trans, T alpha, const T *x, T beta, T *y) const;
 
-  // Getters
+  // Same as Mul, for k vectors stored with strides ldx and ldy.
+  int MulBatch(char trans, size_t k, T alpha, const T *x, size_t ldx, T beta,
+               T *y, size_t ldy) const;
+
+  // Getters. Data() and Ind() hold Nnz() entries of A in its own order,
+  // followed by Nnz() entries of A^T if HasTranspose(), after reordering.
   const T* Data() const { return _data; }
-  const POGS_INT* Ptr() const { return _ptr; }
-  const POGS_INT* Ind() const { return _ind; }
-  POGS_INT Nnz() const { return _nnz; }
+  const I* Ptr() const { return _ptr; }
+  const I* Ind() const { return _ind; }
+  I Nnz() const { return _nnz; }
   Ord Order() const { return _ord; }
+  bool HasTranspose() const { return _transpose; }
+  const size_t *RowPerm() const;
+  const size_t *ColPerm() const;
 };
 
 }  // namespace pogs
@@ -2,11 +2,14 @@
 #define POGS_H_
 
 #include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "projector/projector_direct.h"
 #include "projector/projector_cgls.h"
+#include "projector/projector_eig.h"
+#include "projector/projector_lsmr.h"
 #include "prox_lib.h"
 
 
@@ -23,6 +26,10 @@ const unsigned int kMaxIter     = 2500u;
 const unsigned int kInitIter    = 10u;
 const bool         kAdaptiveRho = true;
 const bool         kGapStop     = false;
+const unsigned int kExactFreq   = 1u;   // 0 = only near convergence.
+const unsigned int kAndersonMem = 0u;   // 0 = no Anderson acceleration.
+const ProxAccuracy kProxAccuracy = kProxAccurate;
+const bool         kProxWarmStart = false;
 
 // Status messages
 enum PogsStatus { POGS_SUCCESS,    // Converged succesfully.
@@ -33,36 +40,127 @@ enum PogsStatus { POGS_SUCCESS,    // Converged succesfully.
                   POGS_ERROR };    // Generic error, check logs.
 
 
-// Proximal Operator Graph Solver.
 template <typename T, typename M, typename P>
-class Pogs {
+class Pogs;
+
+// The part of a problem that does not depend on f and g: the equilibrated
+// matrix A, the scaling (d, e) and the projector onto y = Ax, including any
+// factorization. It can be shared by any number of Pogs solvers, each of
+// which only holds its own iterates. Once Init() has returned the object is
+// read only, so solvers sharing it may call Solve concurrently.
+template <typename T, typename M, typename P>
+class PogsPrepared {
  private:
-  // Data
   M _A;
   P _P;
+  T *_de;
+  bool _done_init;
+
+  // Get rid of copy constructor and assignment operator.
+  PogsPrepared(const PogsPrepared<T, M, P>& prep);
+  PogsPrepared<T, M, P>& operator=(const PogsPrepared<T, M, P>& prep);
+
+  friend class Pogs<T, M, P>;
+
+ public:
+  PogsPrepared(const M &A);
+  ~PogsPrepared();
+
+  // Copy and equilibrate A and set up the projector. Not thread safe.
+  int Init();
+
+  bool IsInit() const { return _done_init; }
+
+  // Projector, e.g. to size its factorization cache before Init().
+  P& GetProjector() { return _P; }
+};
+
+// Proximal Operator Graph Solver.
+template <typename T, typename M, typename P>
+class Pogs {
+ private:
+  // Data (A, P and _de are owned by _prep).
+  std::shared_ptr<PogsPrepared<T, M, P> > _prep;
+  const M &_A;
+  P &_P;
   T *_de, *_z, *_zt, _rho;
   bool _done_init;
 
+  // Workspace, allocated once in _Init() and reused by every call to Solve.
+  T *_zprev, *_ztemp, *_z12;
+  FunctionVector<T> _f, _g;
+  std::vector<FunctionRun> _f_runs, _g_runs;
+  unsigned int _num_alloc;
+
+  // Anderson acceleration state (platform specific, allocated in Solve).
+  void *_anderson;
+
+  // Projector state of this session, such as the warm start of an iterative
+  // projector (allocated in _Init, null if the projector keeps none).
+  void *_proj_work;
+
   // Setup matrix _A and solver _LS
   int _Init();
 
+  // Solve for f and g given as std::vector<FunctionObj<T> > or
+  // FunctionVector<T>, with the loops f_ops and g_ops over their copies.
+  template <typename F>
+  PogsStatus _Solve(const F& f, const F& g, const FunctionOps<T>& f_ops,
+                    const FunctionOps<T>& g_ops);
+  PogsStatus _SolveOps(const FunctionVector<T>& f, const FunctionVector<T>& g,
+                       const FunctionOps<T>& f_ops,
+                       const FunctionOps<T>& g_ops);
+
   // Output.
   T *_x, *_y, *_mu, *_lambda, _optval;
-  unsigned int _final_iter;
+  unsigned int _final_iter, _final_matvec_saved;
+  unsigned int _final_aa_accepted, _final_aa_rejected, _final_krylov_iter;
+  ProxStats _final_prox_stats;
 
   // Parameters.
   T _abs_tol, _rel_tol;
-  unsigned int _max_iter, _init_iter, _verbose;
-  bool _adaptive_rho, _gap_stop, _init_x, _init_lambda;
+  unsigned int _max_iter, _init_iter, _verbose, _exact_freq, _anderson_mem;
+  bool _adaptive_rho, _gap_stop, _init_x, _init_lambda, _prox_warm_start;
+  ProxAccuracy _prox_accuracy;
 
  public:
   // Constructor and Destructor.
   Pogs(const M &A);
+  // Solver that shares prep with other solvers. If they are to be used from
+  // several threads, call prep->Init() before the first Solve.
+  Pogs(const std::shared_ptr<PogsPrepared<T, M, P> > &prep);
   ~Pogs();
   
   // Solve for specific objective.
   PogsStatus Solve(const std::vector<FunctionObj<T> >& f,
                    const std::vector<FunctionObj<T> >& g);
+  // Same, with parameters that are equal for all elements stored once.
+  PogsStatus Solve(const FunctionVector<T>& f, const FunctionVector<T>& g);
+  // Same, with the prox, objective and subgradient loops specialized at
+  // compile time for the function and fixed parameters of f and g. As the
+  // equilibration scales a per element, kParamA is not fixed in the
+  // solver's copy. CPU only.
+  template <Function hf, unsigned int ff, Function hg, unsigned int fg>
+  PogsStatus Solve(const FunctionStatic<T, hf, ff>& f,
+                   const FunctionStatic<T, hg, fg>& g) {
+    const unsigned int kScaled = kParamB | kParamC | kParamD | kParamE;
+    if (!f.IsValid() || !g.IsValid())
+      return POGS_ERROR;
+    return _SolveOps(f, g, StaticOps<T, hf, ff & kScaled>(),
+        StaticOps<T, hg, fg & kScaled>());
+  }
+
+  // Solve k = f.size() problems (f[i], g[i]) with the same A. The ADMM
+  // iterates are advanced together, so that matvecs and projections act on
+  // all unfinished problems at once. Each problem has its own rho and
+  // stopping criterion, and leaves the batch as soon as it stops. Problem i
+  // starts from zero and its solution is written to x + i * n, y + i * m,
+  // mu + i * n, lambda + i * m and optval[i]. Output pointers may be null.
+  // CPU only.
+  std::vector<PogsStatus> SolveBatch(
+      const std::vector<std::vector<FunctionObj<T> > >& f,
+      const std::vector<std::vector<FunctionObj<T> > >& g,
+      T *x, T *y, T *mu, T *lambda, T *optval);
 
   // Getters for solution variables and parameters.
   const T*     GetX()           const { return _x; }
@@ -71,6 +169,14 @@ class Pogs {
   const T*     GetMu()          const { return _mu; }
   T            GetOptval()      const { return _optval; }
   unsigned int GetFinalIter()   const { return _final_iter; }
+  unsigned int GetFinalMatvecSaved() const { return _final_matvec_saved; }
+  unsigned int GetFinalAndersonAccepted() const { return _final_aa_accepted; }
+  unsigned int GetFinalAndersonRejected() const { return _final_aa_rejected; }
+  unsigned int GetFinalKrylovIter() const { return _final_krylov_iter; }
+  // Elements evaluated with a warm-started prox operator during the last
+  // solve, summed over iterations, and their inner iterations. Zero unless
+  // SetProxWarmStart(true).
+  ProxStats    GetFinalProxStats() const { return _final_prox_stats; }
   T            GetRho()         const { return _rho; }
   T            GetRelTol()      const { return _rel_tol; }
   T            GetAbsTol()      const { return _abs_tol; }
@@ -79,6 +185,31 @@ class Pogs {
   unsigned int GetVerbose()     const { return _verbose; }
   bool         GetAdaptiveRho() const { return _adaptive_rho; }
   bool         GetGapStop()     const { return _gap_stop; }
+  unsigned int GetExactFreq()   const { return _exact_freq; }
+  unsigned int GetAndersonMem() const { return _anderson_mem; }
+  ProxAccuracy GetProxAccuracy() const { return _prox_accuracy; }
+  bool         GetProxWarmStart() const { return _prox_warm_start; }
+
+  // Number of buffers owned by this object that were (re)allocated: the
+  // ADMM iterates, the Anderson and projector state and the copies of f and
+  // g and of their runs. Stays constant across calls to Solve once the first
+  // solve has completed. Allocations inside the matrix, projector or BLAS
+  // calls are not counted.
+  unsigned int GetNumAlloc()    const { return _num_alloc; }
+
+  // Factorization cache statistics of the projector, accumulated over all
+  // solvers that share it.
+  FactorStats GetFactorStats() const { return _P.GetFactorStats(); }
+
+  // Inner iteration statistics of an iterative projector, accumulated over
+  // all solvers that share it. GetFinalKrylovIter is the number taken
+  // during the last solve.
+  KrylovStats GetKrylovStats() const { return _P.GetKrylovStats(); }
+
+  // Shared part of the problem, from which further solvers can be created.
+  const std::shared_ptr<PogsPrepared<T, M, P> >& GetPrepared() const {
+    return _prep;
+  }
 
 
   // Setters for parameters and initial values.
@@ -89,7 +220,29 @@ class Pogs {
   void SetInitIter(unsigned int init_iter) { _init_iter = init_iter; }
   void SetVerbose(unsigned int verbose)    { _verbose = verbose; }
   void SetAdaptiveRho(bool adaptive_rho)   { _adaptive_rho = adaptive_rho; }
+  // Anderson acceleration of the map (z, zt) -> (z, zt) using the last
+  // anderson_mem iterates. Accelerated steps that increase the fixed-point
+  // residual are rejected in favour of the plain ADMM step. 0 disables it.
+  void SetAndersonMem(unsigned int anderson_mem) {
+    _anderson_mem = anderson_mem;
+  }
   void SetGapStop(bool gap_stop)           { _gap_stop = gap_stop; }
+  // Compute exact residuals (two extra matvecs) every exact_freq iterations.
+  // If exact_freq is 0, they are only computed once the cheap residual
+  // estimates are within tolerance. Convergence is always confirmed with
+  // exact residuals.
+  void SetExactFreq(unsigned int exact_freq) { _exact_freq = exact_freq; }
+  // Accuracy of the prox of kExp, kLogistic and kNegEntr, see ProxAccuracy.
+  // kProxFast keeps float problems in float and vectorizes. CPU only.
+  void SetProxAccuracy(ProxAccuracy prox_accuracy) {
+    _prox_accuracy = prox_accuracy;
+  }
+  // Start the iterative prox operators of kExp, kLogistic, kNegEntr and
+  // kRecipr from their result in the previous iteration, see ProxEvalWarm.
+  // Only applies with kProxAccurate. CPU only.
+  void SetProxWarmStart(bool prox_warm_start) {
+    _prox_warm_start = prox_warm_start;
+  }
   void SetInitX(const T *x) {
     memcpy(_x, x, _A.Cols() * sizeof(T));
     _init_x = true;
@@ -107,6 +260,12 @@ using PogsDirect = Pogs<T, M, ProjectorDirect<T, M> >;
 
 template <typename T, typename M>
 using PogsIndirect = Pogs<T, M, ProjectorCgls<T, M> >;
+
+template <typename T, typename M>
+using PogsEig = Pogs<T, M, ProjectorEig<T, M> >;
+
+template <typename T, typename M>
+using PogsLsmr = Pogs<T, M, ProjectorLsmr<T, M> >;
 #endif
 
 // String version of status message.
@@ -3,7 +3,26 @@
 
 namespace pogs {
 
+// Factorization cache statistics. Projectors that do not factorize report
+// zeros.
+struct FactorStats {
+  unsigned int hits, misses;
+  double time;
+};
+
+// Iterative solver statistics: number of projections, total inner
+// iterations and total products with A or A^T. Direct projectors report
+// zeros.
+struct KrylovStats {
+  unsigned int projections, iters, matvecs;
+};
+
 // Minimizes ||Ax - y0||^2  + s ||x - x0||^2
+//
+// A projector is read only after Init. Anything that changes from one
+// projection to the next (warm starts, scratch space) lives in a work object
+// from NewWork, one per session, which is passed to Project. Without one,
+// Project allocates its scratch and starts cold.
 template <typename T, typename M>
 class Projector {
  protected:
@@ -17,7 +36,8 @@ class Projector {
   
   virtual int Init() = 0;
 
-  virtual int Project(const T *x0, const T *y0, T s, T *x, T *y, T tol) = 0;
+  virtual int Project(const T *x0, const T *y0, T s, T *x, T *y, T tol,
+                      void *work = 0) = 0;
   
   bool IsInit() { return _done_init; }
 };
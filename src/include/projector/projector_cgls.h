@@ -5,6 +5,11 @@
 
 namespace pogs {
 
+// Preconditioners for CGLS. Jacobi uses the column norms of A. Incomplete
+// Cholesky (zero fill, on the pattern of A^T A) is only available for
+// MatrixSparse, dense matrices fall back to Jacobi.
+enum CglsPrecond { kCglsPrecondNone, kCglsPrecondJacobi, kCglsPrecondIncChol };
+
 // Minimizes ||Ax - y0||_2^2  + s ||x - x0||_2^2
 template <typename T, typename M>
 class ProjectorCgls : Projector<T, M> {
@@ -16,12 +21,38 @@ class ProjectorCgls : Projector<T, M> {
   ProjectorCgls<M, T>& operator=(const ProjectorCgls<T, M>& P);
 
  public:
-  ProjectorCgls(const M& A);
+  ProjectorCgls(const M& A, CglsPrecond precond = kCglsPrecondNone);
   ~ProjectorCgls();
   
   int Init();
 
-  int Project(const T *x0, const T *y0, T s, T *x, T *y, T tol);
+  // State of one session: the warm start, the CGLS workspace and the
+  // incomplete Cholesky factor for its last s.
+  void *NewWork() const;
+  void DeleteWork(void *work) const;
+
+  int Project(const T *x0, const T *y0, T s, T *x, T *y, T tol,
+              void *work = 0);
+
+  // Projects k vectors (x0, y0), each stored with stride ld. The work of
+  // vector i, if any, is work[i].
+  int ProjectBatch(size_t k, const T *x0, const T *y0, size_t ld, T s, T *x,
+                   T *y, T tol, void *const *work = 0);
+
+  // With warm start (the default) the previous solution of the session,
+  // shifted by the change in x0, is the initial guess for CGLS. Not thread
+  // safe.
+  void SetWarmStart(bool warm_start);
+
+  // Selects the preconditioner, which is set up in Init (or right away if
+  // the projector has already been initialized). Not thread safe.
+  void SetPrecond(CglsPrecond precond);
+
+  // No factorization, always zero.
+  FactorStats GetFactorStats() const;
+
+  // Cumulative number of projections, CGLS iterations and matvecs.
+  KrylovStats GetKrylovStats() const;
 };
 
 }  // namespace pogs
@@ -6,6 +6,12 @@
 namespace pogs {
 
 // Minimizes ||Ax - y0||^2  + s ||x - x0||^2
+//
+// For MatrixDense, uses a Cholesky factorization of A^T A + sI (or of
+// AA^T + sI if A is wide). For MatrixSparse, uses a sparse LDL' factorization
+// of the quasi-definite matrix [sI A^T; A -I] under a minimum degree
+// ordering. The ordering and symbolic analysis are computed once in Init, so
+// a new s only costs a numeric factorization. CPU only for MatrixSparse.
 template <typename T, typename M>
 class ProjectorDirect : Projector<T, M> {
  private:
@@ -21,7 +27,29 @@ class ProjectorDirect : Projector<T, M> {
   
   int Init();
 
-  int Project(const T *x0, const T *y0, T s, T *x, T *y, T tol);
+  // State of one session: the solve buffer of the KKT system for
+  // MatrixSparse, null for MatrixDense.
+  void *NewWork() const;
+  void DeleteWork(void *work) const;
+
+  int Project(const T *x0, const T *y0, T s, T *x, T *y, T tol,
+              void *work = 0);
+
+  // Projects k vectors (x0, y0), each stored with stride ld. The work of
+  // vector i, if any, is work[i]; the vectors are solved one after another
+  // in work[0].
+  int ProjectBatch(size_t k, const T *x0, const T *y0, size_t ld, T s, T *x,
+                   T *y, T tol, void *const *work = 0);
+
+  // Cache factors for as many values of s as fit in bytes (at least one),
+  // evicting the least recently used. Not thread safe.
+  void SetFactorCacheBytes(size_t bytes);
+
+  // Cumulative factorization cache hits, misses and time spent factorizing.
+  FactorStats GetFactorStats() const;
+
+  // No inner iterations, always zero.
+  KrylovStats GetKrylovStats() const;
 };
 
 }  // namespace pogs
@@ -0,0 +1,51 @@
+#ifndef PROJECTOR_PROJECTOR_EIG_H_ 
+#define PROJECTOR_PROJECTOR_EIG_H_ 
+
+#include "projector/projector.h"
+
+namespace pogs {
+
+// Minimizes ||Ax - y0||^2  + s ||x - x0||^2
+//
+// Uses the eigendecomposition Q diag(lambda) Q^T of A^T A (or A A^T if A is
+// wide), computed once in Init. Changing s then costs nothing, whereas
+// ProjectorDirect has to refactor. Init is several times more expensive
+// than a single Cholesky factorization.
+template <typename T, typename M>
+class ProjectorEig : Projector<T, M> {
+ private:
+  const M& _A;
+
+  // Get rid of copy constructor and assignment operator.
+  ProjectorEig(const Projector<T, M>& A);
+  ProjectorEig<M, T>& operator=(const ProjectorEig<T, M>& P);
+
+ public:
+  ProjectorEig(const M& A);
+  ~ProjectorEig();
+  
+  int Init();
+
+  // State of one session: the buffer for Q^T x (or Q^T y).
+  void *NewWork() const;
+  void DeleteWork(void *work) const;
+
+  int Project(const T *x0, const T *y0, T s, T *x, T *y, T tol,
+              void *work = 0);
+
+  // Projects k vectors (x0, y0), each stored with stride ld. The work of
+  // vector i, if any, is work[i]; the batch is solved in work[0].
+  int ProjectBatch(size_t k, const T *x0, const T *y0, size_t ld, T s, T *x,
+                   T *y, T tol, void *const *work = 0);
+
+  // The decomposition counts as the single miss, every projection as a hit.
+  FactorStats GetFactorStats() const;
+
+  // No inner iterations, always zero.
+  KrylovStats GetKrylovStats() const;
+};
+
+}  // namespace pogs
+
+#endif  // PROJECTOR_PROJECTOR_EIG_H_ 
+
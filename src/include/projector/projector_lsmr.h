@@ -0,0 +1,54 @@
+#ifndef PROJECTOR_PROJECTOR_LSMR_H_ 
+#define PROJECTOR_PROJECTOR_LSMR_H_ 
+
+#include "projector/projector.h"
+
+namespace pogs {
+
+// Minimizes ||Ax - y0||_2^2  + s ||x - x0||_2^2
+//
+// Same as ProjectorCgls, but solves the damped least squares problem with
+// LSMR, whose normal equation residual decreases monotonically. This makes
+// it more reliable than CGLS at the loose tolerances used by Pogs when A is
+// ill-conditioned. Uses the same stopping criterion as ProjectorCgls.
+template <typename T, typename M>
+class ProjectorLsmr : Projector<T, M> {
+ private:
+  const M& _A;
+
+  // Get rid of copy constructor and assignment operator.
+  ProjectorLsmr(const Projector<T, M>& A);
+  ProjectorLsmr<M, T>& operator=(const ProjectorLsmr<T, M>& P);
+
+ public:
+  ProjectorLsmr(const M& A);
+  ~ProjectorLsmr();
+  
+  int Init();
+
+  // State of one session: the warm start and the LSMR workspace.
+  void *NewWork() const;
+  void DeleteWork(void *work) const;
+
+  int Project(const T *x0, const T *y0, T s, T *x, T *y, T tol,
+              void *work = 0);
+
+  // Projects k vectors (x0, y0), each stored with stride ld. The work of
+  // vector i, if any, is work[i].
+  int ProjectBatch(size_t k, const T *x0, const T *y0, size_t ld, T s, T *x,
+                   T *y, T tol, void *const *work = 0);
+
+  // Warm starts as in ProjectorCgls, on by default. Not thread safe.
+  void SetWarmStart(bool warm_start);
+
+  // No factorization, always zero.
+  FactorStats GetFactorStats() const;
+
+  // Cumulative number of projections, LSMR iterations and matvecs.
+  KrylovStats GetKrylovStats() const;
+};
+
+}  // namespace pogs
+
+#endif  // PROJECTOR_PROJECTOR_LSMR_H_
+
@@ -1,9 +1,12 @@
 #ifndef PROX_LIB_H_
 #define PROX_LIB_H_
 
+#include <stdint.h>
+
 #include <algorithm>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <limits>
 #include <vector>
 
@@ -15,8 +18,14 @@
 #include <thrust/reduce.h>
 #include <thrust/execution_policy.h>
 #define __DEVICE__ __device__
+#define __FORCE_INLINE__ __forceinline__
 #else
 #define __DEVICE__
+#ifdef __GNUC__
+#define __FORCE_INLINE__ inline __attribute__((always_inline))
+#else
+#define __FORCE_INLINE__ inline
+#endif
 #endif
 
 #include "interface_defs.h"
@@ -71,6 +80,189 @@ struct FunctionObj {
   }
 };
 
+// Vector of function objects stored as one array per parameter. An array
+// with a single entry applies to every element, so that a parameter that is
+// the same for all elements (e.g. a = 1, or c = lambda in the lasso) is
+// stored and read once instead of once per element. Arrays that vary must
+// have size() entries, and c and e must be non-negative.
+template <typename T>
+class FunctionVector {
+ private:
+  size_t _size;
+
+  static T Param(const std::vector<T> &p, size_t i) {
+    return p.size() == 1 ? p[0] : p[i];
+  }
+
+  static bool IsNegative(T x) { return x < static_cast<T>(0); }
+
+  // Sets p to the member m of x[perm[i]] (x[i] if perm is null) for
+  // i < _size, or to a single entry if it is the same for all x[i].
+  template <typename V>
+  void AssignParam(const FunctionObj<T> *x, const size_t *perm,
+                   V FunctionObj<T>::*m, std::vector<V> *p) {
+    size_t k = 1;
+    while (k < _size && x[k].*m == x[0].*m)
+      ++k;
+    if (k >= _size) {
+      p->assign(1, x[0].*m);
+      return;
+    }
+    p->resize(_size);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < _size; ++i)
+      (*p)[i] = x[perm ? perm[i] : i].*m;
+  }
+
+  template <typename V>
+  void AssignParam(const std::vector<V> &x, const size_t *perm,
+                   std::vector<V> *p) {
+    if (x.size() == 1) {
+      p->assign(1, x[0]);
+      return;
+    }
+    p->resize(_size);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < _size; ++i)
+      (*p)[i] = x[perm ? perm[i] : i];
+  }
+
+ public:
+  std::vector<Function> h;
+  std::vector<T> a, b, c, d, e;
+
+  FunctionVector() : _size(0) { }
+  // size copies of f_obj.
+  explicit FunctionVector(size_t size,
+                          const FunctionObj<T> &f_obj = FunctionObj<T>())
+      : _size(size), h(1, f_obj.h), a(1, f_obj.a), b(1, f_obj.b),
+        c(1, f_obj.c), d(1, f_obj.d), e(1, f_obj.e) { }
+  explicit FunctionVector(const std::vector<FunctionObj<T> > &f_obj)
+      : _size(0) { Assign(f_obj); }
+
+  size_t size() const { return _size; }
+
+  // Sets the size, after which each array must have one or size entries.
+  void resize(size_t size) { _size = size; }
+
+  // True if every array has one or size() entries.
+  bool IsValid() const {
+    return (h.size() == 1 || h.size() == _size) &&
+        (a.size() == 1 || a.size() == _size) &&
+        (b.size() == 1 || b.size() == _size) &&
+        (c.size() == 1 || c.size() == _size) &&
+        (d.size() == 1 || d.size() == _size) &&
+        (e.size() == 1 || e.size() == _size);
+  }
+
+  // Same as FunctionObj::CheckConsts, for every element.
+  void CheckConsts() {
+    if (std::find_if(c.begin(), c.end(), IsNegative) != c.end())
+      Printf("WARNING c < 0. Function not convex. Using c = 0");
+    if (std::find_if(e.begin(), e.end(), IsNegative) != e.end())
+      Printf("WARNING e < 0. Function not convex. Using e = 0");
+    std::replace_if(c.begin(), c.end(), IsNegative, static_cast<T>(0));
+    std::replace_if(e.begin(), e.end(), IsNegative, static_cast<T>(0));
+  }
+
+  // Element i as a function object.
+  FunctionObj<T> operator[](size_t i) const {
+    FunctionObj<T> f(h.size() == 1 ? h[0] : h[i]);
+    f.a = Param(a, i);
+    f.b = Param(b, i);
+    f.c = Param(c, i);
+    f.d = Param(d, i);
+    f.e = Param(e, i);
+    return f;
+  }
+
+  // Element i is set to f_obj[perm[i]], or to f_obj[i] if perm is null.
+  // Parameters that are equal for all elements are stored once. Reuses the
+  // storage of the arrays.
+  void Assign(const std::vector<FunctionObj<T> > &f_obj,
+              const size_t *perm = 0) {
+    _size = f_obj.size();
+    if (_size == 0) {
+      h.clear();
+      a.clear();
+      b.clear();
+      c.clear();
+      d.clear();
+      e.clear();
+      return;
+    }
+    const FunctionObj<T> *x = f_obj.data();
+    AssignParam(x, perm, &FunctionObj<T>::h, &h);
+    AssignParam(x, perm, &FunctionObj<T>::a, &a);
+    AssignParam(x, perm, &FunctionObj<T>::b, &b);
+    AssignParam(x, perm, &FunctionObj<T>::c, &c);
+    AssignParam(x, perm, &FunctionObj<T>::d, &d);
+    AssignParam(x, perm, &FunctionObj<T>::e, &e);
+  }
+
+  // Element i is set to f[perm[i]], or to f[i] if perm is null.
+  void Assign(const FunctionVector<T> &f, const size_t *perm = 0) {
+    _size = f.size();
+    AssignParam(f.h, perm, &h);
+    AssignParam(f.a, perm, &a);
+    AssignParam(f.b, perm, &b);
+    AssignParam(f.c, perm, &c);
+    AssignParam(f.d, perm, &d);
+    AssignParam(f.e, perm, &e);
+  }
+
+  // Storage of the arrays in elements, to track reallocation.
+  size_t Capacity() const {
+    return h.capacity() + a.capacity() + b.capacity() + c.capacity() +
+        d.capacity() + e.capacity();
+  }
+};
+
+// Parameters of a FunctionStatic that keep their defaults a = c = 1 and
+// b = d = e = 0.
+enum FunctionParam { kParamA = 1, kParamB = 2, kParamC = 4, kParamD = 8,
+                     kParamE = 16 };
+
+// FunctionVector whose elements all have the function func, and whose
+// parameters in fixed, a combination of FunctionParam, keep their
+// defaults, both known at compile time. ProxEval, FuncEval,
+// ProjSubgradEval and Pogs::Solve of it run loops specialized for func,
+// which neither load nor compute with the fixed parameters, see
+// ProxEvalStatic. E.g. lambda |x_j| for j < n is
+//   FunctionStatic<T, kAbs, kParamA | kParamB | kParamD | kParamE>(
+//       n, FunctionObj<T>(kAbs, 1, 0, lambda)).
+template <typename T, Function func, unsigned int fixed = 0>
+class FunctionStatic : public FunctionVector<T> {
+ private:
+  static bool IsDefault(const std::vector<T> &p, unsigned int param, T x) {
+    return !(fixed & param) || (p.size() == 1 && p[0] == x);
+  }
+
+ public:
+  FunctionStatic() : FunctionVector<T>(0, FunctionObj<T>(func)) { }
+  // size copies of f_obj, whose function must be func.
+  explicit FunctionStatic(size_t size,
+                          const FunctionObj<T> &f_obj = FunctionObj<T>(func))
+      : FunctionVector<T>(size, f_obj) { }
+
+  // FunctionVector::IsValid, every element has the function func and the
+  // parameters in fixed are stored once with their default.
+  bool IsValid() const {
+    const T kOne = static_cast<T>(1), kZero = static_cast<T>(0);
+    return FunctionVector<T>::IsValid() &&
+        this->h.size() == 1 && this->h[0] == func &&
+        IsDefault(this->a, kParamA, kOne) &&
+        IsDefault(this->b, kParamB, kZero) &&
+        IsDefault(this->c, kParamC, kOne) &&
+        IsDefault(this->d, kParamD, kZero) &&
+        IsDefault(this->e, kParamE, kZero);
+  }
+};
+
 
 // Local Functions.
 namespace {
@@ -144,11 +336,35 @@ __DEVICE__ inline T Sign(T x) {
   return x >= 0 ? 1 : -1;
 }
 
+// Halley iteration for the root w of w e^w = e^x, starting from *w. Stops
+// after 10 steps or once the step is below Epsilon, and returns whether it
+// did the latter. If predict is set it also stops once the cube of the
+// step, which bounds the error after it since the iteration converges
+// cubically with a constant below 1/2 for w > 0, is. Adds the number of
+// steps to *iter.
+template <typename T>
+__DEVICE__ inline bool LambertWExpHalley(T x, T *w, unsigned int *iter,
+                                         bool predict = false) {
+  for (unsigned int i = 0u; i < 10u; i++) {
+    T e = Exp(*w);
+    T t = *w * e - Exp(x);
+    T p = *w + static_cast<T>(1.);
+    t /= e * p - static_cast<T>(0.5) * (p + static_cast<T>(1.0)) * t / p;
+    *w -= t;
+    ++*iter;
+    T tol = Epsilon<T>() * (static_cast<T>(1) + Abs(*w));
+    if (Abs(t) < tol || (predict && Abs(t * t * t) < tol))
+      return true;
+  }
+  return false;
+}
+
 // LambertW(Exp(x))
-// Evaluate the principal branch of the Lambert W function.
+// Evaluate the principal branch of the Lambert W function. Adds the number
+// of Halley steps to *iter, if given.
 // ref: http://keithbriggs.info/software/LambertW.c
 template <typename T>
-__DEVICE__ inline T LambertWExp(T x) {
+__DEVICE__ inline T LambertWExp(T x, unsigned int *iter = 0) {
   T w;
   if (x > static_cast<T>(100)) {
     // Approximation for x in [100, 700].
@@ -169,18 +385,25 @@ __DEVICE__ inline T LambertWExp(T x) {
   if (x > static_cast<T>(1.098612288668110)) {
     w -= Log(w);
   }
-  for (unsigned int i = 0u; i < 10u; i++) {
-    T e = Exp(w);
-    T t = w * e - Exp(x);
-    T p = w + static_cast<T>(1.);
-    t /= e * p - static_cast<T>(0.5) * (p + static_cast<T>(1.0)) * t / p;
-    w -= t;
-    if (Abs(t) < Epsilon<T>() * (static_cast<T>(1) + Abs(w)))
-      break;
-  }
+  unsigned int num_iter = 0u;
+  LambertWExpHalley(x, &w, &num_iter);
+  if (iter)
+    *iter += num_iter;
   return w;
 }
 
+// LambertWExp by Halley's method from w0, e.g. the root for a nearby x.
+// Falls back to the guess of LambertWExp if w0 is outside (0, 2 max(1, x)),
+// which contains the root, or if the iteration does not converge from w0.
+template <typename T>
+__DEVICE__ inline T LambertWExpWarm(T x, T w0, unsigned int *iter) {
+  T w_max = 2 * Max(static_cast<T>(1), x);
+  if (x <= static_cast<T>(100) && w0 > 0 && w0 < w_max &&
+      LambertWExpHalley(x, &w0, iter, true))
+    return w0;
+  return LambertWExp(x, iter);
+}
+
 // Find the root of a cubic x^3 + px^2 + qx + r = 0 with a single positive root.
 // ref: http://math.stackexchange.com/questions/60376
 template <typename T>
@@ -200,6 +423,173 @@ __DEVICE__ inline T CubicSolve(T p, T q, T r) {
     return -s + (C - a / C) * Cos(B / 3);
   }
 }
+
+// Branch-free exp, log and Lambert W in precision T, used by the kProxFast
+// operators. They only use arithmetic, selects and integer operations on
+// the bit pattern of T, so that loops over them vectorize.
+
+// Layout of T: integer of the same width, mantissa bits and exponent bias.
+// Adding kShift to |x| < 2^(kMantBits - 1) rounds x to an integer n, which
+// is stored in the low bits of the result.
+template <typename T>
+struct FloatBits;
+
+template <>
+struct FloatBits<double> {
+  typedef int64_t Int;
+  static const int kMantBits = 52;
+  static const Int kBias = 1023;
+  __DEVICE__ static double Shift() { return 6755399441055744.0; }
+  __DEVICE__ static double ExpMin() { return -708.0; }
+  __DEVICE__ static double ExpMax() { return 709.0; }
+};
+
+template <>
+struct FloatBits<float> {
+  typedef int32_t Int;
+  static const int kMantBits = 23;
+  static const Int kBias = 127;
+  __DEVICE__ static float Shift() { return 12582912.0f; }
+  __DEVICE__ static float ExpMin() { return -87.0f; }
+  __DEVICE__ static float ExpMax() { return 88.0f; }
+};
+
+template <typename T>
+__DEVICE__ __FORCE_INLINE__ typename FloatBits<T>::Int ToBits(T x) {
+  typename FloatBits<T>::Int i;
+  memcpy(&i, &x, sizeof(T));
+  return i;
+}
+
+template <typename T>
+__DEVICE__ __FORCE_INLINE__ T FromBits(typename FloatBits<T>::Int i) {
+  T x;
+  memcpy(&x, &i, sizeof(T));
+  return x;
+}
+
+// Taylor series of e^r for |r| <= log(2) / 2, and of atanh(s) / s in
+// z = s^2 for |s| <= 3 - 2 sqrt(2), both to within an ulp.
+__DEVICE__ __FORCE_INLINE__ double ExpPoly(double r) {
+  double p = 1. / 6227020800.;
+  p = p * r + 1. / 479001600.;
+  p = p * r + 1. / 39916800.;
+  p = p * r + 1. / 3628800.;
+  p = p * r + 1. / 362880.;
+  p = p * r + 1. / 40320.;
+  p = p * r + 1. / 5040.;
+  p = p * r + 1. / 720.;
+  p = p * r + 1. / 120.;
+  p = p * r + 1. / 24.;
+  p = p * r + 1. / 6.;
+  p = p * r + 0.5;
+  p = p * r + 1.;
+  return p * r + 1.;
+}
+
+__DEVICE__ __FORCE_INLINE__ float ExpPoly(float r) {
+  float p = 1.f / 5040.f;
+  p = p * r + 1.f / 720.f;
+  p = p * r + 1.f / 120.f;
+  p = p * r + 1.f / 24.f;
+  p = p * r + 1.f / 6.f;
+  p = p * r + 0.5f;
+  p = p * r + 1.f;
+  return p * r + 1.f;
+}
+
+__DEVICE__ __FORCE_INLINE__ double AtanhPoly(double z) {
+  double p = 1. / 21.;
+  p = p * z + 1. / 19.;
+  p = p * z + 1. / 17.;
+  p = p * z + 1. / 15.;
+  p = p * z + 1. / 13.;
+  p = p * z + 1. / 11.;
+  p = p * z + 1. / 9.;
+  p = p * z + 1. / 7.;
+  p = p * z + 1. / 5.;
+  p = p * z + 1. / 3.;
+  return p * z + 1.;
+}
+
+__DEVICE__ __FORCE_INLINE__ float AtanhPoly(float z) {
+  float p = 1.f / 9.f;
+  p = p * z + 1.f / 7.f;
+  p = p * z + 1.f / 5.f;
+  p = p * z + 1.f / 3.f;
+  return p * z + 1.f;
+}
+
+// e^x, with x clamped to [ExpMin, ExpMax] so that the result is a normal
+// number. Relative error of about an ulp.
+template <typename T>
+__DEVICE__ __FORCE_INLINE__ T ExpFast(T x) {
+  typedef FloatBits<T> B;
+  const T kLog2e = static_cast<T>(1.4426950408889634);
+  const T kLn2Hi = static_cast<T>(0.693145751953125);
+  const T kLn2Lo = static_cast<T>(1.42860682030941723212e-6);
+  x = x < B::ExpMin() ? B::ExpMin() : x;
+  x = x > B::ExpMax() ? B::ExpMax() : x;
+  // x = n log(2) + r, e^x = 2^n e^r.
+  T t = x * kLog2e + B::Shift();
+  T n = t - B::Shift();
+  T r = (x - n * kLn2Hi) - n * kLn2Lo;
+  typename B::Int k = ToBits(t) - ToBits(B::Shift());
+  return ExpPoly(r) * FromBits<T>((k + B::kBias) << B::kMantBits);
+}
+
+// log(x) for normal x > 0, to within an ulp of max(1, |log(x)|).
+template <typename T>
+__DEVICE__ __FORCE_INLINE__ T LogFast(T x) {
+  typedef FloatBits<T> B;
+  typedef typename B::Int Int;
+  const T kLn2Hi = static_cast<T>(0.693145751953125);
+  const T kLn2Lo = static_cast<T>(1.42860682030941723212e-6);
+  const T kSqrt2 = static_cast<T>(1.4142135623730951);
+  const Int kMantMask = (static_cast<Int>(1) << B::kMantBits) - 1;
+  // x = 2^k m with m in [sqrt(1/2), sqrt(2)).
+  Int bits = ToBits(x);
+  Int k = (bits >> B::kMantBits) - B::kBias;
+  T m = FromBits<T>((bits & kMantMask) | (B::kBias << B::kMantBits));
+  Int big = m > kSqrt2 ? 1 : 0;
+  m = big ? m * static_cast<T>(0.5) : m;
+  T n = FromBits<T>(ToBits(B::Shift()) + k + big) - B::Shift();
+  // log(m) = 2 atanh(s), s = (m - 1) / (m + 1).
+  T s = (m - 1) / (m + 1);
+  return 2 * s * AtanhPoly(s * s) + n * kLn2Lo + n * kLn2Hi;
+}
+
+// LambertW(Exp(x)), i.e. the root of w + log(w) = x, by iter Newton steps
+// w := w (1 + x - log(w)) / (1 + w). The initial guess is within 2% (e^x
+// for x < -4, else Winitzki's approximation), so that two steps suffice in
+// single and three in double precision. Since w + log(w) is concave the
+// steps approach the root from below and never leave w > 0.
+template <typename T>
+__DEVICE__ __FORCE_INLINE__ T LambertWExpFast(T x, unsigned int iter) {
+  T x_abs = x < 0 ? -x : x;
+  T l = (x > 0 ? x : 0) + LogFast(1 + ExpFast(-x_abs));
+  T w = l * (1 - LogFast(1 + l) / (2 + l));
+  T e = ExpFast(x);
+  w = x < static_cast<T>(-4) ? e : w;
+  for (unsigned int i = 0; i < iter; ++i)
+    w = w * (1 + x - LogFast(w)) / (1 + w);
+  return w;
+}
+
+// Newton steps of the kProxFast operators in precision T.
+template <typename T>
+__DEVICE__ inline unsigned int LambertWIter();
+template <>
+__DEVICE__ inline unsigned int LambertWIter<double>() { return 3u; }
+template <>
+__DEVICE__ inline unsigned int LambertWIter<float>() { return 2u; }
+
+template <typename T>
+__DEVICE__ inline unsigned int LogisticIter();
+template <>
+__DEVICE__ inline unsigned int LogisticIter<double>() { return 4u; }
+template <>
+__DEVICE__ inline unsigned int LogisticIter<float>() { return 3u; }
 }  // namespace
 
 // Proximal operator definitions.
@@ -213,7 +603,10 @@ __DEVICE__ inline T CubicSolve(T p, T q, T r) {
 // where Prox{.} is the proximal operator with penalty parameter rho.
 template <typename T>
 __DEVICE__ inline T ProxAbs(T v, T rho) {
-  return MaxPos(v - 1 / rho) - MaxNeg(v + 1 / rho);
+  // MaxPos(v - 1 / rho) - MaxNeg(v + 1 / rho), written with selects that
+  // the compiler can vectorize.
+  T v_lo = v - 1 / rho, v_hi = v + 1 / rho;
+  return (v_lo > 0 ? v_lo : 0) + (v_hi < 0 ? v_hi : 0);
 }
 
 template <typename T>
@@ -260,16 +653,40 @@ __DEVICE__ inline T ProxIndLe0(T v, T rho) {
   return v >= 0 ? 0 : v;
 }
 
+// Initial guess for ProxLogistic based on piecewise approximation.
 template <typename T>
-__DEVICE__ inline T ProxLogistic(T v, T rho) {
-  // Initial guess based on piecewise approximation.
-  T x;
+__DEVICE__ inline T ProxLogisticGuess(T v, T rho) {
   if (v < static_cast<T>(-2.5))
-    x = v;
+    return v;
   else if (v > static_cast<T>(2.5) + 1 / rho)
-    x = v - 1 / rho;
+    return v - 1 / rho;
   else
-    x = (rho * v - static_cast<T>(0.5)) / (static_cast<T>(0.2) + rho);
+    return (rho * v - static_cast<T>(0.5)) / (static_cast<T>(0.2) + rho);
+}
+
+// Guarded method for ProxLogistic from x, with the root in [l, u]. Adds the
+// number of steps to *iter.
+template <typename T>
+__DEVICE__ inline T ProxLogisticGuarded(T v, T rho, T x, T l, T u,
+                                        unsigned int *iter) {
+  for (unsigned int i = 0; u - l > Tol<T>() && i < 100; ++i) {
+    T g_rho = 1 / (rho * (1 + Exp(-x))) + (x - v);
+    if (g_rho > 0) {
+      l = Max(l, x - g_rho);
+      u = x;
+    } else {
+      u = Min(u, x - g_rho);
+      l = x;
+    }
+    x = (u + l) / 2;
+    ++*iter;
+  }
+  return x;
+}
+
+template <typename T>
+__DEVICE__ inline T ProxLogistic(T v, T rho) {
+  T x = ProxLogisticGuess(v, rho);
 
   // Newton iteration.
   T l = v - 1 / rho, u = v;
@@ -287,18 +704,8 @@ __DEVICE__ inline T ProxLogistic(T v, T rho) {
   }
 
   // Guarded method if not converged.
-  for (unsigned int i = 0; u - l > Tol<T>() && i < 100; ++i) {
-    T g_rho = 1 / (rho * (1 + Exp(-x))) + (x - v);
-    if (g_rho > 0) {
-      l = Max(l, x - g_rho);
-      u = x;
-    } else {
-      u = Min(u, x - g_rho);
-      l = x;
-    }
-    x = (u + l) / 2;
-  }
-  return x;
+  unsigned int iter = 0;
+  return ProxLogisticGuarded(v, rho, x, l, u, &iter);
 }
 
 template <typename T>
@@ -309,8 +716,8 @@ __DEVICE__ inline T ProxMaxNeg0(T v, T rho) {
 
 template <typename T>
 __DEVICE__ inline T ProxMaxPos0(T v, T rho) {
-  T z = v <= 0 ? v : 0;
-  return v >= 1 / rho ? v - 1 / rho : z;
+  T z = v <= 0 ? v : 0, v_lo = v - 1 / rho;
+  return v_lo >= 0 ? v_lo : z;
 }
 
 template <typename T>
@@ -334,23 +741,68 @@ __DEVICE__ inline T ProxZero(T v, T rho) {
   return v;
 }
 
-// Evaluates the proximal operator of f.
+// Accuracy of the operators of kExp, kLogistic and kNegEntr.
+//   kProxAccurate: ProxExp, ProxLogistic and ProxNegEntr above. Lambert W
+//                  is evaluated in double precision, also for float.
+//   kProxFast:     ProxExpFast, ProxLogisticFast and ProxNegEntrFast below,
+//                  which run a fixed number of Newton steps in precision T
+//                  without branches, so that they vectorize. They agree
+//                  with the above to a few ulp of T, except for Lambert W
+//                  of e^x with x < 0, whose relative error grows like
+//                  |x| ulp.
+enum ProxAccuracy { kProxAccurate, kProxFast };
+
+template <typename T>
+__DEVICE__ __FORCE_INLINE__ T ProxNegEntrFast(T v, T rho) {
+  return LambertWExpFast((rho * v - 1) + LogFast(rho), LambertWIter<T>()) /
+      rho;
+}
+
 template <typename T>
-__DEVICE__ inline T ProxEval(const FunctionObj<T> &f_obj, T v, T rho) {
-  const T a = f_obj.a, b = f_obj.b, c = f_obj.c, d = f_obj.d, e = f_obj.e;
-  v = a * (v * rho - d) / (e + rho) - b;
-  rho = (e + rho) / (c * a * a);
-  switch (f_obj.h) {
+__DEVICE__ __FORCE_INLINE__ T ProxExpFast(T v, T rho) {
+  return v - LambertWExpFast(v - LogFast(rho), LambertWIter<T>());
+}
+
+template <typename T>
+__DEVICE__ __FORCE_INLINE__ T ProxLogisticFast(T v, T rho) {
+  // Since prox(v) = -prox(1 / rho - v), v is reflected so that the root x
+  // is <= 0, where the objective is convex. There e^x >= 1 / (1 + e^-x), so
+  // that the root of e^x + rho * (x - v), i.e. ProxExp, is a lower bound,
+  // as is v - 1 / rho. Newton from there converges quadratically.
+  T r = 1 / rho;
+  bool flip = v > r / 2;
+  v = flip ? r - v : v;
+  T l = v - r, u = v;
+  T x = v - LambertWExpFast(v + LogFast(r), 1u);
+  x = x > l ? x : l;
+  for (unsigned int i = 0; i < LogisticIter<T>(); ++i) {
+    T inv_ex = 1 / (1 + ExpFast(-x));
+    T f = inv_ex + rho * (x - v);
+    T g = inv_ex * (1 - inv_ex) + rho;
+    x = x - f / g;
+    x = x < u ? x : u;
+    x = x > l ? x : l;
+  }
+  return flip ? -x : x;
+}
+
+// Evaluates the proximal operator of h with penalty parameter rho, with the
+// kProxFast operators if fast is set.
+template <typename T>
+__DEVICE__ __FORCE_INLINE__ T ProxAs(Function h, T v, T rho, bool fast) {
+  switch (h) {
     case kAbs: v = ProxAbs(v, rho); break;
-    case kNegEntr: v = ProxNegEntr(v, rho); break;
-    case kExp: v = ProxExp(v, rho); break;
+    case kNegEntr:
+      v = fast ? ProxNegEntrFast(v, rho) : ProxNegEntr(v, rho); break;
+    case kExp: v = fast ? ProxExpFast(v, rho) : ProxExp(v, rho); break;
     case kHuber: v = ProxHuber(v, rho); break;
     case kIdentity: v = ProxIdentity(v, rho); break;
     case kIndBox01: v = ProxIndBox01(v, rho); break;
     case kIndEq0: v = ProxIndEq0(v, rho); break;
     case kIndGe0: v = ProxIndGe0(v, rho); break;
     case kIndLe0: v = ProxIndLe0(v, rho); break;
-    case kLogistic: v = ProxLogistic(v, rho); break;
+    case kLogistic:
+      v = fast ? ProxLogisticFast(v, rho) : ProxLogistic(v, rho); break;
     case kMaxNeg0: v = ProxMaxNeg0(v, rho); break;
     case kMaxPos0: v = ProxMaxPos0(v, rho); break;
     case kNegLog: v = ProxNegLog(v, rho); break;
@@ -358,9 +810,124 @@ __DEVICE__ inline T ProxEval(const FunctionObj<T> &f_obj, T v, T rho) {
     case kSquare: v = ProxSquare(v, rho); break;
     case kZero: default: v = ProxZero(v, rho); break;
   }
+  return v;
+}
+
+// Evaluates the proximal operator of c * h(a * x - b) + d * x + e * x ^ 2,
+// with the kProxFast operators if fast is set. If h and fast are
+// compile-time constants the switch folds away, see ProxEvalRun.
+template <typename T>
+__DEVICE__ __FORCE_INLINE__ T ProxEvalAs(Function h, T a, T b, T c, T d, T e,
+                                         T v, T rho, bool fast = false) {
+  v = a * (v * rho - d) / (e + rho) - b;
+  rho = (e + rho) / (c * a * a);
+  return (ProxAs(h, v, rho, fast) + b) / a;
+}
+
+// Warm-started operators of kExp, kLogistic, kNegEntr and kRecipr. They
+// take a guess x0 of the result, e.g. the prox at a nearby v, start the
+// iteration of the operator above from it if it passes a sanity check and
+// from the usual guess otherwise, and add the number of inner iterations
+// to *iter. With x0 = NaN they always use the usual guess.
+template <typename T>
+__DEVICE__ inline T ProxNegEntrWarm(T v, T rho, T x0, unsigned int *iter) {
+  return static_cast<T>(
+      LambertWExpWarm<double>(static_cast<double>((rho * v - 1) + Log(rho)),
+          static_cast<double>(rho * x0), iter)) / rho;
+}
+
+template <typename T>
+__DEVICE__ inline T ProxExpWarm(T v, T rho, T x0, unsigned int *iter) {
+  return v - static_cast<T>(
+      LambertWExpWarm<double>(static_cast<double>(v - Log(rho)),
+          static_cast<double>(v - x0), iter));
+}
+
+// Unlike ProxLogistic, Newton's method stops once the error after its
+// step is below Tol, and the guarded method only runs if that takes more
+// than 5 steps. The error after a step dx is at most max |f''| dx^2 / (2
+// rho), and |f''| <= |s''(x)| + |dx| / 8 over the step for the sigmoid s.
+template <typename T>
+__DEVICE__ inline T ProxLogisticWarm(T v, T rho, T x0, unsigned int *iter) {
+  T l = v - 1 / rho, u = v;
+  T x = x0 >= l && x0 <= u ? x0 : ProxLogisticGuess(v, rho);
+  for (unsigned int i = 0; i < 5; ++i) {
+    T inv_ex = 1 / (1 + Exp(-x));
+    T f = inv_ex + rho * (x - v);
+    T g = inv_ex * (1 - inv_ex) + rho;
+    if (f < 0)
+      l = x;
+    else
+      u = x;
+    T dx = f / g;
+    x = Max(Min(x - dx, u), l);
+    ++*iter;
+    T f2 = Abs((g - rho) * (1 - 2 * inv_ex)) + Abs(dx) / 8;
+    if (f2 * dx * dx <= 2 * rho * Tol<T>())
+      return x;
+  }
+  return ProxLogisticGuarded(v, rho, x, l, u, iter);
+}
+
+// Newton's method for the root of f(x) = x^2 (x - v) - 1 / rho, which for
+// v >= 0 lies in [v, v + rho^(-1/3)], where f is increasing and convex.
+// Starts from the upper end if x0 is not in the bracket, stops once the
+// error after a step dx, about (f''(x) + 3 |dx|) dx^2 / (2 f'(x)), is below
+// Epsilon relative to x, as CubicSolve is accurate to rounding, and falls
+// back to CubicSolve if that takes more than 10 steps.
+template <typename T>
+__DEVICE__ inline T ProxReciprWarm(T v, T rho, T x0, unsigned int *iter) {
+  v = Max(v, static_cast<T>(0));
+  T l = v, u = v + Pow(rho, static_cast<T>(-1) / 3);
+  T x = x0 > l && x0 <= u ? x0 : u;
+  for (unsigned int i = 0; i < 10; ++i) {
+    T f = x * x * (x - v) - 1 / rho;
+    T g = x * (3 * x - 2 * v);
+    if (f < 0)
+      l = x;
+    else
+      u = x;
+    T dx = f / g;
+    x = Max(Min(x - dx, u), l);
+    ++*iter;
+    T f2 = 6 * x - 2 * v + 3 * Abs(dx);
+    if (f2 * dx * dx <= 2 * g * Epsilon<T>() * x)
+      return x;
+  }
+  return CubicSolve(-v, static_cast<T>(0), -1 / rho);
+}
+
+// Whether h has a warm-started operator.
+__DEVICE__ inline bool HasWarmProx(Function h) {
+  return h == kExp || h == kLogistic || h == kNegEntr || h == kRecipr;
+}
+
+// ProxEvalAs, with the warm-started operators for the functions that have
+// one. x0 is a guess of the result in the same scale as the result.
+template <typename T>
+__DEVICE__ inline T ProxEvalWarmAs(Function h, T a, T b, T c, T d, T e, T v,
+                                   T rho, T x0, unsigned int *iter) {
+  if (!HasWarmProx(h))
+    return ProxEvalAs(h, a, b, c, d, e, v, rho);
+  v = a * (v * rho - d) / (e + rho) - b;
+  rho = (e + rho) / (c * a * a);
+  x0 = a * x0 - b;
+  switch (h) {
+    case kNegEntr: v = ProxNegEntrWarm(v, rho, x0, iter); break;
+    case kExp: v = ProxExpWarm(v, rho, x0, iter); break;
+    case kLogistic: v = ProxLogisticWarm(v, rho, x0, iter); break;
+    case kRecipr: default: v = ProxReciprWarm(v, rho, x0, iter); break;
+  }
   return (v + b) / a;
 }
 
+// Evaluates the proximal operator of f.
+template <typename T>
+__DEVICE__ inline T ProxEval(const FunctionObj<T> &f_obj, T v, T rho) {
+  return ProxEvalAs(f_obj.h, f_obj.a, f_obj.b, f_obj.c, f_obj.d, f_obj.e, v,
+      rho);
+}
+
 
 // Function definitions.
 //
@@ -453,13 +1020,10 @@ __DEVICE__ inline T FuncZero(T x) {
   return 0;
 }
 
-// Evaluates the function f.
+// Evaluates the function h.
 template <typename T>
-__DEVICE__ inline T FuncEval(const FunctionObj<T> &f_obj, T x) {
-  T dx = f_obj.d * x;
-  T ex = f_obj.e * x * x / 2;
-  x = f_obj.a * x - f_obj.b;
-  switch (f_obj.h) {
+__DEVICE__ inline T FuncAs(Function h, T x) {
+  switch (h) {
     case kAbs: x = FuncAbs(x); break;
     case kNegEntr: x = FuncNegEntr(x); break;
     case kExp: x = FuncExp(x); break;
@@ -477,7 +1041,16 @@ __DEVICE__ inline T FuncEval(const FunctionObj<T> &f_obj, T x) {
     case kSquare: x = FuncSquare(x); break;
     case kZero: default: x = FuncZero(x); break;
   }
-  return f_obj.c * x + dx + ex;
+  return x;
+}
+
+// Evaluates the function f.
+template <typename T>
+__DEVICE__ inline T FuncEval(const FunctionObj<T> &f_obj, T x) {
+  T dx = f_obj.d * x;
+  T ex = f_obj.e * x * x / 2;
+  x = f_obj.a * x - f_obj.b;
+  return f_obj.c * FuncAs(f_obj.h, x) + dx + ex;
 }
 
 
@@ -596,15 +1169,10 @@ __DEVICE__ inline T ProjSubgradZero(T v, T x) {
   return static_cast<T>(0.);
 }
 
-// Evaluates the projection of v onto the subgradient of f at x.
+// Evaluates the projection of v onto the subgradient of h at axb.
 template <typename T>
-__DEVICE__ inline T ProjSubgradEval(const FunctionObj<T> &f_obj, T v, T x) {
-  const T a = f_obj.a, b = f_obj.b, c = f_obj.c, d = f_obj.d, e = f_obj.e;
-  if (a == static_cast<T>(0.) || c == static_cast<T>(0.))
-    return d + e * x;
-  v = static_cast<T>(1.) / (a * c) * (v - d - e * x);
-  T axb = a * x - b;
-  switch (f_obj.h) {
+__DEVICE__ inline T ProjSubgradAs(Function h, T v, T axb) {
+  switch (h) {
     case kAbs: v = ProjSubgradAbs(v, axb); break;
     case kNegEntr: v = ProjSubgradNegEntr(v, axb); break;
     case kExp: v = ProjSubgradExp(v, axb); break;
@@ -622,7 +1190,18 @@ __DEVICE__ inline T ProjSubgradEval(const FunctionObj<T> &f_obj, T v, T x) {
     case kSquare: v = ProjSubgradSquare(v, axb); break;
     case kZero: default: v = ProjSubgradZero(v, axb); break;
   }
-  return a * c * v + d + e * x;
+  return v;
+}
+
+// Evaluates the projection of v onto the subgradient of f at x.
+template <typename T>
+__DEVICE__ inline T ProjSubgradEval(const FunctionObj<T> &f_obj, T v, T x) {
+  const T a = f_obj.a, b = f_obj.b, c = f_obj.c, d = f_obj.d, e = f_obj.e;
+  if (a == static_cast<T>(0.) || c == static_cast<T>(0.))
+    return d + e * x;
+  v = static_cast<T>(1.) / (a * c) * (v - d - e * x);
+  T axb = a * x - b;
+  return a * c * ProjSubgradAs(f_obj.h, v, axb) + d + e * x;
 }
 
 
@@ -642,6 +1221,312 @@ void ProxEval(const std::vector<FunctionObj<T> > &f_obj, T rho, const T *x_in,
     x_out[i] = ProxEval(f_obj[i], x_in[i], rho);
 }
 
+// Range [begin, end) of a vector of function objects that all have the
+// function h, or if uniform is false, a range of mixed functions.
+struct FunctionRun {
+  size_t begin, end;
+  Function h;
+  bool uniform;
+};
+
+// Runs shorter than this are merged into mixed ranges.
+const size_t kMinRunLength = 256;
+
+// Function of element i of a vector of function objects.
+template <typename T>
+inline Function FunctionAt(const std::vector<FunctionObj<T> > &f_obj,
+                           size_t i) {
+  return f_obj[i].h;
+}
+
+template <typename T>
+inline Function FunctionAt(const FunctionVector<T> &f_obj, size_t i) {
+  return f_obj.h.size() == 1 ? f_obj.h[0] : f_obj.h[i];
+}
+
+// Splits f_obj into maximal runs of the same function, reusing the storage
+// of runs. Call once per problem and pass the result to ProxEval.
+template <typename F>
+void FunctionRuns(const F &f_obj, std::vector<FunctionRun> *runs) {
+  runs->clear();
+  for (size_t i = 0; i < f_obj.size(); ) {
+    Function h = FunctionAt(f_obj, i);
+    size_t end = i + 1;
+    while (end < f_obj.size() && FunctionAt(f_obj, end) == h)
+      ++end;
+    FunctionRun run = { i, end, h, end - i >= kMinRunLength };
+    if (!run.uniform && !runs->empty() && !runs->back().uniform)
+      runs->back().end = end;
+    else
+      runs->push_back(run);
+    i = end;
+  }
+}
+
+template <typename T>
+void FunctionRuns(const FunctionVector<T> &f_obj,
+                  std::vector<FunctionRun> *runs) {
+  runs->clear();
+  if (f_obj.h.size() == 1 && f_obj.size() > 0) {
+    FunctionRun run = { 0, f_obj.size(), f_obj.h[0], true };
+    runs->push_back(run);
+  } else {
+    FunctionRuns<FunctionVector<T> >(f_obj, runs);
+  }
+}
+
+// Elements per block of ProxEvalRun.
+const size_t kProxBlock = 64;
+
+// Copies the parameters of elements [begin, begin + len) to arrays. The
+// function is only copied if h is not null.
+template <typename T>
+void LoadParams(const std::vector<FunctionObj<T> > &f_obj, size_t begin,
+                size_t len, Function *h, T *a, T *b, T *c, T *d, T *e) {
+  for (size_t l = 0; l < len; ++l) {
+    const FunctionObj<T> &f = f_obj[begin + l];
+    if (h)
+      h[l] = f.h;
+    a[l] = f.a;
+    b[l] = f.b;
+    c[l] = f.c;
+    d[l] = f.d;
+    e[l] = f.e;
+  }
+}
+
+template <typename V>
+void LoadParam(const std::vector<V> &p, size_t begin, size_t len, V *x) {
+  if (p.size() == 1)
+    std::fill(x, x + len, p[0]);
+  else
+    std::copy(p.begin() + begin, p.begin() + begin + len, x);
+}
+
+template <typename T>
+void LoadParams(const FunctionVector<T> &f_obj, size_t begin, size_t len,
+                Function *h, T *a, T *b, T *c, T *d, T *e) {
+  if (h)
+    LoadParam(f_obj.h, begin, len, h);
+  LoadParam(f_obj.a, begin, len, a);
+  LoadParam(f_obj.b, begin, len, b);
+  LoadParam(f_obj.c, begin, len, c);
+  LoadParam(f_obj.d, begin, len, d);
+  LoadParam(f_obj.e, begin, len, e);
+}
+
+// Prox of elements [begin, end), which all have the function h. The
+// parameters of each block are first copied to contiguous arrays, and as h
+// is known at compile time the loop over the block has no branch on the
+// function, so that the closed-form and kProxFast operators vectorize.
+template <Function h, bool fast = false, typename T, typename F>
+void ProxEvalRun(const F &f_obj, size_t begin, size_t end, T rho,
+                 const T *x_in, T *x_out) {
+  size_t num_blocks = (end - begin + kProxBlock - 1) / kProxBlock;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t k = 0; k < num_blocks; ++k) {
+    size_t i = begin + k * kProxBlock;
+    size_t len = std::min(kProxBlock, end - i);
+    T a[kProxBlock], b[kProxBlock], c[kProxBlock], d[kProxBlock],
+        e[kProxBlock];
+    LoadParams(f_obj, i, len, static_cast<Function*>(0), a, b, c, d, e);
+    const T *v = x_in + i;
+    T *x = x_out + i;
+    for (size_t l = 0; l < len; ++l)
+      x[l] = ProxEvalAs(h, a[l], b[l], c[l], d[l], e[l], v[l], rho, fast);
+  }
+}
+
+// Same as ProxEvalRun, for elements with mixed functions.
+template <typename T, typename F>
+void ProxEvalMixed(const F &f_obj, size_t begin, size_t end, T rho,
+                   const T *x_in, T *x_out, bool fast) {
+  size_t num_blocks = (end - begin + kProxBlock - 1) / kProxBlock;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t k = 0; k < num_blocks; ++k) {
+    size_t i = begin + k * kProxBlock;
+    size_t len = std::min(kProxBlock, end - i);
+    Function h[kProxBlock];
+    T a[kProxBlock], b[kProxBlock], c[kProxBlock], d[kProxBlock],
+        e[kProxBlock];
+    LoadParams(f_obj, i, len, h, a, b, c, d, e);
+    const T *v = x_in + i;
+    T *x = x_out + i;
+    for (size_t l = 0; l < len; ++l)
+      x[l] = ProxEvalAs(h[l], a[l], b[l], c[l], d[l], e[l], v[l], rho,
+          fast);
+  }
+}
+
+// Elements evaluated with a warm-started operator (see HasWarmProx) and
+// their total number of inner iterations.
+struct ProxStats {
+  size_t elements, iters;
+};
+
+// Same as ProxEvalMixed, with ProxEvalWarmAs seeded with the values in
+// x_out if seed is set. Adds to *stats.
+template <typename T, typename F>
+void ProxEvalWarmMixed(const F &f_obj, size_t begin, size_t end, T rho,
+                       const T *x_in, T *x_out, bool seed, ProxStats *stats) {
+  const T kNoGuess = std::numeric_limits<T>::quiet_NaN();
+  size_t num_blocks = (end - begin + kProxBlock - 1) / kProxBlock;
+  size_t elements = 0, iters = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:elements,iters)
+#endif
+  for (size_t k = 0; k < num_blocks; ++k) {
+    size_t i = begin + k * kProxBlock;
+    size_t len = std::min(kProxBlock, end - i);
+    Function h[kProxBlock];
+    T a[kProxBlock], b[kProxBlock], c[kProxBlock], d[kProxBlock],
+        e[kProxBlock];
+    LoadParams(f_obj, i, len, h, a, b, c, d, e);
+    const T *v = x_in + i;
+    T *x = x_out + i;
+    for (size_t l = 0; l < len; ++l) {
+      unsigned int iter = 0;
+      x[l] = ProxEvalWarmAs(h[l], a[l], b[l], c[l], d[l], e[l], v[l], rho,
+          seed ? x[l] : kNoGuess, &iter);
+      elements += HasWarmProx(h[l]) ? 1 : 0;
+      iters += iter;
+    }
+  }
+  stats->elements += elements;
+  stats->iters += iters;
+}
+
+// Prox of the uniform run, dispatched to a loop specialized for its
+// function and accuracy.
+template <typename T, typename F>
+void ProxEvalRunDispatch(const F &f_obj, const FunctionRun &run, T rho,
+                         const T *x_in, T *x_out, bool fast) {
+  size_t i = run.begin, end = run.end;
+  switch (run.h) {
+    case kAbs: ProxEvalRun<kAbs>(f_obj, i, end, rho, x_in, x_out); break;
+    case kNegEntr:
+      if (fast)
+        ProxEvalRun<kNegEntr, true>(f_obj, i, end, rho, x_in, x_out);
+      else
+        ProxEvalRun<kNegEntr>(f_obj, i, end, rho, x_in, x_out);
+      break;
+    case kExp:
+      if (fast)
+        ProxEvalRun<kExp, true>(f_obj, i, end, rho, x_in, x_out);
+      else
+        ProxEvalRun<kExp>(f_obj, i, end, rho, x_in, x_out);
+      break;
+    case kHuber:
+      ProxEvalRun<kHuber>(f_obj, i, end, rho, x_in, x_out); break;
+    case kIdentity:
+      ProxEvalRun<kIdentity>(f_obj, i, end, rho, x_in, x_out); break;
+    case kIndBox01:
+      ProxEvalRun<kIndBox01>(f_obj, i, end, rho, x_in, x_out); break;
+    case kIndEq0:
+      ProxEvalRun<kIndEq0>(f_obj, i, end, rho, x_in, x_out); break;
+    case kIndGe0:
+      ProxEvalRun<kIndGe0>(f_obj, i, end, rho, x_in, x_out); break;
+    case kIndLe0:
+      ProxEvalRun<kIndLe0>(f_obj, i, end, rho, x_in, x_out); break;
+    case kLogistic:
+      if (fast)
+        ProxEvalRun<kLogistic, true>(f_obj, i, end, rho, x_in, x_out);
+      else
+        ProxEvalRun<kLogistic>(f_obj, i, end, rho, x_in, x_out);
+      break;
+    case kMaxNeg0:
+      ProxEvalRun<kMaxNeg0>(f_obj, i, end, rho, x_in, x_out); break;
+    case kMaxPos0:
+      ProxEvalRun<kMaxPos0>(f_obj, i, end, rho, x_in, x_out); break;
+    case kNegLog:
+      ProxEvalRun<kNegLog>(f_obj, i, end, rho, x_in, x_out); break;
+    case kRecipr:
+      ProxEvalRun<kRecipr>(f_obj, i, end, rho, x_in, x_out); break;
+    case kSquare:
+      ProxEvalRun<kSquare>(f_obj, i, end, rho, x_in, x_out); break;
+    case kZero: default:
+      ProxEvalRun<kZero>(f_obj, i, end, rho, x_in, x_out); break;
+  }
+}
+
+// Prox of f_obj, a std::vector<FunctionObj<T> > or a FunctionVector<T>,
+// with each run of runs = FunctionRuns(f_obj) dispatched to a loop
+// specialized for its function and accuracy.
+template <typename T, typename F>
+void ProxEvalRuns(const F &f_obj, const std::vector<FunctionRun> &runs,
+                  T rho, const T *x_in, T *x_out, ProxAccuracy accuracy) {
+  bool fast = accuracy == kProxFast;
+  for (size_t k = 0; k < runs.size(); ++k) {
+    if (runs[k].uniform)
+      ProxEvalRunDispatch(f_obj, runs[k], rho, x_in, x_out, fast);
+    else
+      ProxEvalMixed(f_obj, runs[k].begin, runs[k].end, rho, x_in, x_out,
+          fast);
+  }
+}
+
+// Same as ProxEvalRuns with kProxAccurate, except that runs of functions
+// with a warm-started operator start its iteration from the values in
+// x_out if seed is set, e.g. the result of the previous ADMM iteration.
+// Adds their number of elements and inner iterations to *stats.
+template <typename T, typename F>
+void ProxEvalWarmRuns(const F &f_obj, const std::vector<FunctionRun> &runs,
+                      T rho, const T *x_in, T *x_out, bool seed,
+                      ProxStats *stats) {
+  for (size_t k = 0; k < runs.size(); ++k) {
+    if (runs[k].uniform && !HasWarmProx(runs[k].h))
+      ProxEvalRunDispatch(f_obj, runs[k], rho, x_in, x_out, false);
+    else
+      ProxEvalWarmMixed(f_obj, runs[k].begin, runs[k].end, rho, x_in, x_out,
+          seed, stats);
+  }
+}
+
+// Same as ProxEval above, with each run of runs = FunctionRuns(f_obj)
+// dispatched to a loop specialized for its function.
+template <typename T>
+void ProxEval(const std::vector<FunctionObj<T> > &f_obj,
+              const std::vector<FunctionRun> &runs, T rho, const T *x_in,
+              T *x_out, ProxAccuracy accuracy = kProxAccurate) {
+  ProxEvalRuns(f_obj, runs, rho, x_in, x_out, accuracy);
+}
+
+// Evaluates the proximal operator Prox{f_obj[i]}(x_in[i]) -> x_out[i].
+template <typename T>
+void ProxEval(const FunctionVector<T> &f_obj, T rho, const T *x_in,
+              T *x_out) {
+  ProxEvalMixed(f_obj, 0, f_obj.size(), rho, x_in, x_out, false);
+}
+
+template <typename T>
+void ProxEval(const FunctionVector<T> &f_obj,
+              const std::vector<FunctionRun> &runs, T rho, const T *x_in,
+              T *x_out, ProxAccuracy accuracy = kProxAccurate) {
+  ProxEvalRuns(f_obj, runs, rho, x_in, x_out, accuracy);
+}
+
+// Same as ProxEval above with kProxAccurate, where the iterative operators
+// of kExp, kLogistic, kNegEntr and kRecipr start from the values in x_out
+// if seed is set, e.g. x_out of the previous call for a nearby x_in. Adds
+// the number of such elements and their inner iterations to *stats.
+template <typename T>
+void ProxEvalWarm(const std::vector<FunctionObj<T> > &f_obj,
+                  const std::vector<FunctionRun> &runs, T rho,
+                  const T *x_in, T *x_out, bool seed, ProxStats *stats) {
+  ProxEvalWarmRuns(f_obj, runs, rho, x_in, x_out, seed, stats);
+}
+
+template <typename T>
+void ProxEvalWarm(const FunctionVector<T> &f_obj,
+                  const std::vector<FunctionRun> &runs, T rho,
+                  const T *x_in, T *x_out, bool seed, ProxStats *stats) {
+  ProxEvalWarmRuns(f_obj, runs, rho, x_in, x_out, seed, stats);
+}
+
 
 // Returns evalution of Sum_i Func{f_obj[i]}(x_in[i]).
 //
@@ -677,6 +1562,246 @@ void ProjSubgradEval(const std::vector<FunctionObj<T> > &f_obj, const T *x_in,
     v_out[i] = ProjSubgradEval(f_obj[i], v_in[i], x_in[i]);
 }
 
+template <typename T>
+T FuncEval(const FunctionVector<T> &f_obj, const T* x_in) {
+  T sum = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:sum)
+#endif
+  for (size_t i = 0; i < f_obj.size(); ++i)
+    sum += FuncEval(f_obj[i], x_in[i]);
+  return sum;
+}
+
+template <typename T>
+void ProjSubgradEval(const FunctionVector<T> &f_obj, const T *x_in,
+                     const T *v_in, T *v_out) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < f_obj.size(); ++i)
+    v_out[i] = ProjSubgradEval(f_obj[i], v_in[i], x_in[i]);
+}
+
+// Parameters of a block of elements of a FunctionVector. Only those not in
+// fixed are loaded, the others read as their defaults.
+template <typename T, unsigned int fixed>
+struct StaticParams {
+  T a[kProxBlock], b[kProxBlock], c[kProxBlock], d[kProxBlock],
+      e[kProxBlock];
+
+  void Load(const FunctionVector<T> &f_obj, size_t begin, size_t len) {
+    if (!(fixed & kParamA))
+      LoadParam(f_obj.a, begin, len, a);
+    if (!(fixed & kParamB))
+      LoadParam(f_obj.b, begin, len, b);
+    if (!(fixed & kParamC))
+      LoadParam(f_obj.c, begin, len, c);
+    if (!(fixed & kParamD))
+      LoadParam(f_obj.d, begin, len, d);
+    if (!(fixed & kParamE))
+      LoadParam(f_obj.e, begin, len, e);
+  }
+
+  T A(size_t l) const { return (fixed & kParamA) ? 1 : a[l]; }
+  T B(size_t l) const { return (fixed & kParamB) ? 0 : b[l]; }
+  T C(size_t l) const { return (fixed & kParamC) ? 1 : c[l]; }
+  T D(size_t l) const { return (fixed & kParamD) ? 0 : d[l]; }
+  T E(size_t l) const { return (fixed & kParamE) ? 0 : e[l]; }
+};
+
+// ProxEvalAs, FuncEval and ProjSubgradEval for the function h, where the
+// parameters in fixed keep their defaults. Since x + 0 and (x * rho) / rho
+// are not folded to x in IEEE arithmetic, the terms of fixed parameters are
+// dropped explicitly rather than left to constant folding, so that results
+// may differ from the generic path in the last bits.
+template <Function h, unsigned int fixed, bool fast, typename T>
+__FORCE_INLINE__ T ProxEvalStaticAs(T a, T b, T c, T d, T e, T v, T rho) {
+  const bool kShift = !(fixed & kParamD) || !(fixed & kParamE);
+  T s = (fixed & kParamE) ? rho : e + rho;
+  if (kShift)
+    v = (fixed & kParamD) ? v * rho : v * rho - d;
+  if (!(fixed & kParamA))
+    v = a * v;
+  if (kShift)
+    v = v / s;
+  if (!(fixed & kParamB))
+    v = v - b;
+  if (fixed & kParamA)
+    rho = (fixed & kParamC) ? s : s / c;
+  else
+    rho = s / ((fixed & kParamC) ? a * a : c * a * a);
+  v = ProxAs(h, v, rho, fast);
+  if (!(fixed & kParamB))
+    v = v + b;
+  return (fixed & kParamA) ? v : v / a;
+}
+
+template <Function h, unsigned int fixed, typename T>
+__FORCE_INLINE__ T FuncEvalStaticAs(T a, T b, T c, T d, T e, T x) {
+  T y = (fixed & kParamA) ? x : a * x;
+  if (!(fixed & kParamB))
+    y = y - b;
+  y = FuncAs(h, y);
+  if (!(fixed & kParamC))
+    y = c * y;
+  if (!(fixed & kParamD))
+    y = y + d * x;
+  if (!(fixed & kParamE))
+    y = y + e * x * x / 2;
+  return y;
+}
+
+template <Function h, unsigned int fixed, typename T>
+__FORCE_INLINE__ T ProjSubgradEvalStaticAs(T a, T b, T c, T d, T e, T v,
+                                           T x) {
+  const bool kScale = !(fixed & kParamA) || !(fixed & kParamC);
+  const bool kLinear = !(fixed & kParamD) || !(fixed & kParamE);
+  T lin = 0;
+  if (fixed & kParamD)
+    lin = (fixed & kParamE) ? lin : e * x;
+  else
+    lin = (fixed & kParamE) ? d : d + e * x;
+  if (kScale && (a == static_cast<T>(0.) || c == static_cast<T>(0.)))
+    return lin;
+  T ac = a * c;
+  if (kLinear)
+    v = v - lin;
+  if (kScale)
+    v = static_cast<T>(1.) / ac * v;
+  T axb = (fixed & kParamA) ? x : a * x;
+  if (!(fixed & kParamB))
+    axb = axb - b;
+  v = ProjSubgradAs(h, v, axb);
+  if (kScale)
+    v = ac * v;
+  return kLinear ? v + lin : v;
+}
+
+// Prox of f_obj, whose elements all have the function h and whose
+// parameters in fixed keep their defaults, in blocks as in ProxEvalRun.
+template <Function h, unsigned int fixed, bool fast, typename T>
+void ProxEvalStaticRun(const FunctionVector<T> &f_obj, T rho, const T *x_in,
+                       T *x_out) {
+  size_t num_blocks = (f_obj.size() + kProxBlock - 1) / kProxBlock;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t k = 0; k < num_blocks; ++k) {
+    size_t i = k * kProxBlock;
+    size_t len = std::min(kProxBlock, f_obj.size() - i);
+    StaticParams<T, fixed> p;
+    p.Load(f_obj, i, len);
+    const T *v = x_in + i;
+    T *x = x_out + i;
+    for (size_t l = 0; l < len; ++l)
+      x[l] = ProxEvalStaticAs<h, fixed, fast>(p.A(l), p.B(l), p.C(l),
+          p.D(l), p.E(l), v[l], rho);
+  }
+}
+
+// Same as ProxEval of a FunctionVector, for f_obj as in ProxEvalStaticRun,
+// e.g. a FunctionStatic<T, h, fixed>.
+template <Function h, unsigned int fixed, typename T>
+void ProxEvalStatic(const FunctionVector<T> &f_obj, T rho, const T *x_in,
+                    T *x_out, ProxAccuracy accuracy = kProxAccurate) {
+  if (accuracy == kProxFast)
+    ProxEvalStaticRun<h, fixed, true>(f_obj, rho, x_in, x_out);
+  else
+    ProxEvalStaticRun<h, fixed, false>(f_obj, rho, x_in, x_out);
+}
+
+// Same, with the arguments of ProxEvalRuns. runs is not used.
+template <Function h, unsigned int fixed, typename T>
+void ProxEvalStatic(const FunctionVector<T> &f_obj,
+                    const std::vector<FunctionRun> &runs, T rho,
+                    const T *x_in, T *x_out, ProxAccuracy accuracy) {
+  ProxEvalStatic<h, fixed>(f_obj, rho, x_in, x_out, accuracy);
+}
+
+template <Function h, unsigned int fixed, typename T>
+T FuncEvalStatic(const FunctionVector<T> &f_obj, const T *x_in) {
+  size_t num_blocks = (f_obj.size() + kProxBlock - 1) / kProxBlock;
+  T sum = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:sum)
+#endif
+  for (size_t k = 0; k < num_blocks; ++k) {
+    size_t i = k * kProxBlock;
+    size_t len = std::min(kProxBlock, f_obj.size() - i);
+    StaticParams<T, fixed> p;
+    p.Load(f_obj, i, len);
+    const T *x = x_in + i;
+    for (size_t l = 0; l < len; ++l)
+      sum += FuncEvalStaticAs<h, fixed>(p.A(l), p.B(l), p.C(l), p.D(l),
+          p.E(l), x[l]);
+  }
+  return sum;
+}
+
+template <Function h, unsigned int fixed, typename T>
+void ProjSubgradEvalStatic(const FunctionVector<T> &f_obj, const T *x_in,
+                           const T *v_in, T *v_out) {
+  size_t num_blocks = (f_obj.size() + kProxBlock - 1) / kProxBlock;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t k = 0; k < num_blocks; ++k) {
+    size_t i = k * kProxBlock;
+    size_t len = std::min(kProxBlock, f_obj.size() - i);
+    StaticParams<T, fixed> p;
+    p.Load(f_obj, i, len);
+    for (size_t l = 0; l < len; ++l)
+      v_out[i + l] = ProjSubgradEvalStaticAs<h, fixed>(p.A(l), p.B(l),
+          p.C(l), p.D(l), p.E(l), v_in[i + l], x_in[i + l]);
+  }
+}
+
+template <typename T, Function h, unsigned int fixed>
+void ProxEval(const FunctionStatic<T, h, fixed> &f_obj, T rho, const T *x_in,
+              T *x_out, ProxAccuracy accuracy = kProxAccurate) {
+  ProxEvalStatic<h, fixed>(f_obj, rho, x_in, x_out, accuracy);
+}
+
+template <typename T, Function h, unsigned int fixed>
+T FuncEval(const FunctionStatic<T, h, fixed> &f_obj, const T *x_in) {
+  return FuncEvalStatic<h, fixed>(f_obj, x_in);
+}
+
+template <typename T, Function h, unsigned int fixed>
+void ProjSubgradEval(const FunctionStatic<T, h, fixed> &f_obj, const T *x_in,
+                     const T *v_in, T *v_out) {
+  ProjSubgradEvalStatic<h, fixed>(f_obj, x_in, v_in, v_out);
+}
+
+// Loops over a FunctionVector that Pogs runs on its scaled copy of f and
+// g: the prox, given the runs of the copy, the sum of the functions and
+// the projection onto the subgradient.
+template <typename T>
+struct FunctionOps {
+  void (*prox)(const FunctionVector<T>&, const std::vector<FunctionRun>&, T,
+               const T*, T*, ProxAccuracy);
+  T (*func)(const FunctionVector<T>&, const T*);
+  void (*proj_subgrad)(const FunctionVector<T>&, const T*, const T*, T*);
+};
+
+// FunctionOps with the prox dispatched by runs.
+template <typename T>
+FunctionOps<T> RunOps() {
+  FunctionOps<T> ops = { ProxEvalRuns<T, FunctionVector<T> >, FuncEval<T>,
+                         ProjSubgradEval<T> };
+  return ops;
+}
+
+// FunctionOps specialized for h and fixed, see ProxEvalStatic.
+template <typename T, Function h, unsigned int fixed>
+FunctionOps<T> StaticOps() {
+  FunctionOps<T> ops = { ProxEvalStatic<h, fixed, T>,
+                         FuncEvalStatic<h, fixed, T>,
+                         ProjSubgradEvalStatic<h, fixed, T> };
+  return ops;
+}
+
 #ifdef __CUDACC__
 template <typename T>
 struct ProxEvalF : thrust::binary_function<FunctionObj<T>, T, T> {
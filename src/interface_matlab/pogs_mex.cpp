@@ -50,12 +50,13 @@ inline T GetVal(const void *pr, size_t idx, mxClassID id) {
 }
 
 // Populates a vector of function objects from a matlab struct
-// containing the fields (f, a, b, c, d). The latter 4 are optional,
-// while f is required. Each field (if present) is a vector of length n.
+// containing the fields (h, a, b, c, d, e). The latter 5 are optional,
+// while h is required. Each field (if present) is a scalar, which is stored
+// once and applies to every element, or a vector of length n.
 template <typename T>
 int PopulateFunctionObj(const char fn_name[], const mxArray *f_mex,
                         unsigned int field_idx, unsigned int n,
-                        std::vector<FunctionObj<T> > *f_pogs) {
+                        FunctionVector<T> *f_pogs) {
   const unsigned int kNumParam = 6u;
   char alpha[] = "h\0a\0b\0c\0d\0e\0";
 
@@ -70,31 +71,32 @@ int PopulateFunctionObj(const char fn_name[], const mxArray *f_mex,
     return 1;
   }
 
-  void *param_data[kNumParam] = {0};
-  mxClassID param_id[kNumParam];
-  mxArray *param_arr[kNumParam];
-  Function func_param;
-  T real_params[] = { static_cast<T>(1), static_cast<T>(0), static_cast<T>(1),
-                      static_cast<T>(0), static_cast<T>(0) };
-
-  // Find index and pointer to data of (h, a, b, c, d) in struct if present.
-#pragma unroll
+  // Defaults, reusing the storage of f_pogs.
+  f_pogs->resize(n);
+  std::vector<T> *real_params[] = { &f_pogs->a, &f_pogs->b, &f_pogs->c,
+                                    &f_pogs->d, &f_pogs->e };
+  const T kDefault[] = { static_cast<T>(1), static_cast<T>(0),
+                         static_cast<T>(1), static_cast<T>(0),
+                         static_cast<T>(0) };
+  f_pogs->h.assign(1, kZero);
+  for (unsigned int i = 1; i < kNumParam; ++i)
+    real_params[i - 1]->assign(1, kDefault[i - 1]);
+
+  // Copy (h, a, b, c, d, e) from the struct if present. Scalars are not
+  // repeated.
   for (unsigned int i = 0; i < kNumParam; ++i) {
     if (param_idx[i] != -1) {
       mxArray *arr = mxGetFieldByNumber(f_mex, field_idx, param_idx[i]);
-      param_data[i] = static_cast<T*>(mxGetData(arr));
-      param_id[i] = mxGetClassID(arr);
+      const void *param_data = mxGetData(arr);
+      mxClassID param_id = mxGetClassID(arr);
 
-      // If parameter is scalar, then repeat it.
       if (mxGetM(arr) == 1 && mxGetN(arr) == 1) {
-        if (i == 0) {
-          func_param = GetVal<Function>(param_data[i], 0, param_id[i]);
-        } else {
-          real_params[i - 1] = GetVal<T>(param_data[i], 0, param_id[i]);
-        }
-        param_data[i] = 0;
+        if (i == 0)
+          f_pogs->h.assign(1, GetVal<Function>(param_data, 0, param_id));
+        else
+          real_params[i - 1]->assign(1, GetVal<T>(param_data, 0, param_id));
       } else if (i > 0 && mxIsEmpty(arr)) {
-        param_data[i] = 0;
+        continue;
       } else if (i == 0 && mxIsEmpty(arr)) {
         mexErrMsgIdAndTxt("MATLAB:pogs:missingParam",
             "Field %s.h is required.", fn_name);
@@ -104,27 +106,19 @@ int PopulateFunctionObj(const char fn_name[], const mxArray *f_mex,
         mexErrMsgIdAndTxt("MATLAB:pogs:dimensionMismatch",
             "Dimensions of %s.%s and A must match.", fn_name, &alpha[2 * i]);
         return 1;
+      } else if (i == 0) {
+        f_pogs->h.resize(n);
+        for (unsigned int k = 0; k < n; ++k)
+          f_pogs->h[k] = GetVal<Function>(param_data, k, param_id);
+      } else {
+        std::vector<T> &p = *real_params[i - 1];
+        p.resize(n);
+        for (unsigned int k = 0; k < n; ++k)
+          p[k] = GetVal<T>(param_data, k, param_id);
       }
     }
   }
-
-  // Populate f_pogs.
-#pragma omp parellel for
-  for (unsigned int i = 0; i < n; ++i) {
-#pragma unroll
-    for (unsigned int j = 0; j < kNumParam; ++j) {
-      if (param_data[j] != 0) {
-        if (j == 0) {
-          func_param = GetVal<Function>(param_data[j], i, param_id[j]);
-        } else {
-          real_params[j - 1] = GetVal<T>(param_data[j], i, param_id[j]);
-        }
-      }
-    }
-
-    f_pogs->push_back(FunctionObj<T>(func_param, real_params[0], real_params[1],
-        real_params[2], real_params[3], real_params[4]));
-  }
+  f_pogs->CheckConsts();
   return 0;
 }
 
@@ -227,11 +221,8 @@ void SolverWrapDn(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   // Initialize Pogs data structure
   pogs::MatrixDense<T> A_('c', m, n, reinterpret_cast<T*>(mxGetData(prhs[0])));
   pogs::PogsDirect<T, pogs::MatrixDense<T> > pogs_data(A_);
-  std::vector<FunctionObj<T> > f;
-  std::vector<FunctionObj<T> > g;
-
-  f.reserve(m);
-  g.reserve(n);
+  FunctionVector<T> f;
+  FunctionVector<T> g;
 
   int err = 0;
 
@@ -244,8 +235,6 @@ void SolverWrapDn(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   for (unsigned int i = 0; i < num_obj && !err; ++i) {
 
     // Populate function objects.
-    f.clear();
-    g.clear();
     err = PopulateFunctionObj("f", prhs[1], i, m, &f);
     if (err)
       break;
@@ -296,11 +285,8 @@ void SolverWrapSp(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   // Initialize Pogs data structure
   pogs::MatrixSparse<T> A('c', m, n, nnz, val, col_ptr, row_ind);
   pogs::PogsIndirect<T, pogs::MatrixSparse<T> > pogs_data(A);
-  std::vector<FunctionObj<T> > f;
-  std::vector<FunctionObj<T> > g;
-
-  f.reserve(m);
-  g.reserve(n);
+  FunctionVector<T> f;
+  FunctionVector<T> g;
 
   int err = 0;
 
@@ -312,8 +298,6 @@ void SolverWrapSp(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
 
   for (unsigned int i = 0; i < num_obj && !err; ++i) {
     // Populate function objects.
-    f.clear();
-    g.clear();
     err = PopulateFunctionObj("f", prhs[1], i, m, &f);
     if (err)
       break;
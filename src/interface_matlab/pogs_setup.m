@@ -32,7 +32,7 @@ if ~opt_gpu
   unix(sprintf('make cpu -C .. IFLAGS="-D__MEX__ %s"', omp_flag));
   eval(sprintf(['mex -largeArrayDims -I../include ' ...
                 'CFLAGS=''\\$CFLAGS -O3 %s'' ' ...
-                'CXXFLAGS=''\\$CXXFLAGS -std=c++11'' ' ...
+                'CXXFLAGS=''\\$CXXFLAGS -std=c++11 -fno-trapping-math'' ' ...
                 'LDFLAGS=''\\$LDFLAGS %s'' ' ...
                 'pogs_mex.cpp blas2cblas.cpp ../build/pogs.a -lmwblas  ' ...
                 '-output pogs'], omp_flag, omp_flag))
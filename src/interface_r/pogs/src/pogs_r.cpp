@@ -21,52 +21,38 @@ SEXP getListElement(SEXP list, const char *str) {
   return elmt;
 }
 
+// Populates f_pogs from the list f with elements (h, a, b, c, d, e), each a
+// scalar, which is stored once and applies to every element, or a vector of
+// length n. Missing elements take their default values.
 void PopulateFunctionObj(SEXP f, unsigned int n,
-                         std::vector<FunctionObj<double> > *f_pogs) {
+                         FunctionVector<double> *f_pogs) {
   const unsigned int kNumParam = 6u;
   char alpha[] = "h\0a\0b\0c\0d\0e\0";
+  const double kDefault[] = {1.0, 0.0, 1.0, 0.0, 0.0};
 
-  SEXP param_data[kNumParam] = {R_NilValue};
-  #pragma unroll
-  for (unsigned int i = 0; i < kNumParam; ++i)
-    param_data[i] = getListElement(f, &alpha[i * 2]);
+  // Defaults, reusing the storage of f_pogs.
+  f_pogs->resize(n);
+  std::vector<double> *real_params[] = { &f_pogs->a, &f_pogs->b, &f_pogs->c,
+                                         &f_pogs->d, &f_pogs->e };
+  f_pogs->h.assign(1, kZero);
+  for (unsigned int i = 1; i < kNumParam; ++i)
+    real_params[i - 1]->assign(1, kDefault[i - 1]);
 
-  Function func_param;
-  double real_params[] = {1.0, 0.0, 1.0, 0.0, 0.0};
-
-  // Find index and pointer to data of (h, a, b, c, d, e) in struct if present.
-  #pragma unroll
   for (unsigned int i = 0; i < kNumParam; ++i) {
-    if (param_data[i] != R_NilValue) {
-      // If parameter is scalar, then repeat it.
-      if (length(param_data[i]) == 1) {
-        if (i == 0) {
-          func_param = static_cast<Function>(REAL(param_data[i])[0]);
-        } else {
-          real_params[i - 1] = REAL(param_data[i])[0];
-        }
-        param_data[i] = R_NilValue;
-      }
-    }
-  }
-
-  // Populate f_pogs.
-  #pragma omp parellel for
-  for (unsigned int i = 0; i < n; ++i) {
-    #pragma unroll
-    for (unsigned int j = 0; j < kNumParam; ++j) {
-      if (param_data[j] != R_NilValue) {
-        if (j == 0) {
-          func_param = static_cast<Function>(REAL(param_data[j])[i]);
-        } else {
-          real_params[j - 1] = REAL(param_data[j])[i];
-        }
-      }
+    SEXP param_data = getListElement(f, &alpha[i * 2]);
+    if (param_data == R_NilValue)
+      continue;
+    // Scalars are not repeated.
+    unsigned int len = length(param_data) == 1 ? 1 : n;
+    if (i == 0) {
+      f_pogs->h.resize(len);
+      for (unsigned int k = 0; k < len; ++k)
+        f_pogs->h[k] = static_cast<Function>(REAL(param_data)[k]);
+    } else {
+      real_params[i - 1]->assign(REAL(param_data), REAL(param_data) + len);
     }
-
-    f_pogs->push_back(FunctionObj<double>(func_param, real_params[0],
-         real_params[1], real_params[2], real_params[3], real_params[4]));
   }
+  f_pogs->CheckConsts();
 }
 
 template <typename T, typename M, typename P>
@@ -115,10 +101,7 @@ void SolverWrap(SEXP A, SEXP fin, SEXP gin, SEXP params, SEXP x, SEXP y,
 
   // Initialize Pogs data structure
   pogs::PogsDirect<T, pogs::MatrixDense<T> > pogs_data(A_dense);
-  std::vector<FunctionObj<T> > f, g;
-
-  f.reserve(m);
-  g.reserve(n);
+  FunctionVector<T> f, g;
 
   // Populate parameters.
   PopulateParams(params, &pogs_data);
@@ -128,8 +111,6 @@ void SolverWrap(SEXP A, SEXP fin, SEXP gin, SEXP params, SEXP x, SEXP y,
 
   for (unsigned int i = 0; i < num_obj && !err; ++i) {
     // Populate function objects.
-    f.clear();
-    g.clear();
     PopulateFunctionObj(VECTOR_ELT(fin, i), m, &f);
     PopulateFunctionObj(VECTOR_ELT(gin, i), n, &g);
 